@@ -0,0 +1,146 @@
+#include "answer_cache.h"
+
+/**
+ * @brief Заменяет отрицательный ноль положительным
+ * @param value Число
+ * @return Число, у которого -0.0 заменён на 0.0
+ */
+static double canonical(double value) {
+    return value == 0 ? 0.0 : value;
+}
+
+/**
+ * @brief Сравнивает ключи кэша
+ * @param other Другой ключ
+ * @return true если ключи равны
+ */
+bool answer_cache::key::operator==(const key& other) const {
+    return this->kind == other.kind and this->p == other.p and this->q == other.q;
+}
+
+/**
+ * @brief Хеш ключа кэша для QCache
+ * @param value Ключ
+ * @param seed Зерно хеширования
+ * @return Хеш
+ */
+size_t qHash(const answer_cache::key& value, size_t seed) {
+    return qHashMulti(seed, value.kind, value.p, value.q);
+}
+
+/**
+ * @brief Конструктор кэша
+ * @param capacity Максимальное количество ответов
+ */
+answer_cache::answer_cache(qsizetype capacity) : entries(capacity) {}
+
+/**
+ * @brief Приводит уравнение к ключу кэша
+ * @param equation Уравнение
+ * @return Нормализованный ключ
+ *
+ * Квадратное уравнение с a = 0 нормализуется как линейное bx + c = 0,
+ * линейное с нулевым коэффициентом при x - как вырожденное.
+ */
+answer_cache::key answer_cache::normalize(const equation_request& equation) {
+    double a = equation.a;
+    double b = equation.b;
+    double c = equation.c;
+    if (equation.type == equation_type::LINEAR) {
+        // ax + b = 0 -> запись в форме 0x² + ax + b
+        c = b;
+        b = a;
+        a = 0;
+    }
+
+    key result;
+    if (a != 0) {
+        result.kind = 2;
+        result.p = canonical(b / a);
+        result.q = canonical(c / a);
+    }
+    else if (b != 0) {
+        result.kind = 1;
+        result.p = canonical(c / b);
+    }
+    else {
+        result.kind = 0;
+        result.p = c == 0 ? 0.0 : 1.0;
+    }
+    return result;
+}
+
+/**
+ * @brief Ищет ответ на уравнение
+ * @param equation Уравнение
+ * @param answer Найденный ответ
+ * @return true если ответ найден
+ */
+bool answer_cache::lookup(const equation_request& equation, QString& answer) {
+    const QString* found = this->entries.object(normalize(equation));
+    if (found == nullptr) {
+        this->miss_count++;
+        return false;
+    }
+    this->hit_count++;
+    answer = *found;
+    return true;
+}
+
+/**
+ * @brief Сохраняет ответ на уравнение
+ * @param equation Уравнение
+ * @param answer Ответ в формате сервера
+ */
+void answer_cache::insert(const equation_request& equation, const QString& answer) {
+    this->entries.insert(normalize(equation), new QString(answer));
+}
+
+/**
+ * @brief Изменяет максимальное количество ответов
+ * @param capacity Новая ёмкость
+ */
+void answer_cache::set_capacity(qsizetype capacity) {
+    this->entries.setMaxCost(capacity);
+}
+
+/**
+ * @brief Возвращает максимальное количество ответов
+ * @return Ёмкость кэша
+ */
+qsizetype answer_cache::capacity() const {
+    return this->entries.maxCost();
+}
+
+/**
+ * @brief Возвращает текущее количество ответов
+ * @return Размер кэша
+ */
+qsizetype answer_cache::size() const {
+    return this->entries.size();
+}
+
+/**
+ * @brief Возвращает количество попаданий
+ * @return Счётчик попаданий
+ */
+quint64 answer_cache::hits() const {
+    return this->hit_count;
+}
+
+/**
+ * @brief Возвращает количество промахов
+ * @return Счётчик промахов
+ */
+quint64 answer_cache::misses() const {
+    return this->miss_count;
+}
+
+/**
+ * @brief Удаляет все ответы и обнуляет счётчики
+ */
+void answer_cache::clear() {
+    this->entries.clear();
+    this->hit_count = 0;
+    this->miss_count = 0;
+}
@@ -0,0 +1,107 @@
+#ifndef ANSWER_CACHE_H
+#define ANSWER_CACHE_H
+
+#include <QCache>
+#include <QHashFunctions>
+#include <QString>
+#include "equation.h"
+
+/**
+ * @brief LRU-кэш ответов на уравнения
+ *
+ * Ключ - нормализованный набор коэффициентов: уравнение делится
+ * на старший коэффициент, поэтому 2x² - 8x + 8 и x² - 4x + 4 дают
+ * один и тот же ключ. Ответ при таком масштабировании не меняется.
+ */
+class answer_cache
+{
+public:
+    /**
+     * @brief Нормализованное уравнение
+     */
+    struct key {
+        quint8 kind = 0; ///< 0 - вырожденное, 1 - линейное, 2 - квадратное
+        double p = 0;    ///< b/a (для вырожденного - признак c == 0)
+        double q = 0;    ///< c/a для квадратного уравнения
+
+        bool operator==(const key& other) const;
+    };
+
+    /**
+     * @brief Конструктор кэша
+     * @param capacity Максимальное количество ответов
+     */
+    explicit answer_cache(qsizetype capacity = 4096);
+
+    /**
+     * @brief Приводит уравнение к ключу кэша
+     * @param equation Уравнение
+     * @return Нормализованный ключ
+     */
+    static key normalize(const equation_request& equation);
+
+    /**
+     * @brief Ищет ответ на уравнение
+     * @param equation Уравнение
+     * @param answer Найденный ответ
+     * @return true если ответ найден
+     */
+    bool lookup(const equation_request& equation, QString& answer);
+
+    /**
+     * @brief Сохраняет ответ на уравнение
+     * @param equation Уравнение
+     * @param answer Ответ в формате сервера
+     */
+    void insert(const equation_request& equation, const QString& answer);
+
+    /**
+     * @brief Изменяет максимальное количество ответов
+     * @param capacity Новая ёмкость (лишние давно не использованные ответы удаляются)
+     */
+    void set_capacity(qsizetype capacity);
+
+    /**
+     * @brief Возвращает максимальное количество ответов
+     * @return Ёмкость кэша
+     */
+    qsizetype capacity() const;
+
+    /**
+     * @brief Возвращает текущее количество ответов
+     * @return Размер кэша
+     */
+    qsizetype size() const;
+
+    /**
+     * @brief Возвращает количество попаданий
+     * @return Счётчик попаданий
+     */
+    quint64 hits() const;
+
+    /**
+     * @brief Возвращает количество промахов
+     * @return Счётчик промахов
+     */
+    quint64 misses() const;
+
+    /**
+     * @brief Удаляет все ответы и обнуляет счётчики
+     */
+    void clear();
+
+private:
+    QCache<key, QString> entries; ///< Ответы в порядке использования
+    quint64 hit_count = 0;        ///< Счётчик попаданий
+    quint64 miss_count = 0;       ///< Счётчик промахов
+};
+
+/**
+ * @brief Хеш ключа кэша для QCache
+ * @param value Ключ
+ * @param seed Зерно хеширования
+ * @return Хеш
+ */
+size_t qHash(const answer_cache::key& value, size_t seed = 0);
+
+#endif // ANSWER_CACHE_H
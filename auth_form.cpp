@@ -1,6 +1,7 @@
 #include "auth_form.h"
 #include "ui_auth_form.h"
 #include "clients_func.h"
+#include "logger.h"
 #include "client_main_window.h"
 #include "reset_password.h"
 #include "reg_form.h"
@@ -48,7 +49,7 @@ auth_form::~auth_form()
     disconnect(this->client, &Client::auth_ok, this, &auth_form::auth_ok);
     disconnect(this->client, &Client::auth_error, this, &auth_form::auth_error);
 
-    qDebug() << "Вызвался деструктор окна авторизации";
+    LOG_DEBUG("ui", "Вызвался деструктор окна авторизации");
     delete ui;
 }
 
@@ -82,7 +83,7 @@ void auth_form::on_pushButton_login_clicked()
         QString password = ui->lineEdit_password->text();
         QString hash_password = clients_func::create_hash(password);
 
-        qDebug() << "Расшифрованный хэш: " << hash_password;
+        LOG_DEBUG("ui", "Расшифрованный хэш: " + hash_password);
 
         // Формируем и отправляем данные на сервер
         QString final_data = QString("login|%1$%2").arg(login).arg(hash_password);
@@ -117,7 +118,7 @@ void auth_form::auth_ok() {
     // Сохраняем данные, если отмечен чекбокс "Запомнить меня"
     if (ui->checkBox_remamber_me->isChecked()) {
         this->write_info_in_cache();
-        qDebug() << "Данные записаны";
+        LOG_DEBUG("ui", "Данные записаны");
     }
 
     this->hide();
@@ -165,10 +166,10 @@ void auth_form::write_info_in_cache()
 
     // Создаем директорию для кэша, если она не существует
     if (std::filesystem::create_directory("./cache")) {
-        qDebug() << "Директория успешно создана";
+        LOG_DEBUG("ui", "Директория успешно создана");
     }
     else {
-        qDebug() << "Ошибка! Вероятно директория уже существует";
+        LOG_DEBUG("ui", "Директория кэша уже существует");
     }
 
     // Записываем данные в файл
@@ -197,7 +198,7 @@ void auth_form::fill_from_json() {
     json_file.open("cache/auth_data.json", std::ios_base::in);
 
     if (json_file.is_open()) {
-        qDebug() << "json file успешно открыт";
+        LOG_DEBUG("ui", "json file успешно открыт");
         std::string line_from_file;
 
         while (std::getline(json_file, line_from_file)) {
@@ -205,10 +206,10 @@ void auth_form::fill_from_json() {
         }
 
         json_data = QJsonDocument::fromJson(QByteArray(lines_from_file.c_str()));
-        qDebug().noquote() << json_data.toJson();
+        LOG_DEBUG("ui", json_data.toJson(QJsonDocument::Compact));
     }
     else {
-        qDebug() << "Ошибка при открытии json-файла";
+        LOG_WARNING("ui", "Ошибка при открытии json-файла");
         return;
     }
 
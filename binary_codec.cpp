@@ -0,0 +1,311 @@
+#include "binary_codec.h"
+#include <QLocale>
+#include <QtEndian>
+#include <cstring>
+
+/// Состояния ответа в двоичном формате
+#define STATUS_ROOTS 0
+#define STATUS_NO_SOLUTION 1
+#define STATUS_INFINITY_SOLUTIONS 2
+#define STATUS_ERROR 3
+
+/// Вид уравнения в двоичном формате
+#define KIND_LINEAR 0
+#define KIND_QUADRATIC 1
+
+/**
+ * @brief Последовательное чтение полей двоичного сообщения
+ *
+ * Выход за конец сообщения не читает память, а устанавливает failed.
+ */
+struct binary_reader
+{
+    QByteArrayView data;  ///< Сообщение
+    qsizetype offset = 0; ///< Позиция следующего поля
+    bool failed = false;  ///< Сообщение короче ожидаемого
+
+    /**
+     * @brief Проверяет, что в сообщении осталось не меньше size байт
+     * @param size Размер поля
+     * @return true если поле можно прочитать
+     */
+    bool has(qsizetype size) {
+        if (this->failed or this->data.size() - this->offset < size)
+            this->failed = true;
+        return !this->failed;
+    }
+
+    /**
+     * @brief Читает байт
+     * @return Значение байта (0 при выходе за конец сообщения)
+     */
+    quint8 u8() {
+        if (!this->has(1))
+            return 0;
+        return quint8(this->data[this->offset++]);
+    }
+
+    /**
+     * @brief Читает беззнаковое 32-битное целое
+     * @return Значение (0 при выходе за конец сообщения)
+     */
+    quint32 u32() {
+        if (!this->has(4))
+            return 0;
+        quint32 value = qFromLittleEndian<quint32>(this->data.data() + this->offset);
+        this->offset += 4;
+        return value;
+    }
+
+    /**
+     * @brief Читает число с плавающей точкой
+     * @return Значение (0 при выходе за конец сообщения)
+     */
+    double f64() {
+        if (!this->has(8))
+            return 0;
+        quint64 bits = qFromLittleEndian<quint64>(this->data.data() + this->offset);
+        this->offset += 8;
+        double value;
+        std::memcpy(&value, &bits, sizeof(value));
+        return value;
+    }
+
+    /**
+     * @brief Проверяет, что сообщение прочитано целиком и без ошибок
+     * @return true если сообщение корректно
+     */
+    bool done() const {
+        return !this->failed and this->offset == this->data.size();
+    }
+};
+
+/**
+ * @brief Дописывает беззнаковое 32-битное целое
+ * @param out Буфер
+ * @param value Значение
+ */
+static void append_u32(QByteArray& out, quint32 value) {
+    char bytes[4];
+    qToLittleEndian(value, bytes);
+    out.append(bytes, sizeof(bytes));
+}
+
+/**
+ * @brief Дописывает число с плавающей точкой
+ * @param out Буфер
+ * @param value Значение
+ */
+static void append_f64(QByteArray& out, double value) {
+    quint64 bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    char bytes[8];
+    qToLittleEndian(bits, bytes);
+    out.append(bytes, sizeof(bytes));
+}
+
+/**
+ * @brief Дописывает вид и коэффициенты уравнения
+ * @param out Буфер
+ * @param equation Уравнение
+ */
+static void append_equation(QByteArray& out, const equation_request& equation) {
+    bool quadratic = equation.type == equation_type::QUADRATIC;
+    out.append(char(quadratic ? KIND_QUADRATIC : KIND_LINEAR));
+    append_f64(out, equation.a);
+    append_f64(out, equation.b);
+    if (quadratic)
+        append_f64(out, equation.c);
+}
+
+/**
+ * @brief Читает вид и коэффициенты уравнения
+ * @param reader Сообщение
+ * @param out Уравнение
+ * @return false если вид неизвестен или сообщение короче ожидаемого
+ */
+static bool read_equation(binary_reader& reader, equation_request& out) {
+    quint8 kind = reader.u8();
+    if (kind != KIND_LINEAR and kind != KIND_QUADRATIC)
+        return false;
+    out.type = kind == KIND_QUADRATIC ? equation_type::QUADRATIC : equation_type::LINEAR;
+    out.a = reader.f64();
+    out.b = reader.f64();
+    out.c = kind == KIND_QUADRATIC ? reader.f64() : 0;
+    return !reader.failed;
+}
+
+/**
+ * @brief Дописывает один ответ
+ * @param out Буфер
+ * @param answer Ответ в текстовом формате сервера
+ */
+static void append_answer(QByteArray& out, const QString& answer) {
+    if (answer == "no_solution") {
+        out.append(char(STATUS_NO_SOLUTION)).append(char(0));
+        return;
+    }
+    if (answer == "infinity_solutions") {
+        out.append(char(STATUS_INFINITY_SOLUTIONS)).append(char(0));
+        return;
+    }
+
+    QStringList parts = answer.split('$');
+    double roots[2];
+    bool valid = !answer.isEmpty() and parts.size() <= 2;
+    for (qsizetype i = 0; valid and i < parts.size(); i++)
+        roots[i] = parts[i].toDouble(&valid);
+    if (!valid) {
+        out.append(char(STATUS_ERROR)).append(char(0));
+        return;
+    }
+    out.append(char(STATUS_ROOTS)).append(char(parts.size()));
+    for (qsizetype i = 0; i < parts.size(); i++)
+        append_f64(out, roots[i]);
+}
+
+/**
+ * @brief Читает один ответ
+ * @param reader Сообщение
+ * @return Ответ в текстовом формате сервера; корни - в кратчайшем точном представлении
+ */
+static QString read_answer(binary_reader& reader) {
+    quint8 status = reader.u8();
+    quint8 count = reader.u8();
+    switch (status) {
+    case STATUS_NO_SOLUTION: return "no_solution";
+    case STATUS_INFINITY_SOLUTIONS: return "infinity_solutions";
+    case STATUS_ROOTS: break;
+    default: return "error";
+    }
+    if (count == 0 or count > 2) {
+        reader.failed = true;
+        return "error";
+    }
+
+    QString answer;
+    for (int i = 0; i < count; i++) {
+        if (i != 0)
+            answer += '$';
+        answer += QString::number(reader.f64(), 'g', QLocale::FloatingPointShortest);
+    }
+    return answer;
+}
+
+/**
+ * @brief Проверяет, является ли сообщение двоичным
+ * @param message Содержимое кадра
+ * @return true если сообщение начинается с тега двоичного формата
+ */
+bool binary_codec::is_binary(QByteArrayView message) {
+    return !message.isEmpty() and message[0] >= binary_codec::equation_tag
+           and message[0] <= binary_codec::answer_batch_tag;
+}
+
+/**
+ * @brief Кодирует запрос на решение одного уравнения
+ * @param equation Уравнение
+ * @param id Идентификатор запроса
+ * @param out Буфер, в который дописывается сообщение
+ */
+void binary_codec::encode_equation(const equation_request& equation, quint32 id, QByteArray& out) {
+    out.reserve(out.size() + 30);
+    out.append(binary_codec::equation_tag);
+    append_u32(out, id);
+    append_equation(out, equation);
+}
+
+/**
+ * @brief Кодирует пакет уравнений
+ * @param equations Уравнения
+ * @param positions Позиции уравнений пакета в equations
+ * @param id Идентификатор запроса
+ * @param out Буфер, в который дописывается сообщение
+ */
+void binary_codec::encode_batch(const QList<equation_request>& equations, const QList<qsizetype>& positions,
+                                quint32 id, QByteArray& out) {
+    out.reserve(out.size() + 9 + positions.size() * 25);
+    out.append(binary_codec::batch_tag);
+    append_u32(out, id);
+    append_u32(out, quint32(positions.size()));
+    for (qsizetype position : positions)
+        append_equation(out, equations[position]);
+}
+
+/**
+ * @brief Разбирает двоичный запрос
+ * @param message Сообщение
+ * @param equations Уравнения запроса
+ * @param id Идентификатор запроса
+ * @param batch Устанавливается для пакета
+ * @return false если сообщение повреждено
+ */
+bool binary_codec::decode_request(QByteArrayView message, QList<equation_request>& equations,
+                                  quint32& id, bool& batch) {
+    binary_reader reader{message};
+    char tag = char(reader.u8());
+    if (tag != binary_codec::equation_tag and tag != binary_codec::batch_tag)
+        return false;
+    batch = tag == binary_codec::batch_tag;
+    id = reader.u32();
+
+    quint32 count = batch ? reader.u32() : 1;
+    // Уравнение занимает не меньше 17 байт, поэтому размер не может превышать остаток
+    if (reader.failed or count > quint64(message.size() - reader.offset) / 17)
+        return false;
+    equations.clear();
+    equations.reserve(count);
+    for (quint32 i = 0; i < count; i++) {
+        equation_request equation;
+        if (!read_equation(reader, equation))
+            return false;
+        equations.append(equation);
+    }
+    return reader.done();
+}
+
+/**
+ * @brief Кодирует ответ
+ * @param answers Ответы в текстовом формате сервера
+ * @param id Идентификатор запроса
+ * @param batch true - ответ на пакет
+ * @param out Буфер, в который дописывается сообщение
+ *
+ * Ответ, который не удаётся разобрать как корни, передаётся как ошибка.
+ */
+void binary_codec::encode_answer(const QStringList& answers, quint32 id, bool batch, QByteArray& out) {
+    out.reserve(out.size() + 9 + answers.size() * 18);
+    out.append(batch ? binary_codec::answer_batch_tag : binary_codec::answer_tag);
+    append_u32(out, id);
+    if (batch)
+        append_u32(out, quint32(answers.size()));
+    for (const QString& answer : answers)
+        append_answer(out, answer);
+}
+
+/**
+ * @brief Разбирает двоичный ответ
+ * @param message Сообщение
+ * @param answers Ответы в текстовом формате сервера
+ * @param id Идентификатор запроса
+ * @param batch Устанавливается для ответа на пакет
+ * @return false если сообщение повреждено
+ */
+bool binary_codec::decode_answer(QByteArrayView message, QStringList& answers, quint32& id, bool& batch) {
+    binary_reader reader{message};
+    char tag = char(reader.u8());
+    if (tag != binary_codec::answer_tag and tag != binary_codec::answer_batch_tag)
+        return false;
+    batch = tag == binary_codec::answer_batch_tag;
+    id = reader.u32();
+
+    quint32 count = batch ? reader.u32() : 1;
+    // Ответ занимает не меньше 2 байт
+    if (reader.failed or count > quint64(message.size() - reader.offset) / 2)
+        return false;
+    answers.clear();
+    answers.reserve(count);
+    for (quint32 i = 0; i < count and !reader.failed; i++)
+        answers.append(read_answer(reader));
+    return reader.done();
+}
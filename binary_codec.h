@@ -0,0 +1,102 @@
+#ifndef BINARY_CODEC_H
+#define BINARY_CODEC_H
+
+#include <QByteArray>
+#include <QByteArrayView>
+#include <QList>
+#include <QStringList>
+#include "equation.h"
+
+/**
+ * @brief Двоичный формат запросов и ответов
+ *
+ * Используется, если при hello согласована возможность "binary" (только
+ * вместе с кадрированием "length": двоичное сообщение может содержать
+ * любые байты, в том числе '\n'). Все числа - little-endian, дробные -
+ * IEEE 754 double, поэтому кодирование и разбор сводятся к копированию
+ * памяти, а коэффициенты передаются без потерь на десятичном тексте.
+ *
+ * Первый байт сообщения - тег; текстовые сообщения начинаются с буквы,
+ * поэтому оба формата различаются по первому байту.
+ *
+ * Запрос:
+ * - equation_tag, id (u32), вид (u8: 0 - линейное, 1 - квадратное), a, b[, c];
+ * - batch_tag, id (u32), количество (u32), затем для каждого уравнения
+ *   вид (u8) и коэффициенты.
+ *
+ * Ответ:
+ * - answer_tag, id (u32), ответ;
+ * - answer_batch_tag, id (u32), количество (u32), ответы.
+ *
+ * Ответ: состояние (u8: 0 - корни, 1 - корней нет, 2 - x любое,
+ * 3 - ошибка), количество корней (u8), корни (double).
+ */
+class binary_codec
+{
+private:
+    binary_codec() = delete;                     ///< Запрет создания экземпляров
+    binary_codec(const binary_codec&) = delete;  ///< Запрет копирования
+    ~binary_codec() = delete;                    ///< Запрет удаления
+
+public:
+    static constexpr char equation_tag = '\x01';     ///< Одно уравнение
+    static constexpr char batch_tag = '\x02';        ///< Пакет уравнений
+    static constexpr char answer_tag = '\x03';       ///< Ответ на одно уравнение
+    static constexpr char answer_batch_tag = '\x04'; ///< Ответ на пакет
+
+    /**
+     * @brief Проверяет, является ли сообщение двоичным
+     * @param message Содержимое кадра
+     * @return true если сообщение начинается с тега двоичного формата
+     */
+    static bool is_binary(QByteArrayView message);
+
+    /**
+     * @brief Кодирует запрос на решение одного уравнения
+     * @param equation Уравнение
+     * @param id Идентификатор запроса
+     * @param out Буфер, в который дописывается сообщение
+     */
+    static void encode_equation(const equation_request& equation, quint32 id, QByteArray& out);
+
+    /**
+     * @brief Кодирует пакет уравнений
+     * @param equations Уравнения
+     * @param positions Позиции уравнений пакета в equations
+     * @param id Идентификатор запроса
+     * @param out Буфер, в который дописывается сообщение
+     */
+    static void encode_batch(const QList<equation_request>& equations, const QList<qsizetype>& positions,
+                             quint32 id, QByteArray& out);
+
+    /**
+     * @brief Разбирает двоичный запрос
+     * @param message Сообщение
+     * @param equations Уравнения запроса
+     * @param id Идентификатор запроса
+     * @param batch Устанавливается для пакета
+     * @return false если сообщение повреждено
+     */
+    static bool decode_request(QByteArrayView message, QList<equation_request>& equations, quint32& id, bool& batch);
+
+    /**
+     * @brief Кодирует ответ
+     * @param answers Ответы в текстовом формате сервера ("x1$x2", "no_solution", ...)
+     * @param id Идентификатор запроса
+     * @param batch true - ответ на пакет
+     * @param out Буфер, в который дописывается сообщение
+     */
+    static void encode_answer(const QStringList& answers, quint32 id, bool batch, QByteArray& out);
+
+    /**
+     * @brief Разбирает двоичный ответ
+     * @param message Сообщение
+     * @param answers Ответы в текстовом формате сервера
+     * @param id Идентификатор запроса
+     * @param batch Устанавливается для ответа на пакет
+     * @return false если сообщение повреждено
+     */
+    static bool decode_answer(QByteArrayView message, QStringList& answers, quint32& id, bool& batch);
+};
+
+#endif // BINARY_CODEC_H
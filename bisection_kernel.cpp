@@ -0,0 +1,228 @@
+#include "bisection_kernel.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+#if (defined(__GNUC__) or defined(__clang__)) and (defined(__x86_64__) or defined(__i386__))
+#define BISECTION_KERNEL_AVX2
+#include <immintrin.h>
+#endif
+
+/**
+ * @brief Возвращает лучшую доступную на этом процессоре реализацию
+ * @return Набор инструкций
+ */
+bisection_kernel::isa bisection_kernel::best_available() {
+#ifdef BISECTION_KERNEL_AVX2
+    static const isa detected = __builtin_cpu_supports("avx2") ? isa::AVX2 : isa::SCALAR;
+    return detected;
+#else
+    return isa::SCALAR;
+#endif
+}
+
+/**
+ * @brief Возвращает имя реализации
+ * @param kind Набор инструкций
+ * @return "scalar" или "avx2"
+ */
+const char* bisection_kernel::name(isa kind) {
+    return kind == isa::AVX2 ? "avx2" : "scalar";
+}
+
+/**
+ * @brief Уточняет корни всего пакета
+ * @param data Пакет интервалов
+ * @param tolerance Относительная точность корня
+ * @param max_iterations Максимальное количество делений интервала
+ * @param kind Реализация
+ */
+void bisection_kernel::solve(const batch& data, double tolerance, int max_iterations, isa kind) {
+#ifdef BISECTION_KERNEL_AVX2
+    if (kind == isa::AVX2 and best_available() == isa::AVX2) {
+        bisection_kernel::solve_avx2(data, tolerance, max_iterations);
+        return;
+    }
+#endif
+    bisection_kernel::solve_scalar(data, tolerance, max_iterations);
+}
+
+/**
+ * @brief Уточняет корень одного уравнения
+ * @param a Коэффициент при x²
+ * @param b Коэффициент при x
+ * @param c Свободный член
+ * @param lo Левая граница интервала смены знака
+ * @param hi Правая граница интервала смены знака
+ * @param tolerance Относительная точность корня
+ * @param max_iterations Максимальное количество делений интервала
+ * @return Приближённое значение корня
+ */
+double bisection_kernel::bisect_one(double a, double b, double c, double lo, double hi,
+                                    double tolerance, int max_iterations) {
+    double f_lo = (a * lo + b) * lo + c;
+    if (f_lo == 0)
+        return lo;
+
+    for (int i = 0; i < max_iterations; i++) {
+        double mid = lo + (hi - lo) * 0.5;
+        double f_mid = (a * mid + b) * mid + c;
+        if (f_mid == 0)
+            return mid;
+        if ((f_mid < 0) == (f_lo < 0)) {
+            lo = mid;
+            f_lo = f_mid;
+        }
+        else {
+            hi = mid;
+        }
+        if (hi - lo <= tolerance * std::max(1.0, std::abs(mid)))
+            break;
+    }
+    return lo + (hi - lo) * 0.5;
+}
+
+/**
+ * @brief Скалярная реализация пакетного решения
+ * @param data Пакет интервалов
+ * @param tolerance Относительная точность корня
+ * @param max_iterations Максимальное количество делений интервала
+ */
+void bisection_kernel::solve_scalar(const batch& data, double tolerance, int max_iterations) {
+    for (std::size_t i = 0; i < data.size; i++)
+        data.root[i] = bisection_kernel::bisect_one(data.a[i], data.b[i], data.c[i],
+                                                    data.lo[i], data.hi[i], tolerance, max_iterations);
+}
+
+#ifdef BISECTION_KERNEL_AVX2
+/**
+ * @brief Векторная реализация пакетного решения на AVX2
+ * @param data Пакет интервалов
+ * @param tolerance Относительная точность корня
+ * @param max_iterations Максимальное количество делений интервала
+ *
+ * Состояние 8 дорожек (две группы по 4) хранится в регистрах. Итерации
+ * выполняются, пока хотя бы одна активная дорожка не сошлась; затем
+ * сошедшиеся дорожки записывают корень и загружают следующие уравнения.
+ * Шаг итерации повторяет bisect_one, поэтому результаты совпадают
+ * со скалярной реализацией побитово.
+ */
+__attribute__((target("avx2")))
+void bisection_kernel::solve_avx2(const batch& data, double tolerance, int max_iterations) {
+    constexpr int width = 4;
+    constexpr int groups = 2;
+    constexpr int lanes = width * groups;
+
+    alignas(32) double a[lanes], b[lanes], c[lanes], lo[lanes], hi[lanes], f_lo[lanes], iter[lanes], result[lanes];
+    alignas(32) std::uint64_t active[lanes] = {};
+    std::size_t index[lanes];
+    std::size_t next = 0;
+    int converged[groups] = {0xF, 0xF};
+
+    const __m256d half = _mm256_set1_pd(0.5);
+    const __m256d one = _mm256_set1_pd(1.0);
+    const __m256d zero = _mm256_setzero_pd();
+    const __m256d tol = _mm256_set1_pd(tolerance);
+    const __m256d limit = _mm256_set1_pd(double(max_iterations));
+    const __m256d abs_mask = _mm256_castsi256_pd(_mm256_set1_epi64x(0x7FFFFFFFFFFFFFFFLL));
+
+    while (true) {
+        // Сошедшиеся дорожки записывают корень и получают следующее уравнение
+        bool any_active = false;
+        for (int lane = 0; lane < lanes; lane++) {
+            if (converged[lane / width] & (1 << (lane % width))) {
+                if (active[lane] != 0)
+                    data.root[index[lane]] = result[lane];
+
+                active[lane] = 0;
+                while (next < data.size) {
+                    std::size_t i = next++;
+                    double f = (data.a[i] * data.lo[i] + data.b[i]) * data.lo[i] + data.c[i];
+                    if (f == 0 or max_iterations <= 0) {
+                        data.root[i] = f == 0 ? data.lo[i] : data.lo[i] + (data.hi[i] - data.lo[i]) * 0.5;
+                        continue;
+                    }
+                    a[lane] = data.a[i];
+                    b[lane] = data.b[i];
+                    c[lane] = data.c[i];
+                    lo[lane] = data.lo[i];
+                    hi[lane] = data.hi[i];
+                    f_lo[lane] = f;
+                    iter[lane] = 0;
+                    index[lane] = i;
+                    active[lane] = ~std::uint64_t(0);
+                    break;
+                }
+                if (active[lane] == 0) {
+                    // Пустая дорожка: безопасные значения, результат игнорируется
+                    a[lane] = 0;
+                    b[lane] = 0;
+                    c[lane] = 1;
+                    lo[lane] = 0;
+                    hi[lane] = 1;
+                    f_lo[lane] = 1;
+                    iter[lane] = 0;
+                }
+            }
+            any_active = any_active or active[lane] != 0;
+        }
+        if (!any_active)
+            break;
+
+        __m256d A[groups], B[groups], C[groups], LO[groups], HI[groups], FLO[groups], IT[groups], ACT[groups], RES[groups];
+        for (int g = 0; g < groups; g++) {
+            A[g] = _mm256_load_pd(a + g * width);
+            B[g] = _mm256_load_pd(b + g * width);
+            C[g] = _mm256_load_pd(c + g * width);
+            LO[g] = _mm256_load_pd(lo + g * width);
+            HI[g] = _mm256_load_pd(hi + g * width);
+            FLO[g] = _mm256_load_pd(f_lo + g * width);
+            IT[g] = _mm256_load_pd(iter + g * width);
+            ACT[g] = _mm256_castsi256_pd(_mm256_load_si256(reinterpret_cast<const __m256i*>(active + g * width)));
+            RES[g] = zero;
+        }
+
+        int any_converged = 0;
+        while (any_converged == 0) {
+            for (int g = 0; g < groups; g++) {
+                __m256d mid = _mm256_add_pd(LO[g], _mm256_mul_pd(_mm256_sub_pd(HI[g], LO[g]), half));
+                __m256d f_mid = _mm256_add_pd(_mm256_mul_pd(_mm256_add_pd(_mm256_mul_pd(A[g], mid), B[g]), mid), C[g]);
+
+                // Знаковый бит diff установлен, если знаки f(mid) и f(lo) различны
+                __m256d diff = _mm256_xor_pd(f_mid, FLO[g]);
+                __m256d new_lo = _mm256_blendv_pd(mid, LO[g], diff);
+                FLO[g] = _mm256_blendv_pd(f_mid, FLO[g], diff);
+                HI[g] = _mm256_blendv_pd(HI[g], mid, diff);
+                LO[g] = new_lo;
+                IT[g] = _mm256_add_pd(IT[g], one);
+
+                __m256d exact = _mm256_cmp_pd(f_mid, zero, _CMP_EQ_OQ);
+                __m256d bound = _mm256_mul_pd(tol, _mm256_max_pd(one, _mm256_and_pd(mid, abs_mask)));
+                __m256d done = _mm256_or_pd(exact, _mm256_cmp_pd(_mm256_sub_pd(HI[g], LO[g]), bound, _CMP_LE_OQ));
+                done = _mm256_and_pd(_mm256_or_pd(done, _mm256_cmp_pd(IT[g], limit, _CMP_GE_OQ)), ACT[g]);
+
+                __m256d center = _mm256_add_pd(LO[g], _mm256_mul_pd(_mm256_sub_pd(HI[g], LO[g]), half));
+                RES[g] = _mm256_blendv_pd(center, mid, exact);
+
+                converged[g] = _mm256_movemask_pd(done);
+                any_converged |= converged[g];
+            }
+        }
+
+        for (int g = 0; g < groups; g++) {
+            _mm256_store_pd(lo + g * width, LO[g]);
+            _mm256_store_pd(hi + g * width, HI[g]);
+            _mm256_store_pd(f_lo + g * width, FLO[g]);
+            _mm256_store_pd(iter + g * width, IT[g]);
+            _mm256_store_pd(result + g * width, RES[g]);
+        }
+    }
+}
+#else
+/**
+ * @brief Векторная реализация недоступна на этой платформе
+ */
+void bisection_kernel::solve_avx2(const batch& data, double tolerance, int max_iterations) {
+    bisection_kernel::solve_scalar(data, tolerance, max_iterations);
+}
+#endif
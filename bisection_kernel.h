@@ -0,0 +1,91 @@
+#ifndef BISECTION_KERNEL_H
+#define BISECTION_KERNEL_H
+
+#include <cstddef>
+
+/**
+ * @brief Пакетное уточнение корней ax² + bx + c методом половинного деления
+ *
+ * Работает с коэффициентами в виде структуры массивов (a[], b[], c[],
+ * lo[], hi[]). Векторная реализация на AVX2 обрабатывает по 8 интервалов
+ * (две группы по 4 дорожки); дорожка, уравнение которой сошлось, сразу
+ * получает следующее уравнение, поэтому рано сошедшиеся дорожки не ждут
+ * остальных. Реализация выбирается во время выполнения по возможностям
+ * процессора.
+ */
+class bisection_kernel
+{
+public:
+    /**
+     * @brief Набор инструкций, используемый ядром
+     */
+    enum class isa {
+        SCALAR, ///< Скалярная реализация
+        AVX2,   ///< Векторная реализация на AVX2
+    };
+
+    /**
+     * @brief Входные данные и результат пакета в виде структуры массивов
+     *
+     * На интервале [lo[i]; hi[i]] функция a[i]x² + b[i]x + c[i]
+     * должна менять знак. Корень записывается в root[i].
+     */
+    struct batch {
+        const double* a;  ///< Коэффициенты при x²
+        const double* b;  ///< Коэффициенты при x
+        const double* c;  ///< Свободные члены
+        const double* lo; ///< Левые границы интервалов
+        const double* hi; ///< Правые границы интервалов
+        double* root;     ///< Найденные корни
+        std::size_t size; ///< Количество интервалов
+    };
+
+    /**
+     * @brief Возвращает лучшую доступную на этом процессоре реализацию
+     * @return Набор инструкций
+     */
+    static isa best_available();
+
+    /**
+     * @brief Возвращает имя реализации
+     * @param kind Набор инструкций
+     * @return "scalar" или "avx2"
+     */
+    static const char* name(isa kind);
+
+    /**
+     * @brief Уточняет корни всего пакета
+     * @param data Пакет интервалов
+     * @param tolerance Относительная точность корня
+     * @param max_iterations Максимальное количество делений интервала
+     * @param kind Реализация (по умолчанию - лучшая доступная)
+     */
+    static void solve(const batch& data, double tolerance, int max_iterations, isa kind = best_available());
+
+    /**
+     * @brief Уточняет корень одного уравнения
+     * @param a Коэффициент при x²
+     * @param b Коэффициент при x
+     * @param c Свободный член
+     * @param lo Левая граница интервала смены знака
+     * @param hi Правая граница интервала смены знака
+     * @param tolerance Относительная точность корня
+     * @param max_iterations Максимальное количество делений интервала
+     * @return Приближённое значение корня
+     */
+    static double bisect_one(double a, double b, double c, double lo, double hi,
+                             double tolerance, int max_iterations);
+
+private:
+    /**
+     * @brief Скалярная реализация пакетного решения
+     */
+    static void solve_scalar(const batch& data, double tolerance, int max_iterations);
+
+    /**
+     * @brief Векторная реализация пакетного решения на AVX2
+     */
+    static void solve_avx2(const batch& data, double tolerance, int max_iterations);
+};
+
+#endif // BISECTION_KERNEL_H
@@ -0,0 +1,181 @@
+#include "bisection_solver.h"
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+/**
+ * @brief Конструктор решателя
+ * @param tolerance Относительная точность корня
+ * @param max_iterations Максимальное количество делений интервала
+ */
+bisection_solver::bisection_solver(double tolerance, int max_iterations) :
+    tolerance(tolerance),
+    max_iterations(max_iterations)
+{}
+
+/**
+ * @brief Решает уравнение
+ * @param equation Уравнение
+ * @return Ответ в формате сервера
+ */
+QString bisection_solver::solve(const equation_request& equation) const {
+    double coefficients[3];
+    bracket brackets[2];
+    QString answer;
+    int count = bisection_solver::separate(equation, coefficients, brackets, answer);
+    if (count == 0)
+        return answer;
+
+    double roots[2];
+    for (int i = 0; i < count; i++)
+        roots[i] = this->bisect(coefficients[0], coefficients[1], coefficients[2], brackets[i]);
+    return format_roots(roots, count, this->tolerance);
+}
+
+/**
+ * @brief Решает пакет уравнений
+ * @param equations Уравнения
+ * @param kind Реализация ядра
+ * @return Ответы в формате сервера в порядке уравнений
+ *
+ * Корни всех уравнений отделяются заранее, после чего все интервалы
+ * уточняются одним вызовом ядра над структурой массивов.
+ */
+QStringList bisection_solver::solve_batch(const QList<equation_request>& equations,
+                                          bisection_kernel::isa kind) const {
+    QStringList answers(equations.size());
+    std::vector<int> counts(equations.size());
+    std::vector<double> a, b, c, lo, hi;
+    a.reserve(equations.size() * 2);
+    b.reserve(equations.size() * 2);
+    c.reserve(equations.size() * 2);
+    lo.reserve(equations.size() * 2);
+    hi.reserve(equations.size() * 2);
+
+    for (qsizetype i = 0; i < equations.size(); i++) {
+        double coefficients[3];
+        bracket brackets[2];
+        counts[i] = bisection_solver::separate(equations[i], coefficients, brackets, answers[i]);
+        for (int k = 0; k < counts[i]; k++) {
+            a.push_back(coefficients[0]);
+            b.push_back(coefficients[1]);
+            c.push_back(coefficients[2]);
+            lo.push_back(brackets[k].lo);
+            hi.push_back(brackets[k].hi);
+        }
+    }
+
+    std::vector<double> roots(a.size());
+    bisection_kernel::batch data{a.data(), b.data(), c.data(), lo.data(), hi.data(), roots.data(), roots.size()};
+    bisection_kernel::solve(data, this->tolerance, this->max_iterations, kind);
+
+    const double* root = roots.data();
+    for (qsizetype i = 0; i < equations.size(); i++) {
+        if (counts[i] == 0)
+            continue;
+        answers[i] = format_roots(root, counts[i], this->tolerance);
+        root += counts[i];
+    }
+    return answers;
+}
+
+/**
+ * @brief Отделяет корни уравнения
+ * @param equation Уравнение
+ * @param coefficients Коэффициенты a, b, c приведённого к ax² + bx + c вида
+ * @param brackets Интервалы смены знака (не более двух)
+ * @param answer Готовый ответ, если уточнять корни не требуется
+ * @return Количество интервалов, на которых нужно уточнить корень
+ *
+ * Для квадратного уравнения интервал [-R; R] (R - оценка Коши) делится
+ * вершиной параболы на два интервала смены знака.
+ */
+int bisection_solver::separate(const equation_request& equation, double coefficients[3],
+                               bracket brackets[2], QString& answer) {
+    double a = equation.a;
+    double b = equation.b;
+    double c = equation.c;
+
+    // Квадратное уравнение с нулевым старшим коэффициентом - линейное bx + c = 0
+    if (equation.type == equation_type::LINEAR or a == 0) {
+        double k = equation.type == equation_type::LINEAR ? a : b;
+        double m = equation.type == equation_type::LINEAR ? b : c;
+        if (k == 0) {
+            answer = m == 0 ? infinity_solutions : no_solution;
+            return 0;
+        }
+
+        double bound = std::abs(m / k) + 1;
+        coefficients[0] = 0;
+        coefficients[1] = k;
+        coefficients[2] = m;
+        brackets[0] = {-bound, bound};
+        return 1;
+    }
+
+    double discriminant = b * b - 4 * a * c;
+    if (discriminant < 0) {
+        answer = no_solution;
+        return 0;
+    }
+
+    double vertex = -b / (2 * a);
+    if (discriminant == 0) {
+        // Кратный корень: функция не меняет знак, деление пополам неприменимо
+        answer = format_roots(&vertex, 1);
+        return 0;
+    }
+
+    double bound = 1 + std::max(std::abs(b / a), std::abs(c / a));
+    coefficients[0] = a;
+    coefficients[1] = b;
+    coefficients[2] = c;
+    brackets[0] = {-bound, vertex};
+    brackets[1] = {vertex, bound};
+    return 2;
+}
+
+/**
+ * @brief Находит корень ax² + bx + c на интервале смены знака
+ * @param a Коэффициент при x²
+ * @param b Коэффициент при x
+ * @param c Свободный член
+ * @param interval Интервал, на концах которого функция имеет разные знаки
+ * @return Приближённое значение корня
+ */
+double bisection_solver::bisect(double a, double b, double c, bracket interval) const {
+    return bisection_kernel::bisect_one(a, b, c, interval.lo, interval.hi,
+                                        this->tolerance, this->max_iterations);
+}
+
+/**
+ * @brief Проверяет, содержит ли ответ корни
+ * @param answer Ответ в формате сервера
+ * @return true если ответ - список корней
+ */
+bool bisection_solver::has_roots(const QString& answer) {
+    return answer != "error" and answer != infinity_solutions and answer != no_solution;
+}
+
+/**
+ * @brief Формирует ответ из найденных корней
+ * @param roots Корни
+ * @param count Количество корней (1 или 2)
+ * @param resolution Погрешность корня около нуля; корни не больше неё по модулю выводятся как 0
+ * @return Строка "x1" или "x1$x2" с корнями по возрастанию
+ *
+ * Деление пополам около нуля останавливается на интервале шириной
+ * tolerance (см. bisection_kernel::bisect_one), поэтому корень меньше
+ * этой величины от нуля не отличим. При resolution = 0 заменяется
+ * только отрицательный ноль.
+ */
+QString bisection_solver::format_roots(const double* roots, int count, double resolution) {
+    QString answer;
+    for (int i = 0; i < count; i++) {
+        double root = std::abs(roots[i]) <= resolution ? 0.0 : roots[i];
+        if (i != 0)
+            answer += '$';
+        answer += QString::number(root, 'g', 10);
+    }
+    return answer;
+}
@@ -0,0 +1,96 @@
+#ifndef BISECTION_SOLVER_H
+#define BISECTION_SOLVER_H
+
+#include <QString>
+#include <QStringList>
+#include <QList>
+#include "equation.h"
+#include "bisection_kernel.h"
+
+/**
+ * @brief Локальный решатель уравнений методом половинного деления
+ *
+ * Не зависит от виджетов и сети. Возвращает ответы в том же формате,
+ * что и сервер: "x1$x2", "no_solution" или "infinity_solutions".
+ * Пакеты уравнений решаются векторным ядром bisection_kernel.
+ */
+class bisection_solver
+{
+public:
+    static constexpr const char* no_solution = "no_solution";               ///< Ответ "корней нет"
+    static constexpr const char* infinity_solutions = "infinity_solutions"; ///< Ответ "x - любое число"
+
+    /**
+     * @brief Интервал, на котором функция меняет знак
+     */
+    struct bracket {
+        double lo; ///< Левая граница
+        double hi; ///< Правая граница
+    };
+
+    /**
+     * @brief Конструктор решателя
+     * @param tolerance Относительная точность корня
+     * @param max_iterations Максимальное количество делений интервала
+     */
+    explicit bisection_solver(double tolerance = 1e-12, int max_iterations = 200);
+
+    /**
+     * @brief Решает уравнение
+     * @param equation Уравнение
+     * @return Ответ в формате сервера
+     */
+    QString solve(const equation_request& equation) const;
+
+    /**
+     * @brief Решает пакет уравнений
+     * @param equations Уравнения
+     * @param kind Реализация ядра (по умолчанию - лучшая доступная)
+     * @return Ответы в формате сервера в порядке уравнений
+     */
+    QStringList solve_batch(const QList<equation_request>& equations,
+                            bisection_kernel::isa kind = bisection_kernel::best_available()) const;
+
+    /**
+     * @brief Находит корень ax² + bx + c на интервале смены знака
+     * @param a Коэффициент при x²
+     * @param b Коэффициент при x
+     * @param c Свободный член
+     * @param interval Интервал, на концах которого функция имеет разные знаки
+     * @return Приближённое значение корня
+     */
+    double bisect(double a, double b, double c, bracket interval) const;
+
+    /**
+     * @brief Проверяет, содержит ли ответ корни
+     * @param answer Ответ в формате сервера
+     * @return true если ответ - список корней
+     */
+    static bool has_roots(const QString& answer);
+
+    /**
+     * @brief Формирует ответ из найденных корней
+     * @param roots Корни
+     * @param count Количество корней (1 или 2)
+     * @param resolution Погрешность корня около нуля; корни не больше неё по модулю выводятся как 0
+     * @return Строка "x1" или "x1$x2" с корнями по возрастанию
+     */
+    static QString format_roots(const double* roots, int count, double resolution = 0);
+
+private:
+    /**
+     * @brief Отделяет корни уравнения
+     * @param equation Уравнение
+     * @param coefficients Коэффициенты a, b, c приведённого к ax² + bx + c вида
+     * @param brackets Интервалы смены знака (не более двух)
+     * @param answer Готовый ответ, если уточнять корни не требуется
+     * @return Количество интервалов, на которых нужно уточнить корень
+     */
+    static int separate(const equation_request& equation, double coefficients[3],
+                        bracket brackets[2], QString& answer);
+
+    double tolerance;   ///< Относительная точность корня
+    int max_iterations; ///< Максимальное количество делений интервала
+};
+
+#endif // BISECTION_SOLVER_H
@@ -1,26 +1,99 @@
 #include "client.h"
-#include "clients_func.h"
-#include <QMessageBox>
-#include <QCryptographicHash>
-
-extern QApplication a;
+#include "binary_codec.h"
+#include "equation.h"
+#include "logger.h"
+#include "trace.h"
+#include "network_worker.h"
+#include <QPromise>
+#include <QFutureWatcher>
+#include <QDir>
+#include <QCoreApplication>
+#include <QRandomGenerator>
+#include <QtEndian>
+#include <memory>
+#include <cstring>
 
 /// Инициализация статических членов класса
 Client* Client::p_instance = nullptr;
 Client* SingletonDestroyer::client_connection = nullptr;
-QTcpSocket* SingletonDestroyer::socket = nullptr;
-QTcpSocket* Client::socket = nullptr;
 SingletonDestroyer Client::el = SingletonDestroyer();
-int Client::port = 8080;
+int Client::batch_limit = 4096;
+int Client::inbox_slice = 256;
+int Client::offline_limit = 1024;
+int Client::reconnect_base_ms = 250;
+int Client::reconnect_max_ms = 30000;
+int Client::slow_node_ms = 1000;
+int Client::eject_ms = 10000;
+int Client::health_interval_ms = 1000;
+int Client::metrics_interval_ms = 15000;
+int Client::compression_threshold = frame_compression::default_threshold;
+QHash<QByteArray, int> Client::default_deadlines = {
+    {"equation", 10000},
+    {"equation_batch", 60000},
+    {"login", 10000},
+    {"reg", 10000},
+    {"reset", 10000},
+};
+int Client::send_queue_limit = 65536;
+int Client::in_flight_window = 4096;
+qint64 Client::high_watermark = 4 << 20;
+qint64 Client::low_watermark = 1 << 20;
+framing Client::preferred_framing = framing::LENGTH_PREFIXED;
+
+/**
+ * @brief Проверяет, содержит ли ответ сервера корни
+ * @param answer Ответ сервера
+ * @return true если уравнение решено
+ */
+static bool is_solved(const QString& answer) {
+    return answer != "error" and answer != "infinity_solutions" and answer != "no_solution" and answer != "canceled"
+           and answer != "timeout";
+}
+
+/// Виды сообщений в метриках (последний - все остальные виды)
+static const char* const request_types[] = {"equation", "equation_batch", "login", "reg", "reset", "cancel", "other"};
+/// Исходы ответа в метриках (первый - уравнение решено)
+static const char* const answer_outcomes[] = {"ok", "error", "no_solution", "infinity_solutions", "canceled", "timeout"};
+
+/**
+ * @brief Возвращает вид сообщения для метрик
+ * @param message Текстовое или двоичное сообщение
+ * @return Номер в request_types
+ *
+ * В отличие от Client::message_type не выделяет память: вызывается
+ * для каждого отправленного сообщения.
+ */
+static int request_type(QByteArrayView message) {
+    constexpr int other = int(sizeof(request_types) / sizeof(request_types[0])) - 1;
+    if (binary_codec::is_binary(message))
+        return message[0] == binary_codec::batch_tag ? 1 : 0;
+    qsizetype separator = message.indexOf('|');
+    QByteArrayView type = separator < 0 ? message : message.first(separator);
+    for (int i = 0; i < other; i++)
+        if (type == request_types[i])
+            return i;
+    return other;
+}
+
+/**
+ * @brief Возвращает исход ответа для метрик
+ * @param answer Ответ на одно уравнение
+ * @return Номер в answer_outcomes
+ */
+static int answer_outcome(QStringView answer) {
+    constexpr int count = int(sizeof(answer_outcomes) / sizeof(answer_outcomes[0]));
+    for (int i = 1; i < count; i++)
+        if (answer == QLatin1String(answer_outcomes[i]))
+            return i;
+    return 0;
+}
 
 /**
  * @brief Инициализирует разрушитель синглтона
  * @param element Указатель на экземпляр клиента
- * @param socket Указатель на сокет соединения
  */
-void SingletonDestroyer::initialize(Client* element, QTcpSocket* socket) {
+void SingletonDestroyer::initialize(Client* element) {
     SingletonDestroyer::client_connection = element;
-    SingletonDestroyer::socket = socket;
 }
 
 /**
@@ -31,35 +104,162 @@ SingletonDestroyer::SingletonDestroyer() {}
 /**
  * @brief Деструктор разрушителя
  *
- * Освобождает ресурсы клиента и сокета
+ * Освобождает ресурсы клиента
  */
 SingletonDestroyer::~SingletonDestroyer() {
-    qDebug() << "Вызвался деструктор SingletonDestroyer";
-    delete SingletonDestroyer::socket;
+    LOG_DEBUG("client", "Вызвался деструктор SingletonDestroyer");
     delete SingletonDestroyer::client_connection;
 }
 
 /**
  * @brief Конструктор клиента
  *
- * Инициализирует соединение с сервером
+ * Запускает сетевой поток и инициализирует соединение с сервером
+ * по адресу endpoint::configured и, если настроено, резервное
+ * соединение по адресу endpoint::configured_standby. Если настроен
+ * список серверов, открывает соединения ко всем серверам списка.
  */
-Client::Client()
+Client::Client() :
+    persistent_results(result_store::default_path)
 {
-    qDebug() << "Вызвался конструктор клиента";
-    Client::socket = new QTcpSocket();
-    // Подключаем сигналы состояния соединения
-    connect(Client::socket, &QTcpSocket::connected, this, &Client::connect_to_server);
-    connect(Client::socket, &QTcpSocket::disconnected, this, &Client::disconnect_from_server);
+    LOG_DEBUG("client", "Вызвался конструктор клиента");
+    // Постоянное хранилище ответов лежит рядом с кэшем авторизации
+    QDir().mkpath("cache");
+    if (!this->persistent_results.open())
+        LOG_WARNING("client", QString("Не удалось открыть хранилище ответов %1").arg(result_store::default_path));
+
+    const QList<endpoint> servers = endpoint::configured_fleet(QCoreApplication::arguments());
+    this->server_address = servers.first();
+    this->clock.start();
+    this->init_metrics();
+
+    this->worker = new network_worker(handshake::offer(Client::preferred_framing));
+    this->attach(this->worker);
+
+    // Нулевой сервер списка обслуживается основным соединением
+    for (qsizetype i = 0; i < servers.size(); i++) {
+        fleet_node node;
+        node.address = servers[i];
+        if (i > 0) {
+            int index = int(i);
+            node.worker = new network_worker(handshake::offer(Client::preferred_framing));
+            node.retry = new QTimer(this);
+            node.retry->setSingleShot(true);
+            connect(node.retry, &QTimer::timeout, this, [this, index]() { this->reconnect_node(index); });
+        }
+        this->fleet.append(node);
+        this->ring.add(int(i), servers[i].to_string());
+    }
+    for (qsizetype i = 1; i < this->fleet.size(); i++)
+        this->attach(this->fleet[i].worker);
+    if (this->fleet.size() > 1) {
+        connect(&this->health_timer, &QTimer::timeout, this, &Client::check_fleet);
+        this->health_timer.start(Client::health_interval_ms);
+    }
+
+    this->reconnect_timer.setSingleShot(true);
+    connect(&this->reconnect_timer, &QTimer::timeout, this, &Client::reconnect);
+    this->deadline_timer.setInterval(this->deadlines.tick());
+    connect(&this->deadline_timer, &QTimer::timeout, this, &Client::check_deadlines);
+    this->send_timer.setSingleShot(true);
+    this->send_timer.setTimerType(Qt::PreciseTimer);
+    connect(&this->send_timer, &QTimer::timeout, this, &Client::drain_send_queue);
+
+    this->standby_enabled = endpoint::configured_standby(QCoreApplication::arguments(),
+                                                         this->server_address, this->standby_address);
+    if (this->standby_enabled) {
+        this->standby_worker = new network_worker(handshake::offer(Client::preferred_framing));
+        this->attach(this->standby_worker);
+        this->standby_timer.setSingleShot(true);
+        connect(&this->standby_timer, &QTimer::timeout, this, &Client::reconnect_standby);
+    }
+
+    this->network_thread.setObjectName("network");
+    this->network_thread.start();
+
     // Устанавливаем соединение с сервером
-    Client::socket->connectToHost("127.0.0.1", port);
+    LOG_INFO("client", "Адрес сервера: " + this->server_address.to_string());
+    this->reconnect();
+    if (this->standby_enabled) {
+        LOG_INFO("client", "Адрес резервного соединения: " + this->standby_address.to_string());
+        this->reconnect_standby();
+    }
+    for (qsizetype i = 1; i < this->fleet.size(); i++) {
+        LOG_INFO("client", "Сервер списка: " + this->fleet[i].address.to_string());
+        this->reconnect_node(int(i));
+    }
+}
+
+/**
+ * @brief Подключает сигналы сетевой части к обработчикам клиента
+ * @param worker Основная или резервная сетевая часть
+ *
+ * Сигналы сетевого потока доставляются в поток интерфейса через очередь
+ * событий. При переключении Client меняет местами worker и standby_worker,
+ * поэтому роль определяется при доставке, а не при подключении. Сетевые
+ * части серверов списка ролями не меняются.
+ */
+void Client::attach(network_worker* worker) {
+    worker->set_compression_threshold(Client::compression_threshold);
+    worker->set_watermarks(Client::high_watermark, Client::low_watermark);
+    worker->moveToThread(&this->network_thread);
+    connect(&this->network_thread, &QThread::finished, worker, &QObject::deleteLater);
+
+    connect(worker, &network_worker::connected, this, [this, worker](const handshake& features) {
+        if (worker == this->worker) {
+            this->server_features = features;
+            this->connect_to_server();
+        }
+        else if (worker == this->standby_worker) {
+            this->standby_features = features;
+            this->standby_connected();
+        }
+        else {
+            int node = this->node_of(worker);
+            this->fleet[node].features = features;
+            this->node_connected(node);
+        }
+    });
+    connect(worker, &network_worker::disconnected, this, [this, worker]() {
+        if (worker == this->worker)
+            this->disconnect_from_server();
+        else if (worker == this->standby_worker)
+            this->standby_lost();
+        else
+            this->node_lost(this->node_of(worker));
+    });
+    connect(worker, &network_worker::connection_failed, this, [this, worker]() {
+        if (worker == this->worker)
+            this->schedule_reconnect();
+        else if (worker == this->standby_worker)
+            this->schedule_standby();
+        else
+            this->schedule_node(this->node_of(worker));
+    });
+    // Соединение освободилось: задержанные сообщения можно отправлять
+    connect(worker, &network_worker::drained, this, &Client::drain_send_queue);
+    connect(worker, &network_worker::messages_received, this, [this, worker](const QByteArrayList& messages) {
+        if (worker == this->worker)
+            this->receive(0, messages);
+        else if (worker == this->standby_worker)
+            this->receive_standby(messages);
+        else
+            this->receive_node(this->node_of(worker), messages);
+    });
 }
 
 /**
  * @brief Деструктор клиента
+ *
+ * Останавливает сетевой поток; сетевая часть удаляется по его завершении
  */
 Client::~Client() {
-    qDebug() << "Вызвался деструктор клиента";
+    LOG_DEBUG("client", "Вызвался деструктор клиента");
+    // Последние значения метрик, пока сетевые части ещё существуют
+    if (!this->metrics_path.isEmpty())
+        this->write_metrics_file();
+    this->network_thread.quit();
+    this->network_thread.wait();
 }
 
 /**
@@ -69,30 +269,583 @@ Client::~Client() {
 Client* Client::get_instance() {
     if (Client::p_instance == nullptr) {
         Client::p_instance = new Client();
-        SingletonDestroyer::initialize(Client::p_instance, Client::socket);
+        SingletonDestroyer::initialize(Client::p_instance);
     }
     return Client::p_instance;
 }
 
+/**
+ * @brief Проверяет наличие подключения к серверу
+ * @return true если соединение установлено
+ */
+bool Client::is_connected() const {
+    return this->connected;
+}
+
+/**
+ * @brief Возвращает адрес сервера
+ * @return Адрес из командной строки, окружения, client.ini или адрес по умолчанию
+ */
+const endpoint& Client::get_server_address() const {
+    return this->server_address;
+}
+
+/**
+ * @brief Проверяет готовность резервного соединения
+ * @return true если резервное соединение подключено и вход на нём выполнен
+ */
+bool Client::is_standby_ready() const {
+    return this->standby == link_state::READY;
+}
+
+/**
+ * @brief Возвращает возможности протокола, согласованные с сервером
+ * @return Возможности основного соединения (для старого сервера - handshake())
+ */
+const handshake& Client::get_server_features() const {
+    return this->server_features;
+}
+
+/**
+ * @brief Возвращает количество серверов в списке
+ * @return Количество серверов
+ */
+int Client::get_fleet_size() const {
+    return int(this->fleet.size());
+}
+
+/**
+ * @brief Проверяет, получает ли сервер из списка уравнения
+ * @param node Номер сервера в списке
+ * @return true если соединение готово и сервер не исключён как медленный
+ */
+bool Client::is_node_available(int node) const {
+    if (node < 0 or node >= this->fleet.size())
+        return false;
+    if (this->clock.elapsed() < this->fleet[node].ejected_until_ms)
+        return false;
+    if (node == 0)
+        return this->connected and !this->reauthenticating;
+    return this->fleet[node].state == link_state::READY;
+}
+
+/**
+ * @brief Возвращает количество переключений на резервное соединение
+ * @return Количество переключений с момента запуска
+ */
+int Client::get_failover_count() const {
+    return this->failovers;
+}
+
+/**
+ * @brief Возвращает счётчики сжатия всех соединений
+ * @return Сумма счётчиков основного, резервного соединений и серверов списка
+ *
+ * Счётчики копируются из сетевого потока под блокировкой, поэтому
+ * метод можно вызывать в любой момент, например для строки состояния.
+ */
+compression_stats Client::get_compression_stats() const {
+    compression_stats total = this->worker->compression_counters();
+    if (this->standby_worker != nullptr)
+        total += this->standby_worker->compression_counters();
+    for (qsizetype i = 1; i < this->fleet.size(); i++)
+        total += this->fleet[i].worker->compression_counters();
+    return total;
+}
+
+/**
+ * @brief Возвращает метрики клиента
+ * @return Текстовый формат Prometheus
+ */
+QByteArray Client::get_metrics() {
+    this->collect_metrics();
+    return this->metrics.to_prometheus();
+}
+
 /**
  * @brief Обработчик успешного подключения к серверу
+ *
+ * Если до разрыва был выполнен вход, он повторяется, и очередь
+ * сообщений отправляется после ответа сервера на него.
  */
 void Client::connect_to_server() {
-    // Настраиваем обработку входящих данных
-    connect(this->socket, &QTcpSocket::readyRead, this, &Client::read);
+    this->connected = true;
+    this->reconnect_attempt = 0;
+    if (this->session_login.isEmpty()) {
+        this->flush_offline_queue();
+        return;
+    }
+    this->reauthenticating = true;
+    this->send_now({this->session_login});
+}
+
+/**
+ * @brief Начинает попытку подключения
+ */
+void Client::reconnect() {
+    network_worker* worker = this->worker;
+    endpoint address = this->server_address;
+    QMetaObject::invokeMethod(worker, [worker, address]() {
+        worker->connect_to(address);
+    }, Qt::QueuedConnection);
+}
+
+/**
+ * @brief Планирует следующую попытку подключения
+ *
+ * Задержка растёт экспоненциально от reconnect_base_ms до
+ * reconnect_max_ms и выбирается случайно из [d/2; d], чтобы клиенты,
+ * потерявшие соединение одновременно (перезапуск сервера), не
+ * подключались к нему одной волной.
+ */
+void Client::schedule_reconnect() {
+    if (this->reconnect_timer.isActive())
+        return;
+    int delay = Client::backoff_delay(this->reconnect_attempt++);
+    this->reconnects->add();
+    LOG_INFO("client", QString("Переподключение через %1 мс, попытка %2").arg(delay).arg(this->reconnect_attempt));
+    this->reconnect_timer.start(delay);
+}
+
+/**
+ * @brief Вычисляет задержку очередной попытки подключения
+ * @param attempt Номер попытки подряд
+ * @return Задержка, мс
+ */
+int Client::backoff_delay(int attempt) {
+    qint64 delay = qMin<qint64>(Client::reconnect_max_ms,
+                                qint64(Client::reconnect_base_ms) << qMin(attempt, 20));
+    return int(delay / 2 + QRandomGenerator::global()->bounded(delay / 2 + 1));
+}
+
+/**
+ * @brief Начинает попытку подключения резервного соединения
+ */
+void Client::reconnect_standby() {
+    network_worker* worker = this->standby_worker;
+    endpoint address = this->standby_address;
+    QMetaObject::invokeMethod(worker, [worker, address]() {
+        worker->connect_to(address);
+    }, Qt::QueuedConnection);
+}
+
+/**
+ * @brief Планирует следующую попытку подключения резервного соединения
+ */
+void Client::schedule_standby() {
+    if (this->standby_timer.isActive())
+        return;
+    this->standby_timer.start(Client::backoff_delay(this->standby_attempt++));
 }
 
 /**
- * @brief Читает данные от сервера
+ * @brief Обработчик подключения резервного соединения
  *
- * Обрабатывает входящие сообщения и генерирует соответствующие сигналы
+ * До входа пользователя резервное соединение готово сразу; после входа
+ * на нём повторяется вход основной сессии.
+ */
+void Client::standby_connected() {
+    this->standby_attempt = 0;
+    this->standby = link_state::CONNECTED;
+    if (this->session_login.isEmpty())
+        this->standby_ready();
+    else
+        this->login_standby();
+}
+
+/**
+ * @brief Обработчик разрыва резервного соединения
+ */
+void Client::standby_lost() {
+    this->standby = link_state::DOWN;
+    LOG_WARNING("client", "Резервное соединение разорвано");
+    this->schedule_standby();
+}
+
+/**
+ * @brief Выполняет вход на резервном соединении под текущей учётной записью
  */
-void Client::read() {
-    QByteArray data;
-    while (this->socket->bytesAvailable() > 0) {
-        data.append(this->socket->readAll());
+void Client::login_standby() {
+    if (this->standby == link_state::DOWN or this->session_login.isEmpty())
+        return;
+    this->standby = link_state::AUTHENTICATING;
+    this->send_now({this->session_login}, this->standby_worker);
+}
+
+/**
+ * @brief Отмечает резервное соединение готовым
+ */
+void Client::standby_ready() {
+    this->standby = link_state::READY;
+    if (!this->connected)
+        this->fail_over();
+}
+
+/**
+ * @brief Принимает ответы сервера по резервному соединению
+ * @param messages Содержимое полученных кадров
+ */
+void Client::receive_standby(const QByteArrayList& messages) {
+    for (const QByteArray& message : messages) {
+        if (this->standby != link_state::AUTHENTICATING or !message.startsWith("auth|"))
+            continue;
+        if (message == "auth|ok") {
+            this->standby_ready();
+        }
+        else {
+            LOG_WARNING("client", "Вход на резервном соединении отклонён");
+            this->standby = link_state::CONNECTED;
+        }
     }
-    QString data_to_qstring = QString(data);
+}
+
+/**
+ * @brief Переносит запросы на резервное соединение и меняет соединения ролями
+ *
+ * Резервное соединение уже подключено и вход на нём выполнен, поэтому
+ * запросы, ожидающие ответа, и очередь отправляются на него сразу, без
+ * ожидания переподключения и повторного входа. Бывшее основное
+ * соединение переподключается к своему адресу как резервное.
+ */
+void Client::fail_over() {
+    // После разрыва и до завершения повторного входа очередь уже содержит все запросы, ожидающие ответа
+    bool queue_sent = this->connected and !this->reauthenticating;
+
+    std::swap(this->worker, this->standby_worker);
+    std::swap(this->server_address, this->standby_address);
+    std::swap(this->server_features, this->standby_features);
+    this->standby = link_state::DOWN;
+    this->connected = true;
+    this->reauthenticating = false;
+    this->reconnect_timer.stop();
+    this->reconnect_attempt = 0;
+    this->failovers++;
+
+    // Запросы кодируются заново: резервный сервер мог согласовать другие возможности
+    if (queue_sent) {
+        QList<held_message> resend;
+        for (auto request = this->in_flight.cbegin(); request != this->in_flight.cend(); ++request)
+            if (request->node == 0 and !request->held)
+                resend.append(held_message{request.key(), {}, 0, send_priority::BULK});
+        this->offline_queue = resend + this->offline_queue;
+    }
+    LOG_WARNING("client", QString("Переключение на резервное соединение %1, повторно отправлено: %2")
+                              .arg(this->server_address.to_string()).arg(this->offline_queue.size()));
+    this->flush_offline_queue();
+
+    this->standby_timer.stop();
+    this->standby_attempt = 0;
+    this->reconnect_standby();
+}
+
+/**
+ * @brief Находит номер сервера из списка по его сетевой части
+ * @param worker Сетевая часть
+ * @return Номер сервера или -1
+ */
+int Client::node_of(const network_worker* worker) const {
+    for (qsizetype i = 1; i < this->fleet.size(); i++)
+        if (this->fleet[i].worker == worker)
+            return int(i);
+    return -1;
+}
+
+/**
+ * @brief Возвращает возможности протокола, согласованные с сервером из списка
+ * @param node Номер сервера
+ * @return Возможности соединения с сервером
+ */
+const handshake& Client::features_of(int node) const {
+    return node > 0 ? this->fleet[node].features : this->server_features;
+}
+
+/**
+ * @brief Вычисляет хеш нормализованного уравнения для выбора сервера
+ * @param equation Уравнение
+ * @return Хеш, одинаковый для уравнений с одним ответом (никогда не 0)
+ *
+ * Хешируется ключ answer_cache::normalize, поэтому 2x² - 8x + 8 и
+ * x² - 4x + 4 попадают на один сервер и используют его кэш.
+ */
+quint64 Client::route_key(const equation_request& equation) {
+    answer_cache::key key = answer_cache::normalize(equation);
+    char bytes[1 + 2 * sizeof(quint64)];
+    quint64 p = 0;
+    quint64 q = 0;
+    std::memcpy(&p, &key.p, sizeof(p));
+    std::memcpy(&q, &key.q, sizeof(q));
+    bytes[0] = char(key.kind);
+    qToLittleEndian(p, bytes + 1);
+    qToLittleEndian(q, bytes + 1 + sizeof(quint64));
+    quint64 value = hash_ring::hash(QByteArrayView(bytes, sizeof(bytes)));
+    return value != 0 ? value : 1;
+}
+
+/**
+ * @brief Выбирает сервер для уравнения
+ * @param key Хеш нормализованного уравнения
+ * @param exclude Сервер, который нельзя выбирать
+ * @return Номер сервера или -1, если ни один сервер не доступен
+ */
+int Client::pick_node(quint64 key, int exclude) const {
+    return this->ring.lookup(key, [this, exclude](int node) {
+        return node != exclude and this->is_node_available(node);
+    });
+}
+
+/**
+ * @brief Отправляет запросы, ожидающие ответа от сервера, другим серверам
+ * @param node Сервер из списка
+ *
+ * Повторная отправка уравнений безопасна: если ответит и прежний
+ * сервер, второй ответ на тот же идентификатор будет отброшен. Запрос
+ * кодируется заново в формате нового сервера; кадр пакета, который
+ * новый сервер принять не может, завершается ошибкой.
+ */
+void Client::reroute(int node) {
+    qint64 now = this->clock.nsecsElapsed();
+    QMap<int, QByteArrayList> moved;
+    QMap<quint32, pending_request> failed;
+    for (auto request = this->in_flight.begin(); request != this->in_flight.end();) {
+        // Запросы из очереди отправки выберут сервер при отправке
+        if (request->node != node or request->held) {
+            ++request;
+            continue;
+        }
+        int target = request->route_key != 0 ? this->pick_node(request->route_key, node) : -1;
+        if (target < 0 and node == 0) {
+            ++request;
+            continue;
+        }
+        // Основное соединение отправит запрос сразу или после восстановления
+        target = qMax(0, target);
+        QByteArray message = this->encode_request(request.key(), *request, target);
+        if (message.isEmpty() or (target == 0 and !this->send_primary(message, send_priority::BULK, request.key()))) {
+            failed.insert(request.key(), std::move(*request));
+            request = this->in_flight.erase(request);
+            continue;
+        }
+        if (target > 0)
+            moved[target].append(message);
+        request->node = target;
+        request->sent_ns = now;
+        ++request;
+    }
+    for (auto batch = moved.cbegin(); batch != moved.cend(); ++batch)
+        this->send_now(batch.value(), this->fleet[batch.key()].worker);
+    for (auto request = failed.cbegin(); request != failed.cend(); ++request)
+        this->finish_request(request.key(), request.value(), "error");
+}
+
+/**
+ * @brief Выполняет вход на всех соединениях с серверами из списка
+ */
+void Client::login_fleet() {
+    for (qsizetype i = 1; i < this->fleet.size(); i++) {
+        fleet_node& node = this->fleet[i];
+        if (node.state == link_state::DOWN or this->session_login.isEmpty())
+            continue;
+        node.state = link_state::AUTHENTICATING;
+        this->send_now({this->session_login}, node.worker);
+    }
+}
+
+/**
+ * @brief Обработчик подключения к серверу из списка
+ * @param node Номер сервера
+ *
+ * До входа пользователя сервер готов сразу; после входа на нём
+ * повторяется вход основной сессии.
+ */
+void Client::node_connected(int node) {
+    fleet_node& item = this->fleet[node];
+    item.attempt = 0;
+    if (this->session_login.isEmpty()) {
+        item.state = link_state::READY;
+        return;
+    }
+    item.state = link_state::AUTHENTICATING;
+    this->send_now({this->session_login}, item.worker);
+}
+
+/**
+ * @brief Обработчик разрыва соединения с сервером из списка
+ * @param node Номер сервера
+ */
+void Client::node_lost(int node) {
+    fleet_node& item = this->fleet[node];
+    item.state = link_state::DOWN;
+    item.latency_ms = 0;
+    LOG_WARNING("client", "Разорвано соединение с сервером " + item.address.to_string());
+    this->reroute(node);
+    this->schedule_node(node);
+}
+
+/**
+ * @brief Планирует следующую попытку подключения к серверу из списка
+ * @param node Номер сервера
+ */
+void Client::schedule_node(int node) {
+    fleet_node& item = this->fleet[node];
+    if (item.retry->isActive())
+        return;
+    item.retry->start(Client::backoff_delay(item.attempt++));
+}
+
+/**
+ * @brief Начинает попытку подключения к серверу из списка
+ * @param node Номер сервера
+ */
+void Client::reconnect_node(int node) {
+    network_worker* worker = this->fleet[node].worker;
+    endpoint address = this->fleet[node].address;
+    QMetaObject::invokeMethod(worker, [worker, address]() {
+        worker->connect_to(address);
+    }, Qt::QueuedConnection);
+}
+
+/**
+ * @brief Принимает сообщения сервера из списка
+ * @param node Номер сервера
+ * @param messages Содержимое полученных кадров
+ */
+void Client::receive_node(int node, const QByteArrayList& messages) {
+    fleet_node& item = this->fleet[node];
+    QByteArrayList answers;
+    for (const QByteArray& message : messages) {
+        if (!message.startsWith("auth|")) {
+            answers.append(message);
+            continue;
+        }
+        if (item.state != link_state::AUTHENTICATING)
+            continue;
+        if (message == "auth|ok") {
+            item.state = link_state::READY;
+        }
+        else {
+            LOG_WARNING("client", QString("Вход на сервере %1 отклонён").arg(item.address.to_string()));
+            item.state = link_state::CONNECTED;
+        }
+    }
+    if (!answers.isEmpty())
+        this->receive(node, answers);
+}
+
+/**
+ * @brief Исключает медленные серверы из распределения и возвращает восстановившиеся
+ *
+ * Сервер считается медленным, если скользящее среднее задержки ответа
+ * или возраст самого старого ожидающего запроса превышает slow_node_ms.
+ * Медленный сервер исключается на eject_ms, его запросы переносятся на
+ * следующие серверы кольца. Последний доступный сервер не исключается.
+ */
+void Client::check_fleet() {
+    qint64 now_ns = this->clock.nsecsElapsed();
+    qint64 now_ms = this->clock.elapsed();
+    QList<qint64> oldest_ns(this->fleet.size(), 0);
+    for (const pending_request& request : std::as_const(this->in_flight))
+        oldest_ns[request.node] = qMax(oldest_ns[request.node], now_ns - request.sent_ns);
+
+    for (qsizetype i = 0; i < this->fleet.size(); i++) {
+        fleet_node& node = this->fleet[i];
+        if (node.ejected_until_ms != 0 and now_ms >= node.ejected_until_ms) {
+            node.ejected_until_ms = 0;
+            node.latency_ms = 0;
+            LOG_INFO("client", QString("Сервер %1 возвращён в распределение").arg(node.address.to_string()));
+            continue;
+        }
+        if (!this->is_node_available(int(i)))
+            continue;
+        double oldest_ms = oldest_ns[i] / 1e6;
+        if (node.latency_ms <= Client::slow_node_ms and oldest_ms <= Client::slow_node_ms)
+            continue;
+
+        bool others = false;
+        for (qsizetype j = 0; j < this->fleet.size() and !others; j++)
+            others = j != i and this->is_node_available(int(j));
+        if (!others)
+            continue;
+
+        node.ejected_until_ms = now_ms + Client::eject_ms;
+        LOG_WARNING("client", QString("Сервер %1 исключён на %2 мс: задержка %3 мс, самый старый запрос %4 мс")
+                                  .arg(node.address.to_string()).arg(Client::eject_ms)
+                                  .arg(node.latency_ms, 0, 'f', 1).arg(oldest_ms, 0, 'f', 1));
+        this->reroute(int(i));
+    }
+}
+
+/**
+ * @brief Принимает ответы сервера от сетевого потока
+ * @param node Сервер из списка, приславший ответы (0 - основное соединение)
+ * @param messages Содержимое полученных кадров
+ */
+void Client::receive(int node, const QByteArrayList& messages) {
+    for (const QByteArray& message : messages)
+        this->inbox.append({message, node});
+    if (!this->inbox_scheduled) {
+        this->inbox_scheduled = true;
+        QMetaObject::invokeMethod(this, &Client::process_inbox, Qt::QueuedConnection);
+    }
+}
+
+/**
+ * @brief Обрабатывает очередную порцию полученных ответов
+ *
+ * Если после порции остались необработанные ответы, следующая порция
+ * обрабатывается в следующей итерации цикла событий, после перерисовки
+ * и обработки ввода пользователя.
+ */
+void Client::process_inbox() {
+    qsizetype end = qMin(this->inbox.size(), this->inbox_position + Client::inbox_slice);
+    while (this->inbox_position < end) {
+        received_message next = this->inbox[this->inbox_position++];
+        this->process_message(next.message, next.node);
+    }
+
+    if (this->inbox_position < this->inbox.size()) {
+        QMetaObject::invokeMethod(this, &Client::process_inbox, Qt::QueuedConnection);
+        return;
+    }
+    this->inbox.clear();
+    this->inbox_position = 0;
+    this->inbox_scheduled = false;
+
+    // Ответы освободили окно запросов
+    if (this->get_send_queue_size() > 0)
+        this->drain_send_queue();
+}
+
+/**
+ * @brief Обрабатывает одно сообщение сервера
+ * @param message Содержимое кадра
+ * @param node Сервер из списка, приславший сообщение
+ *
+ * Генерирует сигналы, соответствующие ответу сервера. Двоичный ответ
+ * (binary_codec) приводится к полям текстового и обрабатывается так же.
+ */
+void Client::process_message(QByteArrayView message, int node) {
+    trace_span span("Client::read", "client");
+    if (binary_codec::is_binary(message)) {
+        QStringList answers;
+        quint32 id = 0;
+        bool batch = false;
+        if (!binary_codec::decode_answer(message, answers, id, batch)) {
+            LOG_WARNING("client", "Повреждённый двоичный ответ сервера");
+            return;
+        }
+        this->dispatch_answer({batch ? "answer_batch" : "answer", answers.join(';'), QString::number(id)}, node);
+        return;
+    }
+
+    QString data_to_qstring = QString::fromUtf8(message);
+
+    // Ответ на сообщение учётной записи снимает срок его ожидания
+    if (data_to_qstring.startsWith("register|"))
+        this->account_answered("reg");
+    else if (data_to_qstring.startsWith("reset|"))
+        this->account_answered("reset");
+    else if (!this->reauthenticating and data_to_qstring.startsWith("auth|"))
+        this->account_answered("login");
 
     // Обработка сообщений о регистрации
     if (data_to_qstring == "register|ok")
@@ -101,8 +854,25 @@ void Client::read() {
         emit this->register_error();
 
     // Обработка сообщений о авторизации
-    if (data_to_qstring == "auth|ok")
+    if (this->reauthenticating and data_to_qstring.startsWith("auth|")) {
+        // Ответ на повторный вход после переподключения окнам не передаётся
+        this->reauthenticating = false;
+        if (data_to_qstring == "auth|ok") {
+            this->flush_offline_queue();
+        }
+        else {
+            LOG_WARNING("client", "Повторный вход после переподключения отклонён");
+            this->session_login.clear();
+            this->fail_pending();
+        }
+        return;
+    }
+    if (data_to_qstring == "auth|ok") {
+        this->session_login = this->pending_login;
+        this->login_standby();
+        this->login_fleet();
         emit this->auth_ok();
+    }
     if (data_to_qstring == "auth|error")
         emit this->auth_error();
 
@@ -111,15 +881,86 @@ void Client::read() {
         emit this->reset_error();
 
     // Обработка ответов на уравнения
-    if (data_to_qstring.split("|")[0] == "answer") {
-        QString answer = data_to_qstring.split("|")[1];
-        if (answer != "error" and answer != "infinity_solutions" and answer != "no_solution")
-            emit this->equation_ok(answer);
-        else
-            emit this->equation_fail(answer);
+    if (data_to_qstring.startsWith("answer|") or data_to_qstring.startsWith("answer_batch|"))
+        this->dispatch_answer(data_to_qstring.split("|"), node);
+
+    LOG_DEBUG("client", "Сообщение сервера: " + data_to_qstring);
+}
+
+/**
+ * @brief Направляет ответ на уравнение отправителю запроса
+ * @param fields Поля сообщения "answer|<решение>[|<id>]" или "answer_batch|<ответы>|<id>"
+ * @param node Сервер из списка, приславший ответ
+ *
+ * Ответ без идентификатора (старый сервер) относится к запросу, раньше
+ * всех отправленному этому же серверу: сервер без идентификаторов
+ * отвечает по порядку получения. Одиночные ответы, не принадлежащие ни одному
+ * запросу, передаются через сигналы equation_ok/equation_fail.
+ */
+void Client::dispatch_answer(const QStringList& fields, int node) {
+    QString answer = fields[1];
+    bool solved = is_solved(answer);
+
+    pending_request request;
+    bool matched = false;
+    bool is_id = false;
+    quint32 id = 0;
+    if (fields.size() >= 3) {
+        id = fields[2].toUInt(&is_id);
+        auto waiting = is_id ? this->in_flight.find(id) : this->in_flight.end();
+        if (waiting != this->in_flight.end()) {
+            request = std::move(*waiting);
+            this->in_flight.erase(waiting);
+            matched = true;
+        }
+    }
+    else {
+        // Запросы из очереди отправки сервер ещё не получал; перенесённый запрос мог уйти позже более новых
+        auto oldest = this->in_flight.end();
+        for (auto waiting = this->in_flight.begin(); waiting != this->in_flight.end(); ++waiting) {
+            if (waiting->held or waiting->node != node)
+                continue;
+            if (oldest == this->in_flight.end() or waiting->sent_ns < oldest->sent_ns)
+                oldest = waiting;
+        }
+        if (oldest != this->in_flight.end()) {
+            id = oldest.key();
+            request = std::move(*oldest);
+            this->in_flight.erase(oldest);
+            matched = true;
+        }
+    }
+    if (request.held)
+        this->held_requests--;
+    if (request.deadline_ms != 0)
+        this->deadlines.remove(id, request.deadline_ms);
+    // Ответы на отменённые и неизвестные запросы в метриках не учитываются
+    if (matched) {
+        this->round_trip->record(this->clock.nsecsElapsed() - request.sent_ns);
+        this->count_answer(answer, fields[0] == "answer_batch");
+    }
+    trace_span span("dispatch answer", "client");
+    span.set_request(id);
+    const answer_handler& handler = request.handler;
+
+    if (handler and this->fleet.size() > 1) {
+        // Скользящее среднее задержки сервера для check_fleet
+        fleet_node& node = this->fleet[request.node];
+        double latency = (this->clock.nsecsElapsed() - request.sent_ns) / 1e6;
+        node.latency_ms = node.latency_ms == 0 ? latency : node.latency_ms * 0.8 + latency * 0.2;
     }
 
-    qDebug() << QString("%1 Server send: %2").arg(clients_func::get_client_time()).arg(data_to_qstring.simplified());
+    // Ответ на отменённый запрос не передаётся окнам
+    if (handler) {
+        handler(answer, solved);
+        trace::async_end("request", id);
+    }
+    else if (fields[0] != "answer" or is_id)
+        return;
+    else if (solved)
+        emit this->equation_ok(answer);
+    else
+        emit this->equation_fail(answer);
 }
 
 /**
@@ -128,21 +969,1105 @@ void Client::read() {
  * @return true если сообщение отправлено успешно, false в случае ошибки
  */
 bool Client::write(QString text) {
-    QByteArray data = text.toUtf8();
-    if (this->socket->state() != QAbstractSocket::ConnectedState) {
-        clients_func::create_messagebox("Ошибка", "Нет подключения к серверу, попробуйте перезапустить приложение");
+    return this->write_bytes(text.toUtf8());
+}
+
+/**
+ * @brief Отправляет серверу уже закодированное сообщение
+ * @param data Сообщение в UTF-8
+ * @return true если сообщение отправлено или поставлено в очередь, false в случае ошибки
+ *
+ * Уравнения и пакеты проходят через ограничитель отправки и при
+ * закрытом ограничителе ждут в очереди отправки. Во время разрыва и
+ * повторного входа сообщения копятся в очереди (не более offline_limit)
+ * и отправляются после восстановления сессии. Для входа, регистрации
+ * и сброса пароля начинается ожидание ответа со сроком по умолчанию
+ * (с учётом времени в очереди).
+ */
+bool Client::write_bytes(const QByteArray& data) {
+    trace_span span("Client::write", "client");
+    if (data.startsWith("login|"))
+        this->pending_login = data;
+
+    if (Client::is_limited(data)
+        and (!this->send_queue[lane_scheduler::lane(send_priority::BULK)].isEmpty()
+             or !this->take_send_slot(0, send_priority::BULK))) {
+        if (!this->hold(0, data, 0, send_priority::BULK))
+            return false;
+    }
+    else if (!this->send_primary(data)) {
         return false;
     }
+
+    if (data.startsWith("login|") or data.startsWith("reg|") or data.startsWith("reset|"))
+        this->await_account(Client::message_type(data));
+    return true;
+}
+
+/**
+ * @brief Отправляет сообщение через основное соединение или в очередь разрыва
+ * @param data Сообщение в UTF-8 или двоичное
+ * @param priority Полоса очереди отправки сетевой части
+ * @param id Идентификатор запроса (0 - сообщение без ожидания ответа)
+ * @return false если нет соединения и очередь разрыва заполнена
+ *
+ * В очередь разрыва запрос ставится по идентификатору и кодируется
+ * заново при отправке: после переподключения сервер может согласовать
+ * другие возможности.
+ */
+bool Client::send_primary(const QByteArray& data, send_priority priority, quint32 id) {
+    if (this->connected and !this->reauthenticating) {
+        this->send_now({data}, nullptr, priority);
+        return true;
+    }
+    if (this->offline_queue.size() >= Client::offline_limit) {
+        // Сообщение об ошибке показывается вне пути отправки
+        emit this->server_unavailable();
+        return false;
+    }
+    this->offline_queue.append(held_message{id, id != 0 ? QByteArray() : data, 0, priority});
+    return true;
+}
+
+/**
+ * @brief Проверяет, проходит ли сообщение через ограничитель отправки
+ * @param message Сообщение
+ * @return true для уравнений и пакетов (текстовых и двоичных)
+ *
+ * Вход, регистрация, сброс пароля и отмена не задерживаются: они
+ * редкие, а их задержка за пакетом заметна пользователю.
+ */
+bool Client::is_limited(QByteArrayView message) {
+    return binary_codec::is_binary(message) or message.startsWith("equation|")
+           or message.startsWith("equation_batch|");
+}
+
+/**
+ * @brief Возвращает сетевую часть сервера из списка
+ * @param node Номер сервера (0 - основное соединение)
+ * @return Сетевая часть
+ */
+network_worker* Client::worker_of(int node) const {
+    return node > 0 ? this->fleet[node].worker : this->worker;
+}
+
+/**
+ * @brief Возвращает полосу, которой запрос идёт к серверу
+ * @param node Сервер из списка (0 - основное соединение)
+ * @param priority Запрошенная полоса
+ * @return priority; BULK, если сервер не согласовал идентификаторы запросов
+ *
+ * Ответ без идентификатора относится к самому раннему запросу,
+ * отправленному этому серверу, поэтому запросы к нему не должны обгонять
+ * друг друга: все они идут одной полосой в порядке постановки.
+ */
+send_priority Client::lane_for(int node, send_priority priority) const {
+    return this->features_of(node).request_ids ? priority : send_priority::BULK;
+}
+
+/**
+ * @brief Проверяет ограничения и забирает разрешение на одну отправку
+ * @param node Сервер из списка, которому предназначено сообщение
+ * @param priority Полоса сообщения
+ * @return true если сообщение можно отправить сейчас
+ *
+ * Окно запросов и корзина маркеров ограничивают только пакетную
+ * полосу: интерактивные запросы редкие, и их задержка заметна
+ * пользователю. Маркер забирается последним, поэтому при заполненном
+ * окне или переполненном соединении он не расходуется зря.
+ */
+bool Client::take_send_slot(int node, send_priority priority) {
+    bool bulk = priority == send_priority::BULK;
+    if (bulk and Client::in_flight_window > 0
+        and this->in_flight.size() - this->held_requests >= Client::in_flight_window)
+        return false;
+    if (this->worker_of(node)->congested(priority))
+        return false;
+    return !bulk or this->send_rate.take(this->clock.nsecsElapsed());
+}
+
+/**
+ * @brief Ставит сообщение в очередь отправки
+ * @param id Идентификатор запроса (0 - без ожидания ответа)
+ * @param message Сообщение
+ * @param node Сервер из списка
+ * @param priority Полоса сообщения
+ * @return false если очередь отправки заполнена
+ *
+ * Память клиента ограничена размером очереди (обеих полос вместе):
+ * отправитель, получивший отказ, должен дождаться сигнала send_ready.
+ */
+bool Client::hold(quint32 id, const QByteArray& message, int node, send_priority priority) {
+    if (this->get_send_queue_size() >= Client::send_queue_limit) {
+        this->send_refused = true;
+        return false;
+    }
+    this->send_queue[lane_scheduler::lane(priority)].append(held_message{id, message, node, priority});
+    this->arm_send_timer();
+    return true;
+}
+
+/**
+ * @brief Запускает ожидание маркера, если пакетная полоса ждёт только его
+ *
+ * Заполненное окно и переполненное соединение освобождаются ответами
+ * и сигналом network_worker::drained, таймер для них не нужен.
+ */
+void Client::arm_send_timer() {
+    if (this->send_queue[lane_scheduler::lane(send_priority::BULK)].isEmpty() or this->send_timer.isActive())
+        return;
+    qint64 wait = this->send_rate.wait_ns(this->clock.nsecsElapsed());
+    if (wait > 0)
+        this->send_timer.start(int(qMax<qint64>(1, (wait + 999999) / 1000000)));
+}
+
+/**
+ * @brief Отправляет сообщения из очереди отправки, пока ограничения позволяют
+ *
+ * Внутри полосы сообщения отправляются по порядку, полосы чередуются по
+ * весам send_order. Полоса, упёршаяся в ограничение, пропускается до
+ * следующего вызова, поэтому заполненное окно пакетов не задерживает
+ * интерактивные запросы. Отменённые и истёкшие запросы пропускаются без
+ * отправки. Сервер списка, ставший недоступным, пока запрос ждал,
+ * заменяется основным соединением. Запрос кодируется при отправке, в
+ * формате выбранного сервера.
+ */
+void Client::drain_send_queue() {
+    const int interactive = lane_scheduler::lane(send_priority::INTERACTIVE);
+    const int bulk = lane_scheduler::lane(send_priority::BULK);
+    bool blocked[lane_scheduler::lane_count] = {};
+    for (;;) {
+        bool ready[lane_scheduler::lane_count];
+        for (int lane = 0; lane < lane_scheduler::lane_count; lane++) {
+            QList<held_message>& queue = this->send_queue[lane];
+            while (!queue.isEmpty() and queue.first().id != 0) {
+                auto waiting = this->in_flight.constFind(queue.first().id);
+                if (waiting != this->in_flight.constEnd() and waiting->held)
+                    break;
+                queue.removeFirst();
+            }
+            ready[lane] = !queue.isEmpty() and !blocked[lane];
+        }
+        if (!ready[interactive] and !ready[bulk])
+            break;
+
+        send_priority chosen = this->send_order.next(ready[interactive], ready[bulk]);
+        QList<held_message>& queue = this->send_queue[lane_scheduler::lane(chosen)];
+        const held_message& next = queue.first();
+        int node = next.node > 0 and this->is_node_available(next.node) ? next.node : 0;
+        // Запрос, ждавший сервер, который стал недоступен, идёт основному уже его полосой
+        send_priority priority = this->lane_for(node, chosen);
+        if (!this->take_send_slot(node, priority)) {
+            blocked[lane_scheduler::lane(chosen)] = true;
+            continue;
+        }
+
+        held_message item = queue.takeFirst();
+        if (item.id == 0) {
+            if (node > 0)
+                this->send_now({item.message}, this->fleet[node].worker, priority);
+            else
+                this->send_primary(item.message, priority);
+            continue;
+        }
+
+        auto request = this->in_flight.find(item.id);
+        request->held = false;
+        this->held_requests--;
+        if (!this->transmit(item.id, *request, node, priority)) {
+            pending_request failed = std::move(*request);
+            this->in_flight.erase(request);
+            this->finish_request(item.id, failed, "error");
+        }
+    }
+
+    if (this->send_refused and this->get_send_queue_size() <= Client::send_queue_limit / 2) {
+        this->send_refused = false;
+        emit this->send_ready();
+    }
+    this->arm_send_timer();
+}
+
+/**
+ * @brief Кодирует запрос в формате, согласованном с сервером
+ * @param id Идентификатор запроса
+ * @param request Запрос
+ * @param node Сервер из списка (0 - основное соединение)
+ * @return Сообщение; пусто, если сервер не принимает пакеты, а запрос - кадр пакета
+ *
+ * Уравнения кодируются binary_codec, если сервер согласовал двоичный
+ * формат, иначе текстом. Идентификатор дописывается к тексту, только
+ * если сервер их согласовал: иначе сервер принял бы его за часть
+ * коэффициентов. Запрос кодируется при каждой отправке, поэтому после
+ * переноса, переключения на резервное соединение или переподключения
+ * он уходит в формате того сервера, который его получает.
+ */
+QByteArray Client::encode_request(quint32 id, const pending_request& request, int node) const {
+    const handshake& features = this->features_of(node);
+    bool batch = !request.positions.isEmpty();
+    QByteArray message;
+    if (batch and !features.batch)
+        return message;
+    if (!request.equations.isEmpty() and features.binary) {
+        if (batch)
+            binary_codec::encode_batch(request.equations, request.positions, id, message);
+        else
+            binary_codec::encode_equation(request.equations.first(), id, message);
+        return message;
+    }
+
+    if (batch) {
+        message.reserve(32 + request.positions.size() * 24);
+        message.append("equation_batch|");
+        for (qsizetype i = 0; i < request.positions.size(); i++) {
+            if (i != 0)
+                message.append(';');
+            request.equations[request.positions[i]].append_to(message);
+        }
+    }
+    else if (!request.equations.isEmpty()) {
+        message.append("equation|");
+        request.equations.first().append_to(message);
+    }
     else {
-        this->socket->write(data);
+        message = request.message;
+    }
+    if (features.request_ids) {
+        message.append('|');
+        message.append(QByteArray::number(id));
+    }
+    return message;
+}
+
+/**
+ * @brief Кодирует запрос для сервера и отправляет его
+ * @param id Идентификатор запроса
+ * @param request Запрос; запоминает сервер и момент отправки
+ * @param node Доступный сервер из списка (0 - основное соединение)
+ * @param priority Полоса очереди отправки сетевой части
+ * @return false если запрос не закодирован или очередь разрыва заполнена
+ */
+bool Client::transmit(quint32 id, pending_request& request, int node, send_priority priority) {
+    request.node = node;
+    request.sent_ns = this->clock.nsecsElapsed();
+    QByteArray message = this->encode_request(id, request, node);
+    if (message.isEmpty())
+        return false;
+    if (node == 0)
+        return this->send_primary(message, priority, id);
+    this->send_now({message}, this->fleet[node].worker, priority);
+    return true;
+}
+
+/**
+ * @brief Передаёт сообщения сетевому потоку без проверки состояния
+ * @param messages Сообщения в UTF-8 или двоичные (binary_codec)
+ * @param target Сетевая часть; по умолчанию основная
+ * @param priority Полоса очереди отправки сетевой части
+ *
+ * Все сообщения передаются одной командой, поэтому сетевой поток
+ * записывает их в сокет одним вызовом. Запросы уже закодированы для
+ * этого сервера (encode_request).
+ */
+void Client::send_now(const QByteArrayList& messages, network_worker* target, send_priority priority) {
+    network_worker* worker = target != nullptr ? target : this->worker;
+    for (const QByteArray& message : messages)
+        this->count_request(message);
+    worker->post(messages, priority);
+}
+
+/**
+ * @brief Отправляет одной пачкой сообщения, накопленные во время разрыва
+ *
+ * Запросы кодируются в формате, согласованном с сервером при
+ * переподключении. Запросы, которые за время разрыва завершились или
+ * перешли к другому серверу списка, пропускаются; кадры пакета, которые
+ * сервер принять не может, завершаются ошибкой.
+ */
+void Client::flush_offline_queue() {
+    if (this->offline_queue.isEmpty())
+        return;
+    LOG_INFO("client", QString("Отправка сообщений, накопленных во время разрыва: %1").arg(this->offline_queue.size()));
+    QList<held_message> queued;
+    queued.swap(this->offline_queue);
+    QByteArrayList messages;
+    messages.reserve(queued.size());
+    QMap<quint32, pending_request> failed;
+    for (const held_message& item : std::as_const(queued)) {
+        if (item.id == 0) {
+            messages.append(item.message);
+            continue;
+        }
+        auto request = this->in_flight.find(item.id);
+        if (request == this->in_flight.end() or request->held or request->node != 0)
+            continue;
+        QByteArray message = this->encode_request(item.id, *request, 0);
+        if (message.isEmpty()) {
+            failed.insert(item.id, std::move(*request));
+            this->in_flight.erase(request);
+            continue;
+        }
+        request->sent_ns = this->clock.nsecsElapsed();
+        messages.append(message);
+    }
+    if (!messages.isEmpty())
+        this->send_now(messages);
+    for (auto request = failed.cbegin(); request != failed.cend(); ++request)
+        this->finish_request(request.key(), request.value(), "error");
+}
+
+/**
+ * @brief Завершает ошибкой запросы из очереди и ожидающие ответа
+ */
+void Client::fail_pending() {
+    this->offline_queue.clear();
+    for (QList<held_message>& queue : this->send_queue)
+        queue.clear();
+    this->held_requests = 0;
+    QMap<quint32, pending_request> aborted;
+    aborted.swap(this->in_flight);
+    for (auto request = aborted.cbegin(); request != aborted.cend(); ++request)
+        this->finish_request(request.key(), request.value(), "error");
+}
+
+/**
+ * @brief Завершает запрос без ответа сервера
+ * @param id Идентификатор запроса
+ * @param request Запрос, уже снятый с ожидания
+ * @param answer Ответ обработчику ("error", "canceled" или "timeout")
+ *
+ * Снимает срок запроса, учитывает исход в метриках и закрывает
+ * асинхронный отрезок запроса в трассировке, как dispatch_answer для
+ * ответов сервера. Без снятия срока колесо хранило бы его до истечения.
+ */
+void Client::finish_request(quint32 id, const pending_request& request, const QString& answer) {
+    if (request.deadline_ms != 0)
+        this->deadlines.remove(id, request.deadline_ms);
+    this->count_answer(answer, false);
+    request.handler(answer, false);
+    trace::async_end("request", id);
+}
+
+/**
+ * @brief Отправляет запрос с идентификатором и ожидает ответ на него
+ * @param text Текст запроса
+ * @param handler Обработчик ответа на этот запрос
+ * @param priority Полоса очереди отправки
+ * @return Идентификатор запроса или 0, если запрос не отправлен
+ */
+quint32 Client::write_request(const QString& text, answer_handler handler, send_priority priority) {
+    QByteArray message = text.toUtf8();
+    equation_request equation;
+    if (this->fleet.size() > 1 and message.startsWith("equation|")
+        and equation_request::parse(QByteArrayView(message).sliced(9), equation)) {
+        quint64 key = Client::route_key(equation);
+        return this->send_request(std::move(message), std::move(handler), qMax(0, this->pick_node(key)), key,
+                                  priority);
+    }
+    return this->send_request(std::move(message), std::move(handler), 0, 0, priority);
+}
+
+/**
+ * @brief Отправляет текстовый запрос и ожидает ответ на него
+ * @param message Сообщение в UTF-8 без идентификатора
+ * @param handler Обработчик ответа на этот запрос
+ * @param node Сервер из списка; недоступный заменяется основным
+ * @param route_key Хеш уравнения для переноса на другой сервер
+ * @param priority Полоса очереди отправки
+ * @return Идентификатор запроса или 0, если запрос не отправлен
+ *
+ * Идентификатор дописывается при каждой отправке, только если его
+ * согласовал получающий сервер (encode_request). Серверу без "ids" запрос
+ * уходит без него, а ответ сопоставляется с самым ранним запросом,
+ * отправленным этому серверу (dispatch_answer). Идентификатор всё равно
+ * выделяется: по нему запрос хранится среди ожидающих.
+ */
+quint32 Client::send_request(QByteArray message, answer_handler handler, int node, quint64 route_key,
+                             send_priority priority) {
+    pending_request request;
+    request.message = std::move(message);
+    request.handler = std::move(handler);
+    request.node = node;
+    request.route_key = route_key;
+    return this->submit(std::move(request), priority);
+}
+
+/**
+ * @brief Отправляет уравнение в формате, согласованном с сервером
+ * @param equation Уравнение
+ * @param handler Обработчик ответа на этот запрос
+ * @param node Сервер из списка; недоступный заменяется основным
+ * @param route_key Хеш уравнения для переноса на другой сервер
+ * @param priority Полоса очереди отправки
+ * @return Идентификатор запроса или 0, если запрос не отправлен
+ *
+ * Формат (двоичный или текстовый) выбирается при каждой отправке по
+ * серверу, который получает запрос (encode_request).
+ */
+quint32 Client::send_equation(const equation_request& equation, answer_handler handler, int node, quint64 route_key,
+                              send_priority priority) {
+    pending_request request;
+    request.equations = {equation};
+    request.handler = std::move(handler);
+    request.node = node;
+    request.route_key = route_key;
+    return this->submit(std::move(request), priority);
+}
+
+/**
+ * @brief Выделяет идентификатор следующего запроса
+ * @return Идентификатор (никогда не 0)
+ */
+quint32 Client::take_request_id() {
+    quint32 id = this->next_request_id++;
+    if (this->next_request_id == 0)
+        this->next_request_id = 1;
+    return id;
+}
+
+/**
+ * @brief Выделяет запросу идентификатор, отправляет его и ожидает ответ
+ * @param request Запрос: сообщение или уравнения, обработчик, сервер из списка и хеш уравнения
+ * @param priority Полоса очереди отправки
+ * @return Идентификатор запроса или 0, если запрос не отправлен
+ *
+ * Запрос, который ограничитель отправки пока не пропускает, ждёт в
+ * своей полосе очереди отправки, но уже числится ожидающим ответа:
+ * его можно отменить, и его срок идёт.
+ */
+quint32 Client::submit(pending_request request, send_priority priority) {
+    quint32 id = this->take_request_id();
+    trace_span span("Client::write", "client");
+    span.set_request(id);
+    trace::async_begin("request", id);
+    request.sent_ns = this->clock.nsecsElapsed();
+    QByteArray type = !request.positions.isEmpty() ? QByteArray("equation_batch")
+                      : !request.equations.isEmpty() ? QByteArray("equation")
+                                                    : Client::message_type(request.message);
+    int timeout = Client::default_deadlines.value(type);
+    if (timeout > 0)
+        request.deadline_ms = this->clock.elapsed() + timeout;
+    if (request.node <= 0 or !this->is_node_available(request.node))
+        request.node = 0;
+    priority = this->lane_for(request.node, priority);
+
+    if (!this->send_queue[lane_scheduler::lane(priority)].isEmpty() or !this->take_send_slot(request.node, priority)) {
+        if (!this->hold(id, QByteArray(), request.node, priority))
+            return 0;
+        request.held = true;
+        this->held_requests++;
+    }
+    else if (!this->transmit(id, request, request.node, priority)) {
+        return 0;
+    }
+    if (request.deadline_ms != 0)
+        this->arm_deadline(id, request.deadline_ms);
+    this->in_flight.insert(id, std::move(request));
+    return id;
+}
+
+/**
+ * @brief Отправляет пакет уравнений и ожидает ответы на все
+ * @param equations Уравнения
+ * @param handler Обработчик, получающий ответы в порядке уравнений
+ * @return true если все кадры пакета отправлены
+ *
+ * Пакет делится на кадры "equation_batch|<вид>|a$b;<вид>|a$b$c;...|<id>"
+ * не более чем по batch_limit уравнений. Сервер отвечает на каждый кадр
+ * сообщением "answer_batch|<ответ>;<ответ>;...|<id>". Обработчик
+ * вызывается один раз, когда получены ответы на все кадры; уравнения
+ * из неотправленных кадров получают ответ "error". Кадр кодируется при
+ * каждой отправке (encode_request), в двоичном формате для серверов,
+ * согласовавших его.
+ *
+ * При списке серверов уравнения сначала группируются по серверам
+ * (pick_node), и каждый сервер получает кадры только со своими
+ * уравнениями, поэтому большой пакет решается всеми серверами сразу.
+ */
+bool Client::solve_batch(const QList<equation_request>& equations, batch_handler handler) {
+    struct batch_state {
+        QStringList answers;
+        qsizetype remaining = 0;
+        batch_handler handler;
+    };
+    auto state = std::make_shared<batch_state>();
+    state->answers.resize(equations.size());
+    state->handler = std::move(handler);
+
+    if (equations.isEmpty()) {
+        state->handler(state->answers);
         return true;
     }
+
+    // Кадр: сервер, хеш первого уравнения (для переноса) и позиции уравнений в пакете
+    struct batch_frame {
+        int node = 0;
+        quint64 route_key = 0;
+        QList<qsizetype> positions;
+    };
+
+    QList<QList<qsizetype>> groups(this->fleet.size());
+    QList<quint64> keys(equations.size(), 0);
+    for (qsizetype i = 0; i < equations.size(); i++) {
+        int node = 0;
+        if (this->fleet.size() > 1) {
+            keys[i] = Client::route_key(equations[i]);
+            node = qMax(0, this->pick_node(keys[i]));
+        }
+        groups[node].append(i);
+    }
+    QList<batch_frame> frames;
+    for (qsizetype node = 0; node < groups.size(); node++) {
+        const QList<qsizetype>& group = groups[node];
+        for (qsizetype first = 0; first < group.size(); first += Client::batch_limit) {
+            batch_frame frame;
+            frame.node = int(node);
+            frame.route_key = keys[group[first]];
+            frame.positions = group.mid(first, Client::batch_limit);
+            frames.append(std::move(frame));
+        }
+    }
+    state->remaining = frames.size();
+
+    // Ответы кадра раскладываются по позициям его уравнений
+    auto complete = [state](const QList<qsizetype>& positions, const QString& answer) {
+        // Ответ без ';' на кадр из нескольких уравнений - состояние всего кадра ("timeout", "canceled")
+        QStringList parts = answer.split(';');
+        for (qsizetype i = 0; i < positions.size(); i++)
+            state->answers[positions[i]] = parts.size() == 1 ? parts[0] : i < parts.size() ? parts[i] : QString("error");
+        if (--state->remaining == 0)
+            state->handler(state->answers);
+    };
+
+    bool sent = true;
+    for (const batch_frame& frame : std::as_const(frames)) {
+        if (!sent) {
+            complete(frame.positions, "error");
+            continue;
+        }
+
+        if (!this->features_of(frame.node).batch) {
+            sent = this->send_singles(equations, frame.positions, frame.node, keys, complete);
+            continue;
+        }
+
+        QList<qsizetype> positions = frame.positions;
+        pending_request request;
+        // Список уравнений общий для всех кадров и не копируется
+        request.equations = equations;
+        request.positions = frame.positions;
+        request.handler = [complete, positions](const QString& answer, bool) {
+            complete(positions, answer);
+        };
+        request.node = frame.node;
+        request.route_key = frame.route_key;
+        sent = this->submit(std::move(request), send_priority::BULK) != 0;
+        if (!sent)
+            complete(frame.positions, "error");
+    }
+    return sent;
+}
+
+/**
+ * @brief Отправляет уравнения кадра пакета отдельными запросами
+ * @param equations Уравнения пакета
+ * @param positions Позиции уравнений кадра в пакете
+ * @param node Сервер из списка
+ * @param keys Хеши уравнений пакета для выбора сервера
+ * @param complete Обработчик ответа на кадр: ответы через ';' в порядке positions
+ * @return true если все запросы отправлены
+ *
+ * Используется для серверов, не согласовавших пакеты (batch) при hello.
+ * Неотправленные уравнения получают ответ "error".
+ */
+bool Client::send_singles(const QList<equation_request>& equations, const QList<qsizetype>& positions, int node,
+                          const QList<quint64>& keys, const frame_handler& complete) {
+    struct frame_state {
+        QStringList answers;
+        qsizetype remaining = 0;
+    };
+    auto state = std::make_shared<frame_state>();
+    state->answers.resize(positions.size());
+    state->remaining = positions.size();
+    auto finish_one = [state, positions, complete](qsizetype index, const QString& answer) {
+        state->answers[index] = answer;
+        if (--state->remaining == 0)
+            complete(positions, state->answers.join(';'));
+    };
+
+    bool sent = true;
+    for (qsizetype i = 0; i < positions.size(); i++) {
+        if (!sent) {
+            finish_one(i, "error");
+            continue;
+        }
+        sent = this->send_equation(equations[positions[i]], [finish_one, i](const QString& answer, bool) {
+            finish_one(i, answer);
+        }, node, keys[positions[i]], send_priority::BULK) != 0;
+        if (!sent)
+            finish_one(i, "error");
+    }
+    return sent;
+}
+
+/**
+ * @brief Решает уравнение на сервере с учётом кэша ответов
+ * @param equation Уравнение
+ * @param handler Обработчик ответа
+ * @param priority Полоса очереди отправки
+ * @return Идентификатор запроса; 0 если ответ взят из кэша или запрос не отправлен
+ */
+quint32 Client::solve(const equation_request& equation, answer_handler handler, send_priority priority) {
+    QString cached;
+    if (this->equation_cache.lookup(equation, cached)) {
+        handler(cached, is_solved(cached));
+        return 0;
+    }
+    if (this->persistent_results.lookup(equation, cached)) {
+        this->equation_cache.insert(equation, cached);
+        handler(cached, is_solved(cached));
+        return 0;
+    }
+
+    quint64 key = 0;
+    int node = 0;
+    if (this->fleet.size() > 1) {
+        key = Client::route_key(equation);
+        node = qMax(0, this->pick_node(key));
+    }
+    return this->send_equation(equation, [this, equation, handler](const QString& answer, bool solved) {
+        if (answer != "error" and answer != "canceled" and answer != "timeout") {
+            this->equation_cache.insert(equation, answer);
+            this->persistent_results.insert(equation, answer);
+        }
+        handler(answer, solved);
+    }, node, key, priority);
+}
+
+/**
+ * @brief Возвращает кэш ответов на уравнения
+ * @return Ссылка на кэш
+ */
+answer_cache& Client::get_cache() {
+    return this->equation_cache;
+}
+
+/**
+ * @brief Асинхронно решает уравнение на сервере
+ * @param equation Уравнение
+ * @param priority Полоса очереди отправки
+ * @return Future, завершающийся при получении ответа на этот запрос
+ *
+ * Отмена future снимает запрос с ожидания: за отменой следит
+ * QFutureWatcher, который удаляется после завершения future.
+ */
+QFuture<solve_result> Client::solve(const equation_request& equation, send_priority priority) {
+    auto promise = std::make_shared<QPromise<solve_result>>();
+    QFuture<solve_result> future = promise->future();
+    promise->start();
+
+    quint32 id = this->solve(equation, [promise](const QString& answer, bool solved) {
+        if (!promise->isCanceled())
+            promise->addResult(solve_result{answer, solved});
+        promise->finish();
+    }, priority);
+    if (future.isFinished()) {
+        // Ответ взят из кэша
+        return future;
+    }
+    if (id == 0) {
+        promise->addResult(solve_result{"error", false});
+        promise->finish();
+        return future;
+    }
+
+    auto* watcher = new QFutureWatcher<solve_result>(this);
+    connect(watcher, &QFutureWatcherBase::canceled, this, [this, id]() {
+        this->cancel(id);
+    });
+    connect(watcher, &QFutureWatcherBase::finished, watcher, &QObject::deleteLater);
+    watcher->setFuture(future);
+    return future;
+}
+
+/**
+ * @brief Асинхронно решает набор уравнений отдельными запросами
+ * @param equations Уравнения
+ * @return Future со списком результатов в порядке уравнений
+ *
+ * Запросы идут пакетной полосой и не задерживают интерактивные.
+ */
+QFuture<QList<solve_result>> Client::solve_all(const QList<equation_request>& equations) {
+    QList<QFuture<solve_result>> futures;
+    futures.reserve(equations.size());
+    for (const equation_request& equation : equations)
+        futures.append(this->solve(equation, send_priority::BULK));
+
+    return QtFuture::whenAll(futures.begin(), futures.end())
+        .then([](const QList<QFuture<solve_result>>& done) {
+            QList<solve_result> results;
+            results.reserve(done.size());
+            for (const QFuture<solve_result>& future : done)
+                results.append(future.resultCount() > 0 ? future.result() : solve_result{"canceled", false});
+            return results;
+        });
+}
+
+/**
+ * @brief Отменяет ожидание ответа на запрос
+ * @param id Идентификатор запроса
+ * @return true если запрос ещё ожидал ответа
+ */
+bool Client::cancel(quint32 id) {
+    pending_request request = this->in_flight.take(id);
+    if (!request.handler)
+        return false;
+    // Запрос из очереди отправки серверу не передавался и просто пропускается
+    if (request.held)
+        this->held_requests--;
+    else
+        this->send_cancel(id, request.node);
+    this->finish_request(id, request, "canceled");
+    if (this->get_send_queue_size() > 0)
+        this->drain_send_queue();
+    return true;
+}
+
+/**
+ * @brief Задаёт срок ожидания ответа на запрос
+ * @param id Идентификатор запроса
+ * @param timeout_ms Срок от текущего момента, мс (0 - ждать без срока)
+ * @return true если запрос ещё ожидал ответа
+ */
+bool Client::set_deadline(quint32 id, int timeout_ms) {
+    auto request = this->in_flight.find(id);
+    if (request == this->in_flight.end())
+        return false;
+    if (request->deadline_ms != 0)
+        this->deadlines.remove(id, request->deadline_ms);
+    request->deadline_ms = timeout_ms > 0 ? this->clock.elapsed() + timeout_ms : 0;
+    if (request->deadline_ms != 0)
+        this->arm_deadline(id, request->deadline_ms);
+    return true;
+}
+
+/**
+ * @brief Задаёт срок ожидания по умолчанию для вида сообщения
+ * @param type Вид сообщения
+ * @param timeout_ms Срок, мс (0 - ждать без срока)
+ */
+void Client::set_default_deadline(const QByteArray& type, int timeout_ms) {
+    Client::default_deadlines.insert(type, qMax(0, timeout_ms));
+}
+
+/**
+ * @brief Возвращает количество запросов, не получивших ответ в срок
+ * @return Количество истёкших сроков с момента запуска
+ */
+qint64 Client::get_timeout_count() const {
+    return this->timeouts;
+}
+
+/**
+ * @brief Ограничивает частоту отправки уравнений и пакетов
+ * @param messages_per_second Сообщений в секунду (0 - без ограничения)
+ * @param burst Сколько сообщений можно отправить подряд после простоя
+ */
+void Client::set_rate_limit(double messages_per_second, int burst) {
+    this->send_rate.configure(messages_per_second, burst);
+    this->send_timer.stop();
+    this->drain_send_queue();
+}
+
+/**
+ * @brief Ограничивает количество запросов, ожидающих ответа
+ * @param requests Наибольшее количество отправленных запросов без ответа (0 - без ограничения)
+ *
+ * Запрос пакета уравнений занимает в окне одно место.
+ */
+void Client::set_in_flight_window(int requests) {
+    Client::in_flight_window = qMax(0, requests);
+    this->drain_send_queue();
+}
+
+/**
+ * @brief Задаёт пороги неотправленных данных каждого соединения
+ * @param high Объём, байт, при котором отправка приостанавливается
+ * @param low Объём, байт, при котором отправка возобновляется
+ *
+ * Неотправленные данные - сообщения, переданные сетевому потоку, и
+ * буфер отправки сокета (QTcpSocket::bytesToWrite). Между порогами
+ * отправка не переключается туда и обратно на каждом сообщении.
+ */
+void Client::set_watermarks(qint64 high, qint64 low) {
+    Client::high_watermark = high;
+    Client::low_watermark = low;
+    this->worker->set_watermarks(high, low);
+    if (this->standby_worker != nullptr)
+        this->standby_worker->set_watermarks(high, low);
+    for (qsizetype i = 1; i < this->fleet.size(); i++)
+        this->fleet[i].worker->set_watermarks(high, low);
+    this->drain_send_queue();
+}
+
+/**
+ * @brief Возвращает количество сообщений в очереди отправки
+ * @return Сообщения, задержанные ограничителем отправки
+ */
+qsizetype Client::get_send_queue_size() const {
+    qsizetype size = 0;
+    for (const QList<held_message>& queue : this->send_queue)
+        size += queue.size();
+    return size;
+}
+
+/**
+ * @brief Возвращает вид сообщения для сроков по умолчанию
+ * @param message Текстовое или двоичное сообщение
+ * @return Первое поле текстового сообщения или вид двоичного запроса
+ */
+QByteArray Client::message_type(QByteArrayView message) {
+    if (binary_codec::is_binary(message))
+        return message[0] == binary_codec::batch_tag ? "equation_batch" : "equation";
+    qsizetype separator = message.indexOf('|');
+    return (separator < 0 ? message : message.first(separator)).toByteArray();
+}
+
+/**
+ * @brief Создаёт метрики и запускает запись файла метрик
+ *
+ * Путь файла задаётся переменной окружения SOLVER_METRICS_FILE; без неё
+ * метрики доступны только через get_metrics.
+ */
+void Client::init_metrics() {
+    static_assert(sizeof(request_types) / sizeof(request_types[0]) == Client::request_type_count);
+    static_assert(sizeof(answer_outcomes) / sizeof(answer_outcomes[0]) == Client::answer_outcome_count);
+    for (int i = 0; i < Client::request_type_count; i++)
+        this->requests_sent[i] = this->metrics.counter("solver_client_requests_total", "Messages sent to servers by type.",
+                                                       QByteArray("type=\"") + request_types[i] + '"');
+    for (int i = 0; i < Client::answer_outcome_count; i++)
+        this->answers_received[i] = this->metrics.counter("solver_client_answers_total",
+                                                          "Equation answers by outcome (batches count every equation).",
+                                                          QByteArray("outcome=\"") + answer_outcomes[i] + '"');
+    this->bytes_out = this->metrics.counter("solver_client_sent_bytes_total", "Bytes written to server connections.");
+    this->bytes_in = this->metrics.counter("solver_client_received_bytes_total", "Bytes read from server connections.");
+    this->reconnects = this->metrics.counter("solver_client_reconnects_total", "Reconnect attempts of the primary connection.");
+    this->failover_total = this->metrics.counter("solver_client_failovers_total", "Switches to the standby connection.");
+    this->in_flight_gauge = this->metrics.gauge("solver_client_in_flight_requests", "Requests waiting for an answer.");
+    this->send_queue_gauge = this->metrics.gauge("solver_client_send_queue_messages", "Messages held by the send limiter.");
+    this->connected_gauge = this->metrics.gauge("solver_client_connected", "Primary connection is established.");
+    this->round_trip = this->metrics.histogram("solver_client_round_trip_seconds",
+                                               "Time from sending a request to receiving its answer.",
+                                               {0.0005, 0.001, 0.0025, 0.005, 0.01, 0.025, 0.05, 0.1, 0.25, 0.5, 1, 2.5, 5, 10});
+
+    this->metrics_path = qEnvironmentVariable(METRICS_FILE_ENVIRONMENT);
+    if (!this->metrics_path.isEmpty()) {
+        connect(&this->metrics_timer, &QTimer::timeout, this, &Client::write_metrics_file);
+        this->metrics_timer.start(Client::metrics_interval_ms);
+    }
+}
+
+/**
+ * @brief Учитывает в метриках отправленное сообщение
+ * @param message Текстовое или двоичное сообщение
+ */
+void Client::count_request(QByteArrayView message) {
+    this->requests_sent[request_type(message)]->add();
+}
+
+/**
+ * @brief Учитывает в метриках ответ на уравнение или пакет
+ * @param answer Ответ; ответы пакета разделены ';'
+ * @param batch Ответ на пакет (каждое уравнение учитывается отдельно)
+ */
+void Client::count_answer(QStringView answer, bool batch) {
+    if (!batch) {
+        this->answers_received[answer_outcome(answer)]->add();
+        return;
+    }
+    for (QStringView part : answer.tokenize(QChar(';')))
+        this->answers_received[answer_outcome(part)]->add();
+}
+
+/**
+ * @brief Обновляет метрики, которые считаются вне Client
+ *
+ * Байты считает сетевой поток; они суммируются по всем соединениям,
+ * поэтому переключение ролей соединений итог не меняет.
+ */
+void Client::collect_metrics() {
+    qint64 sent = this->worker->bytes_sent();
+    qint64 received = this->worker->bytes_received();
+    if (this->standby_worker != nullptr) {
+        sent += this->standby_worker->bytes_sent();
+        received += this->standby_worker->bytes_received();
+    }
+    for (qsizetype i = 1; i < this->fleet.size(); i++) {
+        sent += this->fleet[i].worker->bytes_sent();
+        received += this->fleet[i].worker->bytes_received();
+    }
+    this->bytes_out->advance_to(sent);
+    this->bytes_in->advance_to(received);
+    this->failover_total->advance_to(this->failovers);
+    this->in_flight_gauge->set(double(this->in_flight.size() - this->held_requests));
+    this->send_queue_gauge->set(double(this->get_send_queue_size()));
+    this->connected_gauge->set(this->connected ? 1 : 0);
+}
+
+/**
+ * @brief Записывает метрики в файл metrics_path
+ */
+void Client::write_metrics_file() {
+    this->collect_metrics();
+    if (!this->metrics.write_text_file(this->metrics_path))
+        LOG_WARNING("client", "Не удалось записать файл метрик " + this->metrics_path);
+}
+
+/**
+ * @brief Добавляет срок в колесо и запускает такт колеса
+ * @param id Идентификатор срока
+ * @param deadline_ms Срок по часам clock
+ */
+void Client::arm_deadline(quint32 id, qint64 deadline_ms) {
+    this->deadlines.schedule(id, deadline_ms);
+    if (!this->deadline_timer.isActive())
+        this->deadline_timer.start();
+}
+
+/**
+ * @brief Завершает запросы с истёкшим сроком
+ *
+ * Вызывается тактом колеса. Запрос снимается с ожидания, его обработчик
+ * получает ответ "timeout", а сервер - "cancel|<id>". Если ответ всё же
+ * придёт, он будет отброшен как ответ на неизвестный запрос. Истёкшее
+ * ожидание ответа учётной записи сообщается сигналом server_timeout.
+ * Когда сроков не остаётся, такт останавливается.
+ */
+void Client::check_deadlines() {
+    const QList<quint32> expired = this->deadlines.expire(this->clock.elapsed());
+    for (quint32 id : expired) {
+        auto request = this->in_flight.find(id);
+        if (request != this->in_flight.end()) {
+            pending_request timed_out = std::move(*request);
+            this->in_flight.erase(request);
+            // Срок уже извлечён из колеса
+            timed_out.deadline_ms = 0;
+            this->timeouts++;
+            LOG_WARNING("client", QString("Истёк срок ожидания ответа на запрос %1").arg(id));
+            if (timed_out.held)
+                this->held_requests--;
+            else
+                this->send_cancel(id, timed_out.node);
+            this->finish_request(id, timed_out, "timeout");
+            continue;
+        }
+        for (auto wait = this->account_waits.begin(); wait != this->account_waits.end(); ++wait) {
+            if (wait->id != id)
+                continue;
+            LOG_WARNING("client", "Сервер не ответил на " + QString::fromLatin1(wait.key()));
+            this->account_waits.erase(wait);
+            this->timeouts++;
+            emit this->server_timeout();
+            break;
+        }
+    }
+    if (this->deadlines.size() == 0)
+        this->deadline_timer.stop();
+    if (!expired.isEmpty() and this->get_send_queue_size() > 0)
+        this->drain_send_queue();
+}
+
+/**
+ * @brief Сообщает серверу, что ответ на запрос больше не нужен
+ * @param id Идентификатор запроса
+ * @param node Сервер из списка, которому отправлен запрос
+ *
+ * Отправляется, только если сервер согласовал отмену и соединение с ним
+ * готово: после разрыва сервер запрос всё равно не решает.
+ */
+void Client::send_cancel(quint32 id, int node) {
+    if (!this->is_node_available(node) or !this->features_of(node).cancel)
+        return;
+    this->send_now({"cancel|" + QByteArray::number(id)}, node > 0 ? this->fleet[node].worker : nullptr);
+}
+
+/**
+ * @brief Начинает ожидание ответа на сообщение учётной записи
+ * @param type Вид сообщения ("login", "reg" или "reset")
+ *
+ * Повторное сообщение того же вида заменяет прежнее ожидание.
+ */
+void Client::await_account(const QByteArray& type) {
+    int timeout = Client::default_deadlines.value(type);
+    this->account_answered(type);
+    if (timeout <= 0)
+        return;
+    account_wait wait{this->take_request_id(), this->clock.elapsed() + timeout};
+    this->account_waits.insert(type, wait);
+    this->arm_deadline(wait.id, wait.deadline_ms);
+}
+
+/**
+ * @brief Завершает ожидание ответа на сообщение учётной записи
+ * @param type Вид сообщения, на которое пришёл ответ
+ */
+void Client::account_answered(const QByteArray& type) {
+    auto wait = this->account_waits.find(type);
+    if (wait == this->account_waits.end())
+        return;
+    this->deadlines.remove(wait->id, wait->deadline_ms);
+    this->account_waits.erase(wait);
 }
 
 /**
  * @brief Обработчик отключения от сервера
+ *
+ * Ответы, полученные до разрыва, обрабатываются. Если резервное
+ * соединение готово, запросы переносятся на него. Иначе запросы,
+ * ожидавшие ответа, ставятся в начало очереди и будут отправлены
+ * повторно после переподключения; не поместившиеся в очередь
+ * завершаются ошибкой.
  */
 void Client::disconnect_from_server() {
-    this->socket->close();
-    qDebug() << QString("%1 Произошло отключение от сервера!").arg(clients_func::get_client_time());
+    while (this->inbox_position < this->inbox.size()) {
+        received_message next = this->inbox[this->inbox_position++];
+        this->process_message(next.message, next.node);
+    }
+
+    if (this->standby == link_state::READY) {
+        LOG_WARNING("client", "Произошло отключение от сервера");
+        this->fail_over();
+        return;
+    }
+
+    // Пока повторный вход не завершён, очередь ещё не отправлялась и уже содержит все запросы
+    bool queue_sent = !this->reauthenticating;
+    this->connected = false;
+    this->reauthenticating = false;
+
+    // Уравнения переходят к другим серверам списка, остальное ждёт переподключения
+    this->reroute(0);
+
+    // Уравнения не меняют состояние сервера, поэтому повторная отправка безопасна
+    QList<held_message> resend;
+    QMap<quint32, pending_request> failed;
+    for (auto request = this->in_flight.begin(); queue_sent and request != this->in_flight.end();) {
+        if (request->node != 0 or request->held) {
+            ++request;
+            continue;
+        }
+        if (resend.size() + this->offline_queue.size() < Client::offline_limit) {
+            resend.append(held_message{request.key(), {}, 0, send_priority::BULK});
+            ++request;
+            continue;
+        }
+        failed.insert(request.key(), std::move(*request));
+        request = this->in_flight.erase(request);
+    }
+    this->offline_queue = resend + this->offline_queue;
+    for (auto request = failed.cbegin(); request != failed.cend(); ++request)
+        this->finish_request(request.key(), request.value(), "error");
+
+    LOG_WARNING("client", "Произошло отключение от сервера");
+    this->schedule_reconnect();
 }
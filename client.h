@@ -1,13 +1,35 @@
 #ifndef CLIENT_H
 #define CLIENT_H
 
-#include <QTcpSocket>
 #include <QByteArray>
+#include <QByteArrayList>
 #include <QObject>
 #include <QString>
+#include <QStringList>
+#include <QList>
+#include <QMap>
+#include <QThread>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <QFuture>
+#include "frame_compression.h"
+#include "frame_parser.h"
+#include "endpoint.h"
+#include "equation.h"
+#include "answer_cache.h"
+#include "result_store.h"
+#include "hash_ring.h"
+#include "handshake.h"
+#include "timer_wheel.h"
+#include "token_bucket.h"
+#include "lane_scheduler.h"
+#include "metrics.h"
+#include <QHash>
+#include <functional>
 
-// Предварительное объявление класса Client
+// Предварительные объявления классов
 class Client;
+class network_worker;
 
 /**
  * @brief Класс-разрушитель для управления временем жизни синглтона
@@ -17,15 +39,13 @@ class Client;
 class SingletonDestroyer {
 private:
     static Client* client_connection; ///< Указатель на экземпляр клиента
-    static QTcpSocket* socket;        ///< Указатель на сокет соединения
 
 public:
     /**
      * @brief Инициализация разрушителя
      * @param element Указатель на экземпляр клиента
-     * @param socket Указатель на сокет соединения
      */
-    static void initialize(Client* element, QTcpSocket* socket);
+    static void initialize(Client* element);
 
     /**
      * @brief Деструктор разрушителя
@@ -41,20 +61,258 @@ public:
 /**
  * @brief Класс клиентского соединения (реализация Singleton)
  *
- * Обеспечивает взаимодействие с сервером через TCP-соединение
+ * Обеспечивает взаимодействие с сервером через TCP-соединение или
+ * локальный сокет (см. endpoint::configured). Сокет обслуживается объектом network_worker в отдельном потоке,
+ * Client живёт в потоке интерфейса и обрабатывает разобранные ответы.
+ *
+ * Если настроено резервное соединение (endpoint::configured_standby),
+ * второй network_worker заранее подключается и входит под той же учётной
+ * записью. При разрыве основного соединения запросы, ожидающие ответа,
+ * и очередь сразу переносятся на резервное, а основное переподключается
+ * и становится резервным.
+ *
+ * Если в настройке перечислено несколько серверов (endpoint::configured_fleet),
+ * к каждому открывается своё соединение. Уравнения распределяются между
+ * серверами согласованным хешированием нормализованного уравнения, поэтому
+ * одно и то же уравнение всегда решает один сервер и его кэш остаётся
+ * горячим. Разорванные и медленные серверы временно исключаются, их
+ * запросы переходят к следующим серверам на кольце. Регистрация и вход
+ * выполняются через первый сервер списка.
+ *
+ * Уравнения и пакеты проходят через ограничитель отправки: корзину
+ * маркеров (set_rate_limit), окно запросов, ожидающих ответа
+ * (set_in_flight_window), и пороги неотправленных данных сетевой части
+ * (set_watermarks). Сообщения, которые нельзя отправить сразу, ждут в
+ * ограниченной очереди отправки; когда она заполнена, write и solve
+ * возвращают отказ, а после освобождения испускается send_ready.
+ *
+ * Очередь отправки клиента и сетевой части разделена на полосы
+ * (send_priority): одиночные уравнения пользователя идут интерактивной
+ * полосой, пакеты и write - пакетной. Полосы чередуются по весам
+ * (lane_scheduler), а окно запросов и корзина маркеров ограничивают
+ * только пакетную, поэтому задержка интерактивного запроса не растёт,
+ * пока пакет занимает всё соединение. Серверу без идентификаторов
+ * запросов все запросы идут пакетной полосой: его ответы сопоставляются
+ * с запросами по порядку отправки.
+ *
+ * Client ведёт метрики (get_metrics): отправленные сообщения по виду,
+ * ответы на уравнения по исходу, байты соединений, переподключения и
+ * гистограмму времени от отправки запроса до ответа. Если задана
+ * переменная окружения SOLVER_METRICS_FILE, метрики раз в
+ * metrics_interval_ms записываются в этот файл в текстовом формате
+ * Prometheus (для textfile collector node exporter).
  */
 class Client: public QObject
 {
     Q_OBJECT
 
 public:
+    /**
+     * @brief Обработчик ответа на запрос
+     * @param answer Ответ сервера (решение или описание ошибки)
+     * @param solved true если уравнение решено, false если сервер вернул ошибку
+     */
+    using answer_handler = std::function<void(const QString& answer, bool solved)>;
+
+    /**
+     * @brief Обработчик ответа на пакет уравнений
+     * @param answers Ответы сервера в порядке уравнений пакета
+     */
+    using batch_handler = std::function<void(const QStringList& answers)>;
+
     /**
      * @brief Отправляет сообщение серверу
      * @param text Текст сообщения
-     * @return true если сообщение отправлено успешно, false в случае ошибки
+     * @return true если сообщение отправлено или поставлено в очередь
+     *         до восстановления соединения, false в случае ошибки
+     *         или заполненной очереди отправки (см. send_ready)
      */
     bool write(QString text);
 
+    /**
+     * @brief Отправляет запрос с идентификатором и ожидает ответ на него
+     * @param text Текст запроса (например, "equation|linear|3$6")
+     * @param handler Обработчик, вызываемый при получении ответа на этот запрос
+     * @param priority Полоса очереди отправки
+     * @return Идентификатор запроса или 0, если запрос не отправлен
+     *
+     * К запросу дописывается поле "|<id>", сервер повторяет его в ответе
+     * "answer|<решение>|<id>". Одновременно может выполняться любое
+     * количество запросов.
+     */
+    quint32 write_request(const QString& text, answer_handler handler, send_priority priority = send_priority::BULK);
+
+    /**
+     * @brief Отправляет пакет уравнений одним или несколькими кадрами
+     * @param equations Уравнения
+     * @param handler Обработчик, получающий ответы в порядке уравнений
+     * @return true если весь пакет отправлен
+     */
+    bool solve_batch(const QList<equation_request>& equations, batch_handler handler);
+
+    /**
+     * @brief Решает уравнение на сервере с учётом кэша ответов
+     * @param equation Уравнение
+     * @param handler Обработчик ответа
+     * @param priority Полоса очереди отправки: по умолчанию запрос
+     *        пользователя, который не ждёт за пакетами
+     * @return Идентификатор запроса; 0 если ответ взят из кэша
+     *         (обработчик уже вызван) или запрос не отправлен
+     *
+     * Ответ ищется сначала в кэше в памяти, затем в постоянном
+     * хранилище. При попадании обработчик вызывается синхронно, сокет
+     * не используется. Ответы сервера сохраняются в оба кэша. Если
+     * сервер согласовал двоичный формат, уравнение передаётся в нём.
+     */
+    quint32 solve(const equation_request& equation, answer_handler handler,
+                  send_priority priority = send_priority::INTERACTIVE);
+
+    /**
+     * @brief Возвращает кэш ответов на уравнения
+     * @return Ссылка на кэш (ёмкость, счётчики попаданий и промахов)
+     */
+    answer_cache& get_cache();
+
+    /**
+     * @brief Асинхронно решает уравнение на сервере
+     * @param equation Уравнение
+     * @param priority Полоса очереди отправки
+     * @return Future, завершающийся при получении ответа именно на этот запрос
+     *
+     * Поддерживает продолжения (then/onFailed), отмену через
+     * QFuture::cancel() и объединение через QtFuture::whenAll.
+     * Продолжения без контекста выполняются в потоке интерфейса.
+     */
+    QFuture<solve_result> solve(const equation_request& equation, send_priority priority = send_priority::INTERACTIVE);
+
+    /**
+     * @brief Асинхронно решает набор уравнений отдельными запросами
+     * @param equations Уравнения
+     * @return Future со списком результатов в порядке уравнений
+     *
+     * Отменённые запросы получают результат с ответом "canceled".
+     */
+    QFuture<QList<solve_result>> solve_all(const QList<equation_request>& equations);
+
+    /**
+     * @brief Отменяет ожидание ответа на запрос
+     * @param id Идентификатор запроса
+     * @return true если запрос ещё ожидал ответа
+     *
+     * Обработчик запроса вызывается с ответом "canceled". Если сервер
+     * поддерживает отмену, ему отправляется "cancel|<id>".
+     */
+    bool cancel(quint32 id);
+
+    /**
+     * @brief Задаёт срок ожидания ответа на запрос
+     * @param id Идентификатор запроса
+     * @param timeout_ms Срок от текущего момента, мс (0 - ждать без срока)
+     * @return true если запрос ещё ожидал ответа
+     *
+     * Заменяет срок по умолчанию для вида сообщения. По истечении срока
+     * обработчик запроса вызывается с ответом "timeout", а сервер, если
+     * поддерживает отмену, получает "cancel|<id>".
+     */
+    bool set_deadline(quint32 id, int timeout_ms);
+
+    /**
+     * @brief Задаёт срок ожидания по умолчанию для вида сообщения
+     * @param type Вид сообщения: "equation", "equation_batch", "login", "reg" или "reset"
+     * @param timeout_ms Срок, мс (0 - ждать без срока)
+     *
+     * Применяется к сообщениям, отправленным после вызова.
+     */
+    static void set_default_deadline(const QByteArray& type, int timeout_ms);
+
+    /**
+     * @brief Возвращает количество запросов, не получивших ответ в срок
+     * @return Количество истёкших сроков с момента запуска
+     */
+    qint64 get_timeout_count() const;
+
+    /**
+     * @brief Ограничивает частоту отправки уравнений и пакетов
+     * @param messages_per_second Сообщений в секунду (0 - без ограничения)
+     * @param burst Сколько сообщений можно отправить подряд после простоя
+     */
+    void set_rate_limit(double messages_per_second, int burst);
+
+    /**
+     * @brief Ограничивает количество запросов, ожидающих ответа
+     * @param requests Наибольшее количество отправленных запросов без ответа (0 - без ограничения)
+     */
+    void set_in_flight_window(int requests);
+
+    /**
+     * @brief Задаёт пороги неотправленных данных каждого соединения
+     * @param high Объём, байт, при котором отправка приостанавливается
+     * @param low Объём, байт, при котором отправка возобновляется
+     */
+    void set_watermarks(qint64 high, qint64 low);
+
+    /**
+     * @brief Возвращает количество сообщений в очереди отправки
+     * @return Сообщения, задержанные ограничителем отправки
+     */
+    qsizetype get_send_queue_size() const;
+
+    /**
+     * @brief Проверяет наличие подключения к серверу
+     * @return true если соединение установлено
+     */
+    bool is_connected() const;
+
+    /**
+     * @brief Возвращает адрес сервера
+     * @return Адрес из командной строки, окружения, client.ini или адрес по умолчанию
+     */
+    const endpoint& get_server_address() const;
+
+    /**
+     * @brief Проверяет готовность резервного соединения
+     * @return true если резервное соединение подключено и вход на нём выполнен
+     */
+    bool is_standby_ready() const;
+
+    /**
+     * @brief Возвращает возможности протокола, согласованные с сервером
+     * @return Возможности основного соединения; handshake() для старого
+     *         сервера или до подключения
+     */
+    const handshake& get_server_features() const;
+
+    /**
+     * @brief Возвращает количество серверов в списке
+     * @return Количество серверов (не меньше одного)
+     */
+    int get_fleet_size() const;
+
+    /**
+     * @brief Проверяет, получает ли сервер из списка уравнения
+     * @param node Номер сервера в списке
+     * @return true если соединение готово и сервер не исключён как медленный
+     */
+    bool is_node_available(int node) const;
+
+    /**
+     * @brief Возвращает количество переключений на резервное соединение
+     * @return Количество переключений с момента запуска
+     */
+    int get_failover_count() const;
+
+    /**
+     * @brief Возвращает счётчики сжатия всех соединений
+     * @return Сумма счётчиков: степень сжатия (ratio) и время сжатия и распаковки
+     */
+    compression_stats get_compression_stats() const;
+
+    /**
+     * @brief Возвращает метрики клиента
+     * @return Текстовый формат Prometheus
+     */
+    QByteArray get_metrics();
+
     /**
      * @brief Возвращает единственный экземпляр клиента
      * @return Указатель на экземпляр Client
@@ -67,15 +325,525 @@ public:
     ~Client();
 
 private:
-    static QTcpSocket* socket;    ///< Сокет для соединения с сервером
     static Client* p_instance;    ///< Единственный экземпляр клиента
-    static int port;             ///< Порт для подключения
+    static framing preferred_framing; ///< Режим кадрирования, запрашиваемый у сервера
+    static int batch_limit;           ///< Максимальное количество уравнений в одном кадре пакета
+
+    static int inbox_slice;           ///< Количество ответов, обрабатываемых за одну итерацию цикла событий
+    static int offline_limit;         ///< Максимальное количество сообщений в очереди на время разрыва
+    static int reconnect_base_ms;     ///< Задержка первой попытки переподключения
+    static int reconnect_max_ms;      ///< Максимальная задержка между попытками переподключения
+    static int slow_node_ms;          ///< Задержка ответа, после которой сервер считается медленным
+    static int eject_ms;              ///< Время исключения медленного сервера из распределения
+    static int health_interval_ms;    ///< Период проверки серверов списка
+    static int metrics_interval_ms;   ///< Период записи файла метрик
+    static int compression_threshold; ///< Минимальный размер сжимаемого сообщения, байт (0 - не сжимать)
+    static QHash<QByteArray, int> default_deadlines; ///< Срок ожидания ответа по виду сообщения, мс (0 - без срока)
+    static int send_queue_limit;      ///< Максимальное количество сообщений в очереди отправки
+    static int in_flight_window;      ///< Максимальное количество отправленных запросов без ответа (0 - без ограничения)
+    static qint64 high_watermark;     ///< Объём неотправленных данных соединения, при котором отправка приостанавливается
+    static qint64 low_watermark;      ///< Объём неотправленных данных соединения, при котором отправка возобновляется
+
+    /**
+     * @brief Состояние дополнительного соединения (резервного или к серверу из списка)
+     */
+    enum class link_state {
+        DOWN,           ///< Нет соединения
+        CONNECTED,      ///< Соединение есть, вход не выполнен или отклонён
+        AUTHENTICATING, ///< Ожидается ответ на вход
+        READY,          ///< Можно переключаться
+    };
+
+    /**
+     * @brief Запрос, ожидающий ответа
+     */
+    struct pending_request {
+        QByteArray message;     ///< Текст запроса без идентификатора (пусто для уравнений из equations)
+        QList<equation_request> equations; ///< Уравнения запроса (для кадра пакета - весь пакет)
+        QList<qsizetype> positions; ///< Позиции уравнений кадра пакета в equations (пусто - не пакет)
+        answer_handler handler; ///< Обработчик ответа
+        int node = 0;           ///< Сервер из списка, которому отправлен запрос
+        quint64 route_key = 0;  ///< Хеш уравнения для выбора сервера (0 - только первый сервер)
+        qint64 sent_ns = 0;     ///< Момент отправки по часам clock
+        qint64 deadline_ms = 0; ///< Срок ответа по часам clock (0 - без срока)
+        bool held = false;      ///< Запрос ещё в очереди отправки
+    };
+
+    /**
+     * @brief Сообщение, задержанное ограничителем отправки
+     */
+    struct held_message {
+        quint32 id = 0;         ///< Идентификатор запроса (0 - сообщение без ожидания ответа)
+        QByteArray message;     ///< Сообщение (пусто для запроса: он кодируется при отправке)
+        int node = 0;           ///< Сервер из списка
+        send_priority priority = send_priority::BULK; ///< Полоса
+    };
+
+    /**
+     * @brief Полученное, но ещё не обработанное сообщение сервера
+     */
+    struct received_message {
+        QByteArray message;     ///< Содержимое кадра
+        int node = 0;           ///< Сервер из списка, приславший сообщение
+    };
+
+    /**
+     * @brief Ожидание ответа на сообщение учётной записи (вход, регистрация, сброс)
+     */
+    struct account_wait {
+        quint32 id = 0;         ///< Идентификатор срока в колесе (на сервер не передаётся)
+        qint64 deadline_ms = 0; ///< Срок ответа по часам clock
+    };
+
+    /**
+     * @brief Сервер из списка
+     *
+     * Нулевой сервер обслуживается основным соединением (worker),
+     * остальные - собственными соединениями.
+     */
+    struct fleet_node {
+        endpoint address;                        ///< Адрес сервера
+        network_worker* worker = nullptr;        ///< Сетевая часть (пустая у нулевого сервера)
+        link_state state = link_state::DOWN;     ///< Состояние соединения
+        QTimer* retry = nullptr;                 ///< Таймер следующей попытки подключения
+        int attempt = 0;                         ///< Номер попытки подключения подряд
+        double latency_ms = 0;                   ///< Скользящее среднее задержки ответа
+        qint64 ejected_until_ms = 0;             ///< Сервер исключён до этого момента по часам clock
+        handshake features;                      ///< Согласованные возможности протокола
+    };
+
+    endpoint server_address;           ///< Адрес сервера
+    handshake server_features;         ///< Возможности, согласованные с сервером
+    QThread network_thread;            ///< Поток сетевого ввода-вывода
+    network_worker* worker = nullptr; ///< Сетевая часть клиента (живёт в network_thread)
+    bool connected = false;            ///< Соединение с сервером установлено
+    bool reauthenticating = false;     ///< После переподключения ожидается ответ на повторный вход
+    QByteArray pending_login;          ///< Последнее отправленное сообщение входа
+    QByteArray session_login;          ///< Сообщение входа, принятое сервером (для повторного входа)
+    QList<held_message> offline_queue; ///< Сообщения, отправленные во время разрыва
+    QTimer reconnect_timer;            ///< Таймер следующей попытки подключения
+    int reconnect_attempt = 0;         ///< Номер попытки переподключения подряд
+
+    bool standby_enabled = false;                      ///< Резервное соединение настроено
+    endpoint standby_address;                          ///< Адрес резервного соединения
+    handshake standby_features;                        ///< Возможности, согласованные по резервному соединению
+    network_worker* standby_worker = nullptr;          ///< Сетевая часть резервного соединения (живёт в network_thread)
+    link_state standby = link_state::DOWN;       ///< Состояние резервного соединения
+    QTimer standby_timer;                              ///< Таймер следующей попытки подключения резервного соединения
+    int standby_attempt = 0;                           ///< Номер попытки подключения резервного соединения подряд
+    int failovers = 0;                                 ///< Количество переключений на резервное соединение
+
+    QList<fleet_node> fleet;           ///< Серверы из списка (нулевой - основной)
+    hash_ring ring;                    ///< Кольцо согласованного хеширования серверов
+    QElapsedTimer clock;               ///< Часы задержек и исключения серверов
+    QTimer health_timer;               ///< Таймер проверки серверов
+
+    QList<received_message> inbox;     ///< Полученные, но ещё не обработанные ответы
+    qsizetype inbox_position = 0;      ///< Первый необработанный ответ в inbox
+    bool inbox_scheduled = false;      ///< Обработка inbox запланирована
+
+    quint32 next_request_id = 1;              ///< Идентификатор следующего запроса
+    QMap<quint32, pending_request> in_flight; ///< Запросы, ожидающие ответа (по возрастанию id)
+    timer_wheel deadlines;                    ///< Сроки ожидания ответов
+    QTimer deadline_timer;                    ///< Такт колеса сроков (работает, пока есть сроки)
+    QHash<QByteArray, account_wait> account_waits; ///< Ожидаемые ответы учётной записи по виду сообщения
+    qint64 timeouts = 0;                      ///< Количество истёкших сроков
+    token_bucket send_rate;                   ///< Ограничение частоты отправки
+    QList<held_message> send_queue[lane_scheduler::lane_count]; ///< Сообщения, ожидающие разрешения на отправку (по send_priority)
+    lane_scheduler send_order;                ///< Чередование полос send_queue
+    qsizetype held_requests = 0;              ///< Запросы из in_flight, ещё стоящие в send_queue
+    QTimer send_timer;                        ///< Ожидание следующего маркера send_rate
+    bool send_refused = false;                ///< Сообщение отклонено из-за заполненной send_queue
+    answer_cache equation_cache;              ///< Кэш ответов на уравнения
+    result_store persistent_results;          ///< Ответы, сохранённые между запусками
+
+    static constexpr int request_type_count = 7;  ///< Видов сообщений в метриках (см. request_type)
+    static constexpr int answer_outcome_count = 6; ///< Исходов ответа в метриках (см. answer_outcome)
+    metrics_registry metrics;                     ///< Метрики клиента
+    metric_counter* requests_sent[request_type_count] = {};     ///< Отправленные сообщения по виду
+    metric_counter* answers_received[answer_outcome_count] = {}; ///< Ответы на уравнения по исходу
+    metric_counter* bytes_out = nullptr;          ///< Байт, записанных во все соединения
+    metric_counter* bytes_in = nullptr;           ///< Байт, прочитанных из всех соединений
+    metric_counter* reconnects = nullptr;         ///< Попыток переподключения основного соединения
+    metric_counter* failover_total = nullptr;     ///< Переключений на резервное соединение
+    metric_gauge* in_flight_gauge = nullptr;      ///< Запросов, ожидающих ответа
+    metric_gauge* send_queue_gauge = nullptr;     ///< Сообщений в очереди отправки
+    metric_gauge* connected_gauge = nullptr;      ///< Основное соединение установлено (0 или 1)
+    latency_histogram* round_trip = nullptr;      ///< Время от отправки запроса до ответа
+    QString metrics_path;                         ///< Файл метрик (пустой - не записывается)
+    QTimer metrics_timer;                         ///< Таймер записи файла метрик
 
     /**
      * @brief Приватный конструктор
      */
     Client();
 
+    /**
+     * @brief Подключает сигналы сетевой части к обработчикам клиента
+     * @param worker Основная или резервная сетевая часть
+     *
+     * Роль сетевой части проверяется в момент доставки сигнала, поэтому
+     * после переключения те же соединения обслуживают новые роли.
+     */
+    void attach(network_worker* worker);
+
+    /**
+     * @brief Вычисляет задержку очередной попытки подключения
+     * @param attempt Номер попытки подряд
+     * @return Задержка, мс
+     */
+    static int backoff_delay(int attempt);
+
+    /**
+     * @brief Выполняет вход на резервном соединении под текущей учётной записью
+     */
+    void login_standby();
+
+    /**
+     * @brief Отмечает резервное соединение готовым
+     *
+     * Если основное соединение в этот момент разорвано, сразу
+     * выполняется переключение.
+     */
+    void standby_ready();
+
+    /**
+     * @brief Переносит запросы на резервное соединение и меняет соединения ролями
+     */
+    void fail_over();
+
+    /**
+     * @brief Находит номер сервера из списка по его сетевой части
+     * @param worker Сетевая часть
+     * @return Номер сервера или -1
+     */
+    int node_of(const network_worker* worker) const;
+
+    /**
+     * @brief Возвращает возможности протокола, согласованные с сервером из списка
+     * @param node Номер сервера
+     * @return Возможности соединения с сервером
+     */
+    const handshake& features_of(int node) const;
+
+    /**
+     * @brief Выбирает сервер для уравнения
+     * @param key Хеш нормализованного уравнения
+     * @param exclude Сервер, который нельзя выбирать (-1 - любой)
+     * @return Номер сервера или -1, если ни один сервер не доступен
+     */
+    int pick_node(quint64 key, int exclude = -1) const;
+
+    /**
+     * @brief Отправляет запросы, ожидающие ответа от сервера, другим серверам
+     * @param node Сервер из списка
+     *
+     * Запросы, которые некуда перенести, остаются за сервером; запросы
+     * отключившегося дополнительного сервера в этом случае отправляются
+     * через основное соединение.
+     */
+    void reroute(int node);
+
+    /**
+     * @brief Выполняет вход на всех соединениях с серверами из списка
+     */
+    void login_fleet();
+
+    /**
+     * @brief Обработчик подключения к серверу из списка
+     * @param node Номер сервера
+     */
+    void node_connected(int node);
+
+    /**
+     * @brief Обработчик разрыва соединения с сервером из списка
+     * @param node Номер сервера
+     */
+    void node_lost(int node);
+
+    /**
+     * @brief Планирует следующую попытку подключения к серверу из списка
+     * @param node Номер сервера
+     */
+    void schedule_node(int node);
+
+    /**
+     * @brief Начинает попытку подключения к серверу из списка
+     * @param node Номер сервера
+     */
+    void reconnect_node(int node);
+
+    /**
+     * @brief Принимает сообщения сервера из списка
+     * @param node Номер сервера
+     * @param messages Содержимое полученных кадров
+     *
+     * Ответ на вход обрабатывается здесь, ответы на уравнения
+     * передаются в общую очередь receive.
+     */
+    void receive_node(int node, const QByteArrayList& messages);
+
+    /**
+     * @brief Исключает медленные серверы из распределения и возвращает восстановившиеся
+     */
+    void check_fleet();
+
+    /**
+     * @brief Обрабатывает одно сообщение сервера
+     * @param message Содержимое кадра
+     * @param node Сервер из списка, приславший сообщение
+     */
+    void process_message(QByteArrayView message, int node);
+
+    /**
+     * @brief Направляет ответ на уравнение отправителю запроса
+     * @param fields Поля сообщения "answer|<решение>[|<id>]"
+     * @param node Сервер из списка, приславший ответ
+     */
+    void dispatch_answer(const QStringList& fields, int node);
+
+    /**
+     * @brief Отправляет серверу уже закодированное сообщение
+     * @param data Сообщение в UTF-8
+     * @return true если сообщение отправлено успешно
+     */
+    bool write_bytes(const QByteArray& data);
+
+    /**
+     * @brief Отправляет сообщение через основное соединение или в очередь разрыва
+     * @param data Сообщение в UTF-8 или двоичное
+     * @param priority Полоса очереди отправки сетевой части
+     * @param id Идентификатор запроса (0 - сообщение без ожидания ответа)
+     * @return false если нет соединения и очередь разрыва заполнена
+     */
+    bool send_primary(const QByteArray& data, send_priority priority = send_priority::BULK, quint32 id = 0);
+
+    /**
+     * @brief Проверяет, проходит ли сообщение через ограничитель отправки
+     * @param message Сообщение
+     * @return true для уравнений и пакетов
+     */
+    static bool is_limited(QByteArrayView message);
+
+    /**
+     * @brief Возвращает сетевую часть сервера из списка
+     * @param node Номер сервера (0 - основное соединение)
+     * @return Сетевая часть
+     */
+    network_worker* worker_of(int node) const;
+
+    /**
+     * @brief Возвращает полосу, которой запрос идёт к серверу
+     * @param node Сервер из списка (0 - основное соединение)
+     * @param priority Запрошенная полоса
+     * @return priority; BULK, если сервер не согласовал идентификаторы запросов
+     */
+    send_priority lane_for(int node, send_priority priority) const;
+
+    /**
+     * @brief Проверяет ограничения и забирает разрешение на одну отправку
+     * @param node Сервер из списка, которому предназначено сообщение
+     * @param priority Полоса сообщения
+     * @return true если сообщение можно отправить сейчас
+     */
+    bool take_send_slot(int node, send_priority priority);
+
+    /**
+     * @brief Ставит сообщение в очередь отправки
+     * @param id Идентификатор запроса (0 - без ожидания ответа)
+     * @param message Сообщение (пусто для запроса)
+     * @param node Сервер из списка
+     * @param priority Полоса сообщения
+     * @return false если очередь отправки заполнена
+     */
+    bool hold(quint32 id, const QByteArray& message, int node, send_priority priority);
+
+    /**
+     * @brief Запускает ожидание маркера, если пакетная полоса ждёт только его
+     */
+    void arm_send_timer();
+
+    /**
+     * @brief Отправляет сообщения из очереди отправки, пока ограничения позволяют
+     */
+    void drain_send_queue();
+
+    /**
+     * @brief Кодирует запрос в формате, согласованном с сервером
+     * @param id Идентификатор запроса
+     * @param request Запрос
+     * @param node Сервер из списка (0 - основное соединение)
+     * @return Сообщение; пусто, если сервер не принимает пакеты, а запрос - кадр пакета
+     */
+    QByteArray encode_request(quint32 id, const pending_request& request, int node) const;
+
+    /**
+     * @brief Кодирует запрос для сервера и отправляет его
+     * @param id Идентификатор запроса
+     * @param request Запрос; запоминает сервер и момент отправки
+     * @param node Доступный сервер из списка (0 - основное соединение)
+     * @param priority Полоса очереди отправки сетевой части
+     * @return false если запрос не закодирован или очередь разрыва заполнена
+     */
+    bool transmit(quint32 id, pending_request& request, int node, send_priority priority);
+
+    /**
+     * @brief Передаёт сообщения сетевому потоку без проверки состояния
+     * @param messages Сообщения в UTF-8 или двоичные (binary_codec)
+     * @param target Сетевая часть; по умолчанию основная
+     * @param priority Полоса очереди отправки сетевой части
+     */
+    void send_now(const QByteArrayList& messages, network_worker* target = nullptr,
+                  send_priority priority = send_priority::BULK);
+
+    /**
+     * @brief Отправляет одной пачкой сообщения, накопленные во время разрыва
+     */
+    void flush_offline_queue();
+
+    /**
+     * @brief Завершает ошибкой запросы из очереди и ожидающие ответа
+     */
+    void fail_pending();
+
+    /**
+     * @brief Завершает запрос без ответа сервера
+     * @param id Идентификатор запроса
+     * @param request Запрос, уже снятый с ожидания
+     * @param answer Ответ обработчику ("error", "canceled" или "timeout")
+     */
+    void finish_request(quint32 id, const pending_request& request, const QString& answer);
+
+    /**
+     * @brief Отправляет текстовый запрос и ожидает ответ на него
+     * @param message Сообщение в UTF-8 без идентификатора
+     * @param handler Обработчик ответа на этот запрос
+     * @param node Сервер из списка (pick_node); недоступный заменяется основным
+     * @param route_key Хеш уравнения для переноса на другой сервер (0 - не переносить)
+     * @param priority Полоса очереди отправки
+     * @return Идентификатор запроса или 0, если запрос не отправлен
+     */
+    quint32 send_request(QByteArray message, answer_handler handler, int node = 0, quint64 route_key = 0,
+                         send_priority priority = send_priority::BULK);
+
+    /**
+     * @brief Отправляет уравнение в формате, согласованном с сервером
+     * @param equation Уравнение
+     * @param handler Обработчик ответа на этот запрос
+     * @param node Сервер из списка (pick_node); недоступный заменяется основным
+     * @param route_key Хеш уравнения для переноса на другой сервер (0 - не переносить)
+     * @param priority Полоса очереди отправки
+     * @return Идентификатор запроса или 0, если запрос не отправлен
+     */
+    quint32 send_equation(const equation_request& equation, answer_handler handler, int node, quint64 route_key,
+                          send_priority priority);
+
+    /**
+     * @brief Выделяет идентификатор следующего запроса
+     * @return Идентификатор (никогда не 0)
+     */
+    quint32 take_request_id();
+
+    /**
+     * @brief Выделяет запросу идентификатор, отправляет его и ожидает ответ
+     * @param request Запрос: сообщение или уравнения, обработчик, сервер из списка и хеш уравнения
+     * @param priority Полоса очереди отправки
+     * @return Идентификатор запроса или 0, если запрос не отправлен
+     */
+    quint32 submit(pending_request request, send_priority priority);
+
+    /**
+     * @brief Возвращает вид сообщения для сроков по умолчанию
+     * @param message Текстовое или двоичное сообщение
+     * @return "equation", "equation_batch", "login" и т. п.
+     */
+    static QByteArray message_type(QByteArrayView message);
+
+    /**
+     * @brief Создаёт метрики и запускает запись файла метрик
+     */
+    void init_metrics();
+
+    /**
+     * @brief Учитывает в метриках отправленное сообщение
+     * @param message Текстовое или двоичное сообщение
+     */
+    void count_request(QByteArrayView message);
+
+    /**
+     * @brief Учитывает в метриках ответ на уравнение или пакет
+     * @param answer Ответ; ответы пакета разделены ';'
+     * @param batch Ответ на пакет (каждое уравнение учитывается отдельно)
+     */
+    void count_answer(QStringView answer, bool batch);
+
+    /**
+     * @brief Обновляет метрики, которые считаются вне Client
+     */
+    void collect_metrics();
+
+    /**
+     * @brief Записывает метрики в файл metrics_path
+     */
+    void write_metrics_file();
+
+    /**
+     * @brief Добавляет срок в колесо и запускает такт колеса
+     * @param id Идентификатор срока
+     * @param deadline_ms Срок по часам clock
+     */
+    void arm_deadline(quint32 id, qint64 deadline_ms);
+
+    /**
+     * @brief Завершает запросы с истёкшим сроком
+     */
+    void check_deadlines();
+
+    /**
+     * @brief Сообщает серверу, что ответ на запрос больше не нужен
+     * @param id Идентификатор запроса
+     * @param node Сервер из списка, которому отправлен запрос
+     */
+    void send_cancel(quint32 id, int node);
+
+    /**
+     * @brief Начинает ожидание ответа на сообщение учётной записи
+     * @param type Вид сообщения ("login", "reg" или "reset")
+     */
+    void await_account(const QByteArray& type);
+
+    /**
+     * @brief Завершает ожидание ответа на сообщение учётной записи
+     * @param type Вид сообщения, на которое пришёл ответ
+     */
+    void account_answered(const QByteArray& type);
+
+    /**
+     * @brief Обработчик ответа на кадр пакета
+     * @param positions Позиции уравнений кадра в пакете
+     * @param answer Ответы через ';' в порядке positions
+     */
+    using frame_handler = std::function<void(const QList<qsizetype>& positions, const QString& answer)>;
+
+    /**
+     * @brief Отправляет уравнения кадра пакета отдельными запросами
+     * @param equations Уравнения пакета
+     * @param positions Позиции уравнений кадра в пакете
+     * @param node Сервер из списка
+     * @param keys Хеши уравнений пакета для выбора сервера
+     * @param complete Обработчик ответа на кадр
+     * @return true если все запросы отправлены
+     */
+    bool send_singles(const QList<equation_request>& equations, const QList<qsizetype>& positions, int node,
+                      const QList<quint64>& keys, const frame_handler& complete);
+
+    /**
+     * @brief Вычисляет хеш нормализованного уравнения для выбора сервера
+     * @param equation Уравнение
+     * @return Хеш, одинаковый для уравнений с одним ответом
+     */
+    static quint64 route_key(const equation_request& equation);
+
     static SingletonDestroyer el; ///< Объект-разрушитель для управления временем жизни
 
 private slots:
@@ -90,11 +858,78 @@ private slots:
     void disconnect_from_server();
 
     /**
-     * @brief Читает данные от сервера
+     * @brief Планирует следующую попытку подключения
+     */
+    void schedule_reconnect();
+
+    /**
+     * @brief Начинает попытку подключения
+     */
+    void reconnect();
+
+    /**
+     * @brief Обработчик подключения резервного соединения
+     */
+    void standby_connected();
+
+    /**
+     * @brief Обработчик разрыва резервного соединения
+     */
+    void standby_lost();
+
+    /**
+     * @brief Планирует следующую попытку подключения резервного соединения
+     */
+    void schedule_standby();
+
+    /**
+     * @brief Начинает попытку подключения резервного соединения
      */
-    void read();
+    void reconnect_standby();
+
+    /**
+     * @brief Принимает ответы сервера по резервному соединению
+     * @param messages Содержимое полученных кадров
+     *
+     * До переключения по резервному соединению ожидается только ответ на вход.
+     */
+    void receive_standby(const QByteArrayList& messages);
+
+    /**
+     * @brief Принимает ответы сервера от сетевого потока
+     * @param node Сервер из списка, приславший ответы (0 - основное соединение)
+     * @param messages Содержимое полученных кадров
+     */
+    void receive(int node, const QByteArrayList& messages);
+
+    /**
+     * @brief Обрабатывает очередную порцию полученных ответов
+     *
+     * За одну итерацию цикла событий обрабатывается не более inbox_slice
+     * ответов, поэтому большой поток ответов не замораживает окно.
+     */
+    void process_inbox();
 
 signals:
+    /**
+     * @brief Сообщение не отправлено: нет подключения к серверу и очередь
+     *        на время разрыва заполнена
+     */
+    void server_unavailable();
+
+    /**
+     * @brief Сервер не ответил на вход, регистрацию или сброс пароля в срок
+     */
+    void server_timeout();
+
+    /**
+     * @brief Очередь отправки освободилась после отказа write или solve
+     *
+     * Испускается, когда в очереди осталось не больше половины мест,
+     * поэтому отправитель пакетов может продолжать.
+     */
+    void send_ready();
+
     /// @name Сигналы регистрации
     /// @{
     /**
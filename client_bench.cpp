@@ -0,0 +1,959 @@
+#include "client.h"
+#include "binary_codec.h"
+#include "equation.h"
+#include "endpoint.h"
+#include "network_worker.h"
+#include "mock_server.h"
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QCryptographicHash>
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QFile>
+#include <QHash>
+#include <QList>
+#include <QRandomGenerator>
+#include <QThread>
+#include <QTimer>
+#include <cstdio>
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <vector>
+
+/**
+ * @file client_bench.cpp
+ * @brief Консольный генератор нагрузки на сервер решения уравнений
+ *
+ * Открывает несколько соединений, входит в учётную запись и отправляет
+ * уравнения в том же формате, что и клиент с интерфейсом. В режиме
+ * постоянной частоты (--rate) задержка считается от запланированного
+ * момента отправки, чтобы задержки сервера не занижали результат.
+ * Без --rate каждое соединение держит --window запросов в обработке.
+ *
+ * С --compare-coalescing замер выполняется дважды - со склейкой записей
+ * и без неё - и для каждого печатаются системные вызовы чтения и записи
+ * сетевого потока (по /proc/thread-self/io) и перцентили задержки.
+ *
+ * С --binary уравнения отправляются в двоичном формате (binary_codec),
+ * если сервер согласовал его при hello; печатается средний размер
+ * запроса, чтобы сравнить форматы.
+ *
+ * С --mock сервер-заменитель (mock_server) запускается в отдельном потоке
+ * этого же процесса, и внешний сервер не нужен.
+ *
+ * Сценарий --scenario failover проверяет переключение Client на резервное
+ * соединение: запускаются два сервера-заменителя (основной и резервный),
+ * Client отправляет пакет запросов, и на половине ответов основной сервер
+ * разрывает все соединения. Печатается время до первого ответа после
+ * разрыва и до ответа на все запросы. С --failover-standby none резервного
+ * соединения нет, и то же время замеряется для переподключения.
+ *
+ * Сценарий --scenario fleet запускает --fleet-size серверов-заменителей,
+ * передаёт Client их список и решает один большой пакет уравнений.
+ * Печатается время решения, количество уравнений, решённых каждым
+ * сервером, и счётчики сжатия кадров пакета (--mock-compression-threshold 0
+ * выключает сжатие ответов серверов-заменителей).
+ *
+ * Сценарий --scenario priority замеряет задержку интерактивных запросов
+ * (send_priority::INTERACTIVE) одного сервера-заменителя без нагрузки и
+ * при --priority-bulk неотвеченных фоновых запросах; для сравнения тот же
+ * замер повторяется с интерактивными запросами в фоновой полосе.
+ *
+ * Сценарий --scenario order запускает сервер-заменитель, не согласующий
+ * идентификаторы запросов, и отправляет --order-requests запросов
+ * вперемешку обеими полосами; завершается с ошибкой, если хотя бы один
+ * обработчик получил чужой ответ.
+ *
+ * Пример: client_bench --connections 8 --user bench --password secret --rate 20000
+ * Пример: client_bench --mock --window 32 --binary
+ * Пример: client_bench --scenario failover --failover-requests 2000 --mock-latency 5
+ * Пример: client_bench --scenario fleet --fleet-size 4 --fleet-equations 100000
+ * Пример: client_bench --scenario priority --priority-bulk 20000 --priority-window 512
+ * Пример: client_bench --scenario order --order-requests 5000 --mock-jitter 2
+ */
+
+/// Время ожидания подключения и входа всех соединений (мс)
+#define CONNECT_TIMEOUT_MS 5000
+/// Время ожидания ответов на запросы, отправленные до конца замера (мс)
+#define DRAIN_TIMEOUT_MS 2000
+/// Период таймера отправки в режиме постоянной частоты (мс)
+#define PACER_INTERVAL_MS 1
+/// Время ожидания ответов на все запросы сценариев (мс)
+#define SCENARIO_TIMEOUT_MS 30000
+/// Период интерактивных запросов сценария priority (мс)
+#define PROBE_INTERVAL_MS 5
+/// Разгон фоновой нагрузки сценария priority перед замером (мс)
+#define PRIORITY_WARMUP_MS 500
+
+/**
+ * @brief Параметры нагрузки
+ */
+struct bench_options {
+    endpoint address;              ///< Адрес сервера
+    int connections = 1;           ///< Количество соединений
+    QString user;                  ///< Логин (пустой - без входа)
+    QString password;              ///< Пароль
+    int duration_ms = 10000;       ///< Длительность замера
+    double rate = 0;               ///< Запросов в секунду на все соединения (0 - замкнутый цикл)
+    int window = 1;                ///< Запросов в обработке на соединение в замкнутом цикле
+    double quadratic_share = 0.5;  ///< Доля квадратных уравнений
+    framing mode = framing::LENGTH_PREFIXED; ///< Запрашиваемый режим кадрирования
+    bool coalesce_writes = true;   ///< Склеивать записи одной итерации цикла событий
+    bool binary = false;           ///< Двоичный формат уравнений, если сервер его поддерживает
+    socket_options socket;         ///< Параметры сокетов
+};
+
+/**
+ * @brief Считывает количество системных вызовов чтения и записи текущего потока
+ * @param reads Количество вызовов чтения
+ * @param writes Количество вызовов записи
+ * @return false если счётчики недоступны (не Linux)
+ */
+static bool thread_syscalls(qint64& reads, qint64& writes) {
+    QFile file("/proc/thread-self/io");
+    if (!file.open(QIODevice::ReadOnly))
+        return false;
+    reads = writes = -1;
+    for (const QByteArray& line : file.readAll().split('\n')) {
+        if (line.startsWith("syscr:"))
+            reads = line.mid(6).trimmed().toLongLong();
+        else if (line.startsWith("syscw:"))
+            writes = line.mid(6).trimmed().toLongLong();
+    }
+    return reads >= 0 and writes >= 0;
+}
+
+/**
+ * @brief Состояние одного соединения
+ */
+struct bench_connection {
+    network_worker* worker = nullptr;    ///< Сетевая часть соединения
+    bool ready = false;                  ///< Вход выполнен, можно отправлять уравнения
+    bool binary = false;                 ///< Уравнения отправляются в двоичном формате
+    QHash<quint32, qint64> sent;         ///< Момент отправки (нс) по идентификатору запроса
+};
+
+/**
+ * @brief Генератор нагрузки
+ */
+class load_generator
+{
+public:
+    /**
+     * @brief Конструктор генератора
+     * @param options Параметры нагрузки
+     */
+    explicit load_generator(const bench_options& options) :
+        options(options),
+        random(20240501)
+    {}
+
+    /**
+     * @brief Подключается, выполняет замер и печатает результат
+     * @return Код возврата программы
+     */
+    int run() {
+        QByteArray login;
+        if (!this->options.user.isEmpty()) {
+            QByteArray hash = QCryptographicHash::hash(this->options.password.toUtf8(),
+                                                       QCryptographicHash::Algorithm::Sha256).toHex();
+            login = "login|" + this->options.user.toUtf8() + "$" + hash;
+        }
+
+        this->peers.resize(this->options.connections);
+        for (int i = 0; i < this->options.connections; i++) {
+            bench_connection& peer = this->peers[i];
+            peer.worker = new network_worker(handshake::offer(this->options.mode), &this->scope);
+            peer.worker->set_write_coalescing(this->options.coalesce_writes);
+            peer.worker->set_socket_options(this->options.socket);
+            QObject::connect(peer.worker, &network_worker::connected, &this->scope,
+                             [this, i, login](const handshake& features) {
+                this->peers[i].binary = this->options.binary and features.binary;
+                if (login.isEmpty())
+                    this->on_ready(i);
+                else
+                    this->peers[i].worker->send(login);
+            });
+            QObject::connect(peer.worker, &network_worker::disconnected, &this->scope, [this]() {
+                this->disconnects++;
+            });
+            QObject::connect(peer.worker, &network_worker::messages_received, &this->scope,
+                             [this, i](const QByteArrayList& messages) {
+                for (const QByteArray& message : messages)
+                    this->on_message(i, message);
+            });
+            peer.worker->connect_to(this->options.address);
+        }
+
+        QTimer::singleShot(CONNECT_TIMEOUT_MS, &this->scope, [this]() {
+            if (!this->started) {
+                std::fprintf(stderr, "connected %d of %d, giving up\n", this->ready_count, this->options.connections);
+                qApp->exit(1);
+            }
+        });
+        return qApp->exec() == 0 ? this->report() : 1;
+    }
+
+private:
+    /**
+     * @brief Соединение готово к отправке уравнений
+     * @param index Номер соединения
+     */
+    void on_ready(int index) {
+        if (this->peers[index].ready)
+            return;
+        this->peers[index].ready = true;
+        if (++this->ready_count == this->options.connections)
+            this->start();
+    }
+
+    /**
+     * @brief Запускает замер после входа всех соединений
+     */
+    void start() {
+        this->started = true;
+        this->syscalls_known = thread_syscalls(this->start_reads, this->start_writes);
+        this->clock.start();
+        this->latencies.reserve(1 << 20);
+
+        if (this->options.rate > 0) {
+            QTimer* pacer = new QTimer(&this->scope);
+            pacer->setTimerType(Qt::PreciseTimer);
+            QObject::connect(pacer, &QTimer::timeout, &this->scope, [this]() { this->pace(); });
+            pacer->start(PACER_INTERVAL_MS);
+        }
+        else {
+            for (int i = 0; i < this->peers.size(); i++)
+                for (int k = 0; k < this->options.window; k++)
+                    this->send_equation(i, this->clock.nsecsElapsed());
+        }
+
+        QTimer::singleShot(this->options.duration_ms, &this->scope, [this]() {
+            this->measured_ns = this->clock.nsecsElapsed();
+            this->measured_answers = qint64(this->latencies.size());
+            if (this->syscalls_known)
+                this->syscalls_known = thread_syscalls(this->end_reads, this->end_writes);
+            for (const bench_connection& peer : std::as_const(this->peers))
+                this->write_calls += peer.worker->write_calls();
+            this->sending = false;
+            this->finish_if_drained();
+            QTimer::singleShot(DRAIN_TIMEOUT_MS, &this->scope, []() { qApp->exit(0); });
+        });
+    }
+
+    /**
+     * @brief Отправляет запросы, запланированные к текущему моменту
+     *
+     * i-й запрос запланирован на момент i / rate от начала замера.
+     * Если цикл событий отстал, недостающие запросы отправляются сразу,
+     * но их задержка считается от запланированного момента.
+     */
+    void pace() {
+        if (!this->sending)
+            return;
+        qint64 now = this->clock.nsecsElapsed();
+        qint64 due = qint64(now * 1e-9 * this->options.rate);
+        while (this->scheduled < due) {
+            qint64 intended = qint64(this->scheduled * 1e9 / this->options.rate);
+            this->send_equation(int(this->scheduled % this->peers.size()), intended);
+            this->scheduled++;
+        }
+    }
+
+    /**
+     * @brief Отправляет случайное уравнение
+     * @param index Номер соединения
+     * @param intended_ns Момент, от которого считается задержка (нс от начала замера)
+     */
+    void send_equation(int index, qint64 intended_ns) {
+        equation_request equation;
+        double a = this->random.bounded(1, 100) * (this->random.bounded(2) ? 1 : -1);
+        double b = this->random.bounded(-100, 101);
+        if (this->random.generateDouble() < this->options.quadratic_share)
+            equation = equation_request::quadratic(a, b, this->random.bounded(-100, 101));
+        else
+            equation = equation_request::linear(a, b);
+
+        quint32 id = ++this->next_id;
+        bench_connection& peer = this->peers[index];
+        QByteArray message;
+        if (peer.binary) {
+            binary_codec::encode_equation(equation, id, message);
+        }
+        else {
+            message.append("equation|");
+            equation.append_to(message);
+            message.append('|');
+            message.append(QByteArray::number(id));
+        }
+
+        peer.sent.insert(id, intended_ns);
+        peer.worker->send(message);
+        this->requests++;
+        this->payload_bytes += message.size();
+    }
+
+    /**
+     * @brief Обрабатывает сообщение сервера
+     * @param index Номер соединения
+     * @param message Сообщение без кадрирования
+     */
+    void on_message(int index, const QByteArray& message) {
+        if (message.startsWith("auth|")) {
+            if (message == "auth|ok") {
+                this->on_ready(index);
+            }
+            else {
+                std::fprintf(stderr, "login rejected: %s\n", message.constData());
+                qApp->exit(1);
+            }
+            return;
+        }
+        bool has_id = false;
+        quint32 id = 0;
+        QString answer;
+        if (binary_codec::is_binary(message)) {
+            QStringList answers;
+            bool batch = false;
+            if (!binary_codec::decode_answer(message, answers, id, batch) or batch)
+                return;
+            has_id = true;
+            answer = answers.value(0);
+        }
+        else if (message.startsWith("answer|")) {
+            QList<QByteArray> fields = message.split('|');
+            id = fields.size() >= 3 ? fields.last().toUInt(&has_id) : 0;
+            answer = QString::fromUtf8(fields.value(1));
+        }
+        else {
+            return;
+        }
+
+        bench_connection& peer = this->peers[index];
+        auto sent = has_id ? peer.sent.find(id) : peer.sent.end();
+        if (sent == peer.sent.end()) {
+            // Сервер без идентификаторов отвечает по порядку
+            if (has_id or peer.sent.isEmpty())
+                return;
+            sent = peer.sent.find(*std::min_element(peer.sent.keyBegin(), peer.sent.keyEnd()));
+        }
+
+        this->latencies.push_back(this->clock.nsecsElapsed() - sent.value());
+        if (answer.startsWith("error"))
+            this->errors++;
+        peer.sent.erase(sent);
+
+        if (this->sending and this->options.rate <= 0)
+            this->send_equation(index, this->clock.nsecsElapsed());
+        else if (!this->sending)
+            this->finish_if_drained();
+    }
+
+    /**
+     * @brief Завершает работу, если ответы на все запросы получены
+     */
+    void finish_if_drained() {
+        for (const bench_connection& peer : this->peers)
+            if (!peer.sent.isEmpty())
+                return;
+        qApp->exit(0);
+    }
+
+    /**
+     * @brief Печатает пропускную способность, системные вызовы и перцентили задержки
+     * @return Код возврата программы
+     */
+    int report() {
+        std::sort(this->latencies.begin(), this->latencies.end());
+        auto percentile = [this](double p) {
+            if (this->latencies.empty())
+                return 0.0;
+            std::size_t rank = std::size_t(std::ceil(p * this->latencies.size()));
+            return this->latencies[std::min(this->latencies.size() - 1, rank > 0 ? rank - 1 : 0)] / 1e3;
+        };
+
+        qint64 lost = 0;
+        for (const bench_connection& peer : this->peers)
+            lost += peer.sent.size();
+        double seconds = this->measured_ns / 1e9;
+
+        std::printf("client_bench %s, %d connections, %s, %.0f%% quadratic, coalescing %s%s\n",
+                    qPrintable(this->options.address.to_string()), this->options.connections,
+                    this->options.rate > 0 ? qPrintable(QString("open loop %1 req/s").arg(this->options.rate))
+                                           : qPrintable(QString("closed loop, window %1").arg(this->options.window)),
+                    this->options.quadratic_share * 100, this->options.coalesce_writes ? "on" : "off",
+                    this->options.socket.low_delay ? "" : ", Nagle on");
+        std::printf("  requests  %10lld  answers %lld  errors %lld  unanswered %lld  disconnects %lld\n",
+                    this->requests, static_cast<long long>(this->latencies.size()),
+                    this->errors, lost, this->disconnects);
+        std::printf("  throughput %9.0f answers/s\n", seconds > 0 ? this->measured_answers / seconds : 0.0);
+        std::printf("  request size %.1f bytes (%s)\n",
+                    this->requests > 0 ? double(this->payload_bytes) / this->requests : 0.0,
+                    !this->peers.isEmpty() and this->peers.first().binary ? "binary" : "text");
+        double per_answer = this->measured_answers > 0 ? 1.0 / this->measured_answers : 0.0;
+        std::printf("  socket writes %lld (%.3f per answer)", static_cast<long long>(this->write_calls),
+                    this->write_calls * per_answer);
+        if (this->syscalls_known)
+            std::printf("  syscalls: write %.3f  read %.3f per answer",
+                        (this->end_writes - this->start_writes) * per_answer,
+                        (this->end_reads - this->start_reads) * per_answer);
+        std::printf("\n");
+        std::printf("  latency us  p50 %.1f  p95 %.1f  p99 %.1f  p999 %.1f  max %.1f\n",
+                    percentile(0.5), percentile(0.95), percentile(0.99), percentile(0.999), percentile(1.0));
+        return lost == 0 and this->disconnects == 0 ? 0 : 2;
+    }
+
+    bench_options options;                ///< Параметры нагрузки
+    QRandomGenerator random;              ///< Генератор коэффициентов
+    QList<bench_connection> peers;        ///< Соединения
+    QElapsedTimer clock;                  ///< Часы замера
+    std::vector<qint64> latencies;        ///< Задержки ответов (нс)
+    int ready_count = 0;                  ///< Количество готовых соединений
+    bool started = false;                 ///< Замер начат
+    bool sending = true;                  ///< Отправка новых запросов разрешена
+    quint32 next_id = 0;                  ///< Последний выданный идентификатор запроса
+    qint64 scheduled = 0;                 ///< Количество запланированных запросов (постоянная частота)
+    qint64 measured_ns = 0;               ///< Длительность замера
+    long long requests = 0;               ///< Отправлено запросов
+    long long payload_bytes = 0;          ///< Размер отправленных запросов без кадрирования
+    long long errors = 0;                 ///< Ответов с ошибкой
+    long long disconnects = 0;            ///< Разрывов соединения
+    qint64 measured_answers = 0;          ///< Ответов, полученных за время замера
+    qint64 write_calls = 0;               ///< Записей в сокеты за время замера
+    bool syscalls_known = false;          ///< Счётчики системных вызовов доступны
+    qint64 start_reads = 0;               ///< Вызовы чтения потока в начале замера
+    qint64 start_writes = 0;              ///< Вызовы записи потока в начале замера
+    qint64 end_reads = 0;                 ///< Вызовы чтения потока в конце замера
+    qint64 end_writes = 0;                ///< Вызовы записи потока в конце замера
+    QObject scope;                        ///< Владелец соединений и таймеров замера (удаляется первым)
+};
+
+/**
+ * @brief Обрабатывает события, пока не выполнится условие
+ * @param done Условие
+ * @param timeout_ms Максимальное ожидание
+ * @return false если время ожидания истекло
+ */
+static bool wait_until(const std::function<bool()>& done, int timeout_ms) {
+    QElapsedTimer timer;
+    timer.start();
+    // Таймер будит цикл событий, чтобы условие проверялось и без входящих событий
+    QTimer tick;
+    tick.start(1);
+    while (!done()) {
+        if (timer.elapsed() > timeout_ms)
+            return false;
+        QCoreApplication::processEvents(QEventLoop::WaitForMoreEvents);
+    }
+    return true;
+}
+
+/**
+ * @brief Замеряет восстановление Client после падения основного сервера
+ * @param primary Основной сервер-заменитель (работает в другом потоке)
+ * @param primary_address Адрес основного сервера
+ * @param standby_address Адрес резервного сервера; пустой указатель - без резервного соединения
+ * @param count Количество запросов в пакете
+ * @return Код возврата программы
+ *
+ * Адреса передаются Client через переменные окружения, как при обычном
+ * запуске клиента. Запросы отправляются мимо кэша ответов.
+ */
+static int run_failover(mock_server* primary, const endpoint& primary_address,
+                        const endpoint* standby_address, int count) {
+    qputenv(ENDPOINT_ENVIRONMENT, primary_address.to_string().toUtf8());
+    if (standby_address != nullptr)
+        qputenv(STANDBY_ENVIRONMENT, standby_address->to_string().toUtf8());
+    else
+        qunsetenv(STANDBY_ENVIRONMENT);
+
+    Client* client = Client::get_instance();
+    QObject scope;
+    bool logged_in = false;
+    QObject::connect(client, &Client::auth_ok, &scope, [&logged_in]() { logged_in = true; });
+    auto ready = [client, standby_address]() {
+        return client->is_connected() and (standby_address == nullptr or client->is_standby_ready());
+    };
+    if (!wait_until(ready, CONNECT_TIMEOUT_MS)) {
+        std::fprintf(stderr, "client did not connect\n");
+        return 1;
+    }
+    QByteArray hash = QCryptographicHash::hash("bench", QCryptographicHash::Algorithm::Sha256).toHex();
+    client->write("login|bench$" + QString::fromLatin1(hash));
+    if (!wait_until([&logged_in, &ready]() { return logged_in and ready(); }, CONNECT_TIMEOUT_MS)) {
+        std::fprintf(stderr, "login or standby login did not complete\n");
+        return 1;
+    }
+
+    QRandomGenerator random(20240501);
+    QElapsedTimer clock;
+    int answered = 0;
+    int errors = 0;
+    int in_flight_at_kill = 0;
+    qint64 killed_ns = -1;
+    qint64 first_after_kill_ns = -1;
+    qint64 last_ns = 0;
+    clock.start();
+    for (int i = 0; i < count; i++) {
+        equation_request equation = equation_request::quadratic(random.bounded(1, 100), random.bounded(-100, 101),
+                                                                random.bounded(-100, 101));
+        client->write_request(equation.to_message(), [&](const QString& answer, bool) {
+            answered++;
+            if (answer == "error")
+                errors++;
+            last_ns = clock.nsecsElapsed();
+            if (killed_ns >= 0 and first_after_kill_ns < 0)
+                first_after_kill_ns = last_ns;
+            if (answered == count / 2) {
+                in_flight_at_kill = count - answered;
+                QMetaObject::invokeMethod(primary, [primary]() { primary->drop_connections(); },
+                                          Qt::BlockingQueuedConnection);
+                killed_ns = clock.nsecsElapsed();
+            }
+        });
+    }
+    bool complete = wait_until([&answered, count]() { return answered == count; }, SCENARIO_TIMEOUT_MS);
+
+    std::printf("client_bench failover scenario, %s, %d requests\n",
+                standby_address != nullptr ? qPrintable("standby " + standby_address->to_string())
+                                           : "no standby (reconnect only)", count);
+    std::printf("  answers %d  errors %d  in flight at kill %d  failovers %d\n",
+                answered, errors, in_flight_at_kill, client->get_failover_count());
+    if (killed_ns >= 0) {
+        std::printf("  first answer after kill %.2f ms\n",
+                    first_after_kill_ns >= 0 ? (first_after_kill_ns - killed_ns) / 1e6 : -1.0);
+        std::printf("  all answered after kill %.2f ms\n", complete ? (last_ns - killed_ns) / 1e6 : -1.0);
+    }
+    return complete and errors == 0 ? 0 : 2;
+}
+
+/**
+ * @brief Замеряет решение пакета уравнений списком серверов
+ * @param servers Серверы-заменители (работают в другом потоке)
+ * @param addresses Адреса серверов
+ * @param count Количество уравнений в пакете
+ * @return Код возврата программы
+ */
+static int run_fleet(const QList<mock_server*>& servers, const QList<endpoint>& addresses, int count) {
+    QStringList list;
+    for (const endpoint& address : addresses)
+        list.append(address.to_string());
+    qputenv(ENDPOINT_ENVIRONMENT, list.join(',').toUtf8());
+    qunsetenv(STANDBY_ENVIRONMENT);
+
+    Client* client = Client::get_instance();
+    auto ready = [client]() {
+        for (int i = 0; i < client->get_fleet_size(); i++)
+            if (!client->is_node_available(i))
+                return false;
+        return true;
+    };
+    if (!wait_until(ready, CONNECT_TIMEOUT_MS)) {
+        std::fprintf(stderr, "client did not connect to every server\n");
+        return 1;
+    }
+
+    QRandomGenerator random(20240501);
+    QList<equation_request> equations;
+    equations.reserve(count);
+    for (int i = 0; i < count; i++)
+        equations.append(equation_request::quadratic(random.bounded(1, 100), random.bounded(-100, 101),
+                                                     random.bounded(-100, 101)));
+
+    QElapsedTimer clock;
+    bool done = false;
+    int errors = 0;
+    clock.start();
+    client->solve_batch(equations, [&done, &errors](const QStringList& answers) {
+        errors = int(answers.count("error"));
+        done = true;
+    });
+    bool complete = wait_until([&done]() { return done; }, SCENARIO_TIMEOUT_MS);
+    double elapsed_ms = clock.nsecsElapsed() / 1e6;
+
+    std::printf("client_bench fleet scenario, %lld servers, %d equations in one batch\n",
+                static_cast<long long>(servers.size()), count);
+    std::printf("  %s in %.2f ms, errors %d\n", complete ? "solved" : "timed out", elapsed_ms, errors);
+    for (qsizetype i = 0; i < servers.size(); i++)
+        std::printf("  %-24s %10lld equations\n", qPrintable(addresses[i].to_string()),
+                    static_cast<long long>(servers[i]->equations_solved()));
+    compression_stats packing = client->get_compression_stats();
+    std::printf("  compression ratio %.2f  frames sent %lld received %lld  compress %.2f ms  decompress %.2f ms\n",
+                packing.ratio(), static_cast<long long>(packing.frames_packed),
+                static_cast<long long>(packing.frames_unpacked), packing.compress_ns / 1e6,
+                packing.decompress_ns / 1e6);
+    return complete and errors == 0 ? 0 : 2;
+}
+
+/**
+ * @brief Проверяет сопоставление ответов сервера без идентификаторов запросов
+ * @param address Адрес сервера-заменителя, не согласующего идентификаторы
+ * @param count Количество запросов
+ * @param window Окно запросов в обработке Client (set_in_flight_window)
+ * @return Код возврата программы
+ *
+ * Запросы x - k = 0 отправляются вперемешку интерактивной и фоновой
+ * полосами при окне меньше их количества, так что часть запросов ждёт
+ * в очереди отправки. Ответы такого сервера сопоставляются по порядку,
+ * поэтому каждый обработчик должен получить свой корень k.
+ */
+static int run_order(const endpoint& address, int count, int window) {
+    qputenv(ENDPOINT_ENVIRONMENT, address.to_string().toUtf8());
+    qunsetenv(STANDBY_ENVIRONMENT);
+
+    Client* client = Client::get_instance();
+    client->set_in_flight_window(window);
+    if (!wait_until([client]() { return client->is_connected(); }, CONNECT_TIMEOUT_MS)) {
+        std::fprintf(stderr, "client did not connect\n");
+        return 1;
+    }
+
+    std::printf("client_bench order scenario, %s, %d requests, window %d\n",
+                qPrintable(address.to_string()), count, window);
+    QObject scope;
+    int sent = 0;
+    int answered = 0;
+    int mismatched = 0;
+    // Запросы дописываются по таймеру и send_ready, а не из обработчика ответа
+    auto top_up = [&]() {
+        while (sent < count) {
+            QString expected = QString::number(sent + 1);
+            send_priority priority = sent % 3 == 0 ? send_priority::INTERACTIVE : send_priority::BULK;
+            quint32 id = client->write_request(equation_request::linear(1, -(sent + 1)).to_message(),
+                                               [&answered, &mismatched, expected](const QString& answer, bool) {
+                answered++;
+                if (answer != expected)
+                    mismatched++;
+            }, priority);
+            if (id == 0)
+                break;
+            sent++;
+        }
+    };
+    QTimer pump;
+    QObject::connect(&pump, &QTimer::timeout, &scope, top_up);
+    QObject::connect(client, &Client::send_ready, &scope, top_up);
+    pump.start(1);
+    top_up();
+    bool complete = wait_until([&]() { return answered == count; }, SCENARIO_TIMEOUT_MS);
+    pump.stop();
+
+    bool ids = client->get_server_features().request_ids;
+    std::printf("  answered %d, mismatched %d%s%s\n", answered, mismatched, complete ? "" : "  (timed out)",
+                ids ? "  (server negotiated request ids)" : "");
+    // Обработчики неотвеченных запросов ссылаются на переменные сценария
+    if (!complete)
+        wait_until([&]() { return answered == sent; }, SCENARIO_TIMEOUT_MS);
+    return complete and mismatched == 0 and !ids ? 0 : 2;
+}
+
+/**
+ * @brief Замеряет задержку интерактивных запросов под фоновой нагрузкой
+ * @param address Адрес сервера-заменителя
+ * @param probes Количество интерактивных запросов в каждом прогоне
+ * @param bulk Количество фоновых запросов, которые поддерживаются неотвеченными
+ * @param window Окно запросов в обработке Client (set_in_flight_window)
+ * @return Код возврата программы
+ *
+ * Выполняется три прогона: без фоновой нагрузки, с нагрузкой и
+ * интерактивными запросами в своей полосе, с нагрузкой и теми же
+ * запросами в фоновой полосе. Интерактивные запросы отправляются по
+ * одному раз в PROBE_INTERVAL_MS; для каждого прогона печатаются
+ * перцентили их задержки и пропускная способность фоновых запросов.
+ */
+static int run_priority(const endpoint& address, int probes, int bulk, int window) {
+    qputenv(ENDPOINT_ENVIRONMENT, address.to_string().toUtf8());
+    qunsetenv(STANDBY_ENVIRONMENT);
+
+    Client* client = Client::get_instance();
+    client->set_in_flight_window(window);
+    if (!wait_until([client]() { return client->is_connected(); }, CONNECT_TIMEOUT_MS)) {
+        std::fprintf(stderr, "client did not connect\n");
+        return 1;
+    }
+
+    QRandomGenerator random(20240501);
+    auto next_equation = [&random]() {
+        return equation_request::quadratic(random.bounded(1, 100), random.bounded(-100, 101),
+                                           random.bounded(-100, 101)).to_message();
+    };
+
+    std::printf("client_bench priority scenario, %s, %d probes, %d bulk requests outstanding, window %d\n",
+                qPrintable(address.to_string()), probes, bulk, window);
+    int code = 0;
+    struct variant {
+        const char* name;       ///< Название прогона
+        bool loaded;            ///< С фоновой нагрузкой
+        send_priority priority; ///< Полоса интерактивных запросов
+    };
+    for (const variant& run : {variant{"idle", false, send_priority::INTERACTIVE},
+                               variant{"bulk load, interactive lane", true, send_priority::INTERACTIVE},
+                               variant{"bulk load, same lane", true, send_priority::BULK}}) {
+        QObject scope;
+        QElapsedTimer clock;
+        std::vector<qint64> latencies;
+        latencies.reserve(std::size_t(probes));
+        int outstanding = 0;
+        qint64 bulk_answers = 0;
+        int probes_sent = 0;
+        bool probe_pending = false;
+        bool running = true;
+        clock.start();
+
+        // Фоновые запросы дополняются по таймеру, а не из обработчика ответа, чтобы не отправлять из Client::read
+        auto top_up = [&]() {
+            while (running and run.loaded and outstanding < bulk) {
+                quint32 id = client->write_request(next_equation(), [&outstanding, &bulk_answers](const QString&, bool) {
+                    outstanding--;
+                    bulk_answers++;
+                }, send_priority::BULK);
+                if (id == 0)
+                    break;
+                outstanding++;
+            }
+        };
+        auto probe = [&]() {
+            if (probe_pending or probes_sent == probes)
+                return;
+            qint64 sent_ns = clock.nsecsElapsed();
+            quint32 id = client->write_request(next_equation(), [&, sent_ns](const QString&, bool) {
+                latencies.push_back(clock.nsecsElapsed() - sent_ns);
+                probe_pending = false;
+            }, run.priority);
+            if (id != 0) {
+                probe_pending = true;
+                probes_sent++;
+            }
+        };
+        QTimer pump;
+        QObject::connect(&pump, &QTimer::timeout, &scope, top_up);
+        QObject::connect(client, &Client::send_ready, &scope, top_up);
+        pump.start(1);
+        top_up();
+        // Нагрузка успевает заполнить очереди до первого интерактивного запроса
+        if (run.loaded)
+            wait_until([]() { return false; }, PRIORITY_WARMUP_MS);
+        qint64 bulk_start = bulk_answers;
+        qint64 start_ns = clock.nsecsElapsed();
+        QTimer prober;
+        QObject::connect(&prober, &QTimer::timeout, &scope, probe);
+        prober.start(PROBE_INTERVAL_MS);
+        bool complete = wait_until([&]() { return int(latencies.size()) == probes; }, SCENARIO_TIMEOUT_MS);
+        double seconds = (clock.nsecsElapsed() - start_ns) / 1e9;
+        qint64 measured_bulk = bulk_answers - bulk_start;
+        running = false;
+        prober.stop();
+        pump.stop();
+        bool drained = wait_until([&]() { return outstanding == 0 and !probe_pending; }, SCENARIO_TIMEOUT_MS);
+
+        std::sort(latencies.begin(), latencies.end());
+        auto percentile = [&latencies](double p) {
+            if (latencies.empty())
+                return 0.0;
+            std::size_t rank = std::size_t(std::ceil(p * latencies.size()));
+            return latencies[std::min(latencies.size() - 1, rank > 0 ? rank - 1 : 0)] / 1e3;
+        };
+        std::printf("  %-28s latency us  p50 %9.1f  p99 %9.1f  max %9.1f  bulk %9.0f answers/s%s\n", run.name,
+                    percentile(0.5), percentile(0.99), percentile(1.0),
+                    seconds > 0 ? measured_bulk / seconds : 0.0, complete ? "" : "  (timed out)");
+        if (!complete)
+            code = 2;
+        // Обработчики неотвеченных запросов ссылаются на переменные прогона
+        if (!drained)
+            return 2;
+    }
+    return code;
+}
+
+/**
+ * @brief Запускает серверы-заменители в отдельном потоке
+ * @param thread Поток серверов (запускается здесь)
+ * @param options Поведение серверов
+ * @param count Количество серверов
+ * @param servers Созданные серверы
+ * @return Адреса серверов; пустой список, если какой-то сервер не открыл порт
+ */
+static QList<endpoint> start_mock_servers(QThread& thread, const mock_server::settings& options, int count,
+                                          QList<mock_server*>& servers) {
+    for (int i = 0; i < count; i++) {
+        mock_server* server = new mock_server(options);
+        server->moveToThread(&thread);
+        QObject::connect(&thread, &QThread::finished, server, &QObject::deleteLater);
+        servers.append(server);
+    }
+    thread.start();
+
+    QList<endpoint> addresses;
+    QMetaObject::invokeMethod(servers.first(), [&servers, &addresses]() {
+        for (mock_server* server : std::as_const(servers))
+            if (server->listen())
+                addresses.append(endpoint::tcp("127.0.0.1", server->port()));
+    }, Qt::BlockingQueuedConnection);
+    if (addresses.size() != servers.size())
+        addresses.clear();
+    return addresses;
+}
+
+/**
+ * @brief Точка входа генератора нагрузки
+ * @param argc Количество аргументов командной строки
+ * @param argv Аргументы командной строки
+ * @return 0 при успехе, 1 если замер не состоялся, 2 если часть запросов осталась без ответа
+ */
+int main(int argc, char *argv[])
+{
+    QCoreApplication a(argc, argv);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Генератор нагрузки на сервер решения уравнений");
+    parser.addHelpOption();
+    parser.addOptions({
+        {"server", "Адрес сервера: host:port, tcp://host:port или unix:/path.", "endpoint", "127.0.0.1:8080"},
+        {"connections", "Количество соединений.", "n", "1"},
+        {"user", "Логин; без него вход не выполняется.", "login"},
+        {"password", "Пароль.", "password"},
+        {"duration", "Длительность замера, с.", "seconds", "10"},
+        {"rate", "Запросов в секунду на все соединения; 0 - замкнутый цикл.", "rps", "0"},
+        {"window", "Запросов в обработке на соединение в замкнутом цикле.", "n", "1"},
+        {"quadratic-share", "Доля квадратных уравнений от 0 до 1.", "share", "0.5"},
+        {"framing", "Режим кадрирования: length, line или plain.", "mode", "length"},
+        {"binary", "Отправлять уравнения в двоичном формате, если сервер его поддерживает."},
+        {"no-coalesce", "Записывать каждое сообщение отдельным системным вызовом."},
+        {"compare-coalescing", "Выполнить замер со склейкой записей и без неё."},
+        {"nagle", "Не отключать алгоритм Нейгла (без TCP_NODELAY)."},
+        {"send-buffer", "Размер буфера отправки сокета, байт (0 - по умолчанию).", "bytes", "0"},
+        {"receive-buffer", "Размер буфера приёма сокета, байт (0 - по умолчанию).", "bytes", "0"},
+        {"mock", "Запустить сервер-заменитель внутри процесса."},
+        {"mock-local", "Подключаться к серверу-заменителю через локальный сокет, а не TCP."},
+        {"mock-latency", "Задержка ответа сервера-заменителя, мс.", "ms", "0"},
+        {"mock-jitter", "Разброс задержки сервера-заменителя, мс.", "ms", "0"},
+        {"mock-fragment", "Дробление ответов сервера-заменителя, байт.", "bytes", "0"},
+        {"mock-coalesce", "Склейка ответов сервера-заменителя, штук.", "n", "1"},
+        {"mock-compression-threshold", "Сжимать ответы сервера-заменителя не короче, байт (0 - не сжимать).",
+         "bytes", "1024"},
+        {"scenario", "Сценарий вместо замера нагрузки: failover, fleet, priority или order.", "name"},
+        {"failover-requests", "Количество запросов в сценарии failover.", "n", "2000"},
+        {"failover-standby", "Резервное соединение в сценарии failover: backup или none.", "mode", "backup"},
+        {"fleet-size", "Количество серверов в сценарии fleet.", "n", "4"},
+        {"fleet-equations", "Количество уравнений в пакете сценария fleet.", "n", "100000"},
+        {"priority-probes", "Количество интерактивных запросов в прогоне сценария priority.", "n", "500"},
+        {"priority-bulk", "Неотвеченных фоновых запросов в сценарии priority.", "n", "20000"},
+        {"priority-window", "Окно запросов в обработке Client в сценарии priority.", "n", "512"},
+        {"order-requests", "Количество запросов в сценарии order.", "n", "5000"},
+        {"order-window", "Окно запросов в обработке Client в сценарии order.", "n", "64"},
+    });
+    parser.process(a);
+
+    bench_options options;
+    if (!endpoint::parse(parser.value("server"), options.address)) {
+        std::fprintf(stderr, "invalid server address: %s\n", qPrintable(parser.value("server")));
+        return 1;
+    }
+    options.connections = qMax(1, parser.value("connections").toInt());
+    options.user = parser.value("user");
+    options.password = parser.value("password");
+    options.duration_ms = qMax(1, int(parser.value("duration").toDouble() * 1000));
+    options.rate = qMax(0.0, parser.value("rate").toDouble());
+    options.window = qMax(1, parser.value("window").toInt());
+    options.quadratic_share = qBound(0.0, parser.value("quadratic-share").toDouble(), 1.0);
+    options.coalesce_writes = !parser.isSet("no-coalesce");
+    options.binary = parser.isSet("binary");
+    options.socket.low_delay = !parser.isSet("nagle");
+    options.socket.send_buffer = qMax(0, parser.value("send-buffer").toInt());
+    options.socket.receive_buffer = qMax(0, parser.value("receive-buffer").toInt());
+    if (parser.value("framing") == "line")
+        options.mode = framing::DELIMITED;
+    else if (parser.value("framing") == "plain")
+        options.mode = framing::PLAIN;
+
+    mock_server::settings server_options;
+    server_options.latency_ms = qMax(0, parser.value("mock-latency").toInt());
+    server_options.jitter_ms = qMax(0, parser.value("mock-jitter").toInt());
+    server_options.fragment_size = qMax(0, parser.value("mock-fragment").toInt());
+    server_options.coalesce_count = qMax(1, parser.value("mock-coalesce").toInt());
+    server_options.compression_threshold = qMax(0, parser.value("mock-compression-threshold").toInt());
+
+    // Сервер-заменитель работает в своём потоке, чтобы не делить цикл событий с нагрузкой
+    QThread server_thread;
+    QString scenario = parser.value("scenario");
+    if (scenario == "failover" or scenario == "fleet" or scenario == "priority" or scenario == "order") {
+        if (parser.isSet("server")) {
+            std::fprintf(stderr, "the %s scenario starts its own servers, --server is not used\n", qPrintable(scenario));
+            return 1;
+        }
+        QList<mock_server*> servers;
+        int count = scenario == "fleet" ? qMax(1, parser.value("fleet-size").toInt())
+                                        : scenario == "priority" or scenario == "order" ? 1 : 2;
+        // Сценарий order проверяет сопоставление ответов по порядку, без идентификаторов
+        if (scenario == "order")
+            server_options.request_ids = false;
+        QList<endpoint> addresses = start_mock_servers(server_thread, server_options, count, servers);
+
+        int code = 1;
+        if (addresses.isEmpty()) {
+            std::fprintf(stderr, "mock servers failed to listen\n");
+        }
+        else if (scenario == "priority") {
+            code = run_priority(addresses[0], qMax(1, parser.value("priority-probes").toInt()),
+                                qMax(0, parser.value("priority-bulk").toInt()),
+                                qMax(1, parser.value("priority-window").toInt()));
+        }
+        else if (scenario == "order") {
+            code = run_order(addresses[0], qMax(1, parser.value("order-requests").toInt()),
+                             qMax(1, parser.value("order-window").toInt()));
+        }
+        else if (scenario == "fleet") {
+            code = run_fleet(servers, addresses, qMax(1, parser.value("fleet-equations").toInt()));
+        }
+        else {
+            bool use_standby = parser.value("failover-standby") != "none";
+            code = run_failover(servers[0], addresses[0], use_standby ? &addresses[1] : nullptr,
+                                qMax(2, parser.value("failover-requests").toInt()));
+        }
+        server_thread.quit();
+        server_thread.wait();
+        return code;
+    }
+    if (parser.isSet("scenario")) {
+        std::fprintf(stderr, "unknown scenario: %s\n", qPrintable(parser.value("scenario")));
+        return 1;
+    }
+
+    if (parser.isSet("mock")) {
+
+        mock_server* server = new mock_server(server_options);
+        server->moveToThread(&server_thread);
+        QObject::connect(&server_thread, &QThread::finished, server, &QObject::deleteLater);
+        server_thread.start();
+
+        bool local = parser.isSet("mock-local");
+        QString name = QString("client_bench_mock_%1").arg(QCoreApplication::applicationPid());
+        quint16 port = 0;
+        bool listening = false;
+        QMetaObject::invokeMethod(server, [server, local, name, &port, &listening]() {
+            listening = local ? server->listen_local(name) : server->listen();
+            port = server->port();
+        }, Qt::BlockingQueuedConnection);
+        if (!listening) {
+            std::fprintf(stderr, "mock server failed to listen\n");
+            server_thread.quit();
+            server_thread.wait();
+            return 1;
+        }
+        options.address = local ? endpoint::local(name) : endpoint::tcp("127.0.0.1", port);
+    }
+
+    QList<bool> variants = {options.coalesce_writes};
+    if (parser.isSet("compare-coalescing"))
+        variants = {true, false};
+    int code = 0;
+    for (bool coalesce : variants) {
+        options.coalesce_writes = coalesce;
+        load_generator generator(options);
+        code = qMax(code, generator.run());
+    }
+    server_thread.quit();
+    server_thread.wait();
+    return code;
+}
@@ -0,0 +1,70 @@
+QT = core network
+
+CONFIG += c++17 console
+CONFIG -= app_bundle
+
+TARGET = client_bench
+
+CONFIG -=debug_and_release
+CONFIG += release
+
+DESTDIR = $$PWD/build
+
+OBJECTS_DIR = ./build/client_bench/obj
+MOC_DIR = ./build/client_bench/moc
+
+INCLUDEPATH = "$$PWD/include"
+
+# Сжатие zstd подключается, если библиотека установлена; иначе только zlib (qCompress)
+packagesExist(libzstd) {
+    CONFIG += link_pkgconfig
+    PKGCONFIG += libzstd
+    DEFINES += HAVE_ZSTD
+}
+
+SOURCES += \
+    $$PWD/src/answer_cache.cpp \
+    $$PWD/src/binary_codec.cpp \
+    $$PWD/src/bisection_kernel.cpp \
+    $$PWD/src/bisection_solver.cpp \
+    $$PWD/src/client.cpp \
+    $$PWD/src/client_bench.cpp \
+    $$PWD/src/endpoint.cpp \
+    $$PWD/src/equation.cpp \
+    $$PWD/src/frame_compression.cpp \
+    $$PWD/src/frame_parser.cpp \
+    $$PWD/src/handshake.cpp \
+    $$PWD/src/hash_ring.cpp \
+    $$PWD/src/lane_scheduler.cpp \
+    $$PWD/src/logger.cpp \
+    $$PWD/src/metrics.cpp \
+    $$PWD/src/mock_server.cpp \
+    $$PWD/src/network_worker.cpp \
+    $$PWD/src/result_store.cpp \
+    $$PWD/src/timer_wheel.cpp \
+    $$PWD/src/token_bucket.cpp \
+    $$PWD/src/trace.cpp \
+    $$PWD/src/transport.cpp
+
+HEADERS += \
+    $$PWD/include/answer_cache.h \
+    $$PWD/include/binary_codec.h \
+    $$PWD/include/bisection_kernel.h \
+    $$PWD/include/bisection_solver.h \
+    $$PWD/include/client.h \
+    $$PWD/include/endpoint.h \
+    $$PWD/include/equation.h \
+    $$PWD/include/frame_compression.h \
+    $$PWD/include/frame_parser.h \
+    $$PWD/include/handshake.h \
+    $$PWD/include/hash_ring.h \
+    $$PWD/include/lane_scheduler.h \
+    $$PWD/include/logger.h \
+    $$PWD/include/metrics.h \
+    $$PWD/include/mock_server.h \
+    $$PWD/include/network_worker.h \
+    $$PWD/include/result_store.h \
+    $$PWD/include/timer_wheel.h \
+    $$PWD/include/token_bucket.h \
+    $$PWD/include/trace.h \
+    $$PWD/include/transport.h
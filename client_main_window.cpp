@@ -3,12 +3,57 @@
 #include "reg_form.h"
 #include "client.h"
 #include "clients_func.h"
+#include "logger.h"
+#include "trace.h"
 #include <QMessageBox>
 #include <QLabel>
+#include <QPointer>
+#include <QShortcut>
 #include "notification.h"
+#include <QBoxLayout>
+#include <algorithm>
+#include <cmath>
 
 #define NOTIFICATION_ERROR "Убедитесь, что вы ввели корректные коэффициенты."
 
+/**
+ * @brief Применяет знак, выбранный в комбобоксе, к коэффициенту
+ * @param sign Комбобокс со знаком коэффициента
+ * @param value Значение из поля ввода
+ * @return Коэффициент с учётом знака
+ */
+static double with_sign(const QComboBox* sign, double value) {
+    return sign->currentText().trimmed() == "-" ? -value : value;
+}
+
+/**
+ * @brief Сравнивает ответы локального решателя и сервера
+ * @param local Ответ локального решателя
+ * @param remote Ответ сервера
+ * @return true если ответы совпадают с точностью до погрешности вычислений
+ */
+static bool same_answer(const QString& local, const QString& remote) {
+    QStringList local_roots = local.split("$");
+    QStringList remote_roots = remote.split("$");
+    if (local_roots.size() != remote_roots.size())
+        return false;
+
+    for (int i = 0; i < local_roots.size(); i++) {
+        bool local_number = false;
+        bool remote_number = false;
+        double x = local_roots[i].toDouble(&local_number);
+        double y = remote_roots[i].toDouble(&remote_number);
+        if (!local_number or !remote_number) {
+            if (local_roots[i] != remote_roots[i])
+                return false;
+        }
+        else if (std::abs(x - y) > 1e-6 * std::max(1.0, std::abs(x))) {
+            return false;
+        }
+    }
+    return true;
+}
+
 /**
  * @brief Конструктор главного окна клиента
  * @param client Указатель на клиентское соединение
@@ -31,9 +76,26 @@ client_main_window::client_main_window(Client* client, QWidget *parent) :
     clients_func::equation(ui->Layout_quadratic, action::HIDE);
     ui->label_answer_x->hide();
 
-    // Подключение сигналов
-    connect(this->client, &Client::equation_ok, this, &client_main_window::slot_equation_ok);
-    connect(this->client, &Client::equation_fail, this, &client_main_window::slot_equation_fail);
+    // Переключатель места решения уравнения
+    this->comboBox_solve_mode = new QComboBox(this);
+    this->comboBox_solve_mode->addItem("Локально, с проверкой сервером", int(solve_mode::LOCAL_VERIFY));
+    this->comboBox_solve_mode->addItem("Локально", int(solve_mode::LOCAL));
+    this->comboBox_solve_mode->addItem("На сервере", int(solve_mode::REMOTE));
+    this->comboBox_solve_mode->setToolTip("Выберите, где решать уравнение.");
+    QBoxLayout* layout = qobject_cast<QBoxLayout*>(ui->comboBox->parentWidget()->layout());
+    if (layout != nullptr and layout->indexOf(ui->comboBox) >= 0)
+        layout->insertWidget(layout->indexOf(ui->comboBox) + 1, this->comboBox_solve_mode);
+    else
+        this->comboBox_solve_mode->setGeometry(ui->comboBox->geometry().translated(0, ui->comboBox->height() + 6));
+
+    // Esc отменяет ожидание ответа сервера на последнее уравнение
+    ui->pushButton_solve_equation->setToolTip("Решить уравнение. Esc - отменить ожидание ответа сервера.");
+    QShortcut* cancel_shortcut = new QShortcut(QKeySequence(Qt::Key_Escape), this);
+    connect(cancel_shortcut, &QShortcut::activated, this, [this]() {
+        if (this->pending_request != 0)
+            this->client->cancel(this->pending_request);
+        this->pending_request = 0;
+    });
 
     this->show();
 }
@@ -43,7 +105,7 @@ client_main_window::client_main_window(Client* client, QWidget *parent) :
  */
 client_main_window::~client_main_window()
 {
-    qDebug() << "Вызвался деструктор окна клиента";
+    LOG_DEBUG("ui", "Вызвался деструктор окна клиента");
     delete ui;
 }
 
@@ -81,13 +143,14 @@ void client_main_window::on_comboBox_activated(int index)
  */
 void client_main_window::on_pushButton_solve_equation_clicked()
 {
+    trace_span span("solve clicked", "ui");
     if (ui->comboBox->currentIndex() == 0) {
         // Обработка линейного уравнения
         bool bool_arg_a = false;
-        int arg_a = ui->lineEdit_a_linear->text().toDouble(&bool_arg_a);
+        double arg_a = ui->lineEdit_a_linear->text().toDouble(&bool_arg_a);
 
         bool bool_arg_b = false;
-        int arg_b = ui->lineEdit_b_linear->text().toDouble(&bool_arg_b);
+        double arg_b = ui->lineEdit_b_linear->text().toDouble(&bool_arg_b);
 
         if (bool_arg_a and bool_arg_b) {
             QString text_in_dialogbox = QString("Ваше уравнение: %1%2x%3%4 = 0")
@@ -96,14 +159,11 @@ void client_main_window::on_pushButton_solve_equation_clicked()
                 .arg(ui->comboBox_sign2_linear->currentText())
                 .arg(ui->lineEdit_b_linear->text());
 
-            qDebug() << text_in_dialogbox;
+            LOG_DEBUG("ui", text_in_dialogbox);
 
-            // Формируем и отправляем уравнение на сервер
-            this->client->write(QString("equation|linear|%1%2$%3%4")
-                .arg(ui->comboBox_sign_linear->currentText())
-                .arg(ui->lineEdit_a_linear->text())
-                .arg(ui->comboBox_sign2_linear->currentText())
-                .arg(ui->lineEdit_b_linear->text()));
+            trace::complete("parse input", "ui", span.start());
+            this->solve(equation_request::linear(with_sign(ui->comboBox_sign_linear, arg_a),
+                                                 with_sign(ui->comboBox_sign2_linear, arg_b)));
         }
         else {
             new notification("Ошибка", NOTIFICATION_ERROR, this);
@@ -112,35 +172,91 @@ void client_main_window::on_pushButton_solve_equation_clicked()
     else if (ui->comboBox->currentIndex() == 1) {
         // Обработка квадратного уравнения
         bool bool_arg_a = false;
-        int arg_a = ui->lineEdit_a_quadratic->text().toDouble(&bool_arg_a);
+        double arg_a = ui->lineEdit_a_quadratic->text().toDouble(&bool_arg_a);
         bool bool_arg_b = false;
-        int arg_b = ui->lineEdit_b_quadratic->text().toDouble(&bool_arg_b);
+        double arg_b = ui->lineEdit_b_quadratic->text().toDouble(&bool_arg_b);
         bool bool_arg_c = false;
-        int arg_c = ui->lineEdit_c_quadratic->text().toDouble(&bool_arg_c);
+        double arg_c = ui->lineEdit_c_quadratic->text().toDouble(&bool_arg_c);
 
         if (bool_arg_a and bool_arg_b and bool_arg_c) {
-            // Формируем и отправляем уравнение на сервер
-            this->client->write((QString("equation|quadratic|%1%2$%3%4$%5%6")
-                .arg(ui->comboBox_sign2_quardratic->currentText())
-                .arg(ui->lineEdit_a_quadratic->text())
-                .arg(ui->comboBox_sign2_quadratic_2->currentText())
-                .arg(ui->lineEdit_b_quadratic->text())
-                .arg(ui->comboBox_sign2_quadratic_3->currentText())
-                .arg(ui->lineEdit_c_quadratic->text()));
+            trace::complete("parse input", "ui", span.start());
+            this->solve(equation_request::quadratic(with_sign(ui->comboBox_sign2_quardratic, arg_a),
+                                                    with_sign(ui->comboBox_sign2_quadratic_2, arg_b),
+                                                    with_sign(ui->comboBox_sign2_quadratic_3, arg_c)));
         }
         else {
-            qDebug() << bool_arg_a << " " << bool_arg_b << " " << bool_arg_c;
+            LOG_DEBUG("ui", QString("Разбор коэффициентов: a %1, b %2, c %3").arg(bool_arg_a).arg(bool_arg_b).arg(bool_arg_c));
             new notification("Ошибка", NOTIFICATION_ERROR);
         }
     }
 }
 
+/**
+ * @brief Решает уравнение в выбранном режиме
+ * @param equation Уравнение с учётом знаков коэффициентов
+ *
+ * В режиме "локально, с проверкой сервером" ответ локального решателя
+ * показывается сразу, а ответ сервера заменяет его, только если они
+ * различаются. Без подключения к серверу проверка пропускается.
+ */
+void client_main_window::solve(const equation_request& equation)
+{
+    solve_mode mode = solve_mode(this->comboBox_solve_mode->currentData().toInt());
+    if (mode == solve_mode::REMOTE) {
+        this->pending_request = this->client->solve(equation, this->make_answer_handler());
+        return;
+    }
+
+    QString answer = this->solver.solve(equation);
+    this->show_answer(answer, bisection_solver::has_roots(answer));
+    if (mode == solve_mode::LOCAL or !this->client->is_connected())
+        return;
+
+    QPointer<client_main_window> window(this);
+    this->pending_request = this->client->solve(equation, [window, answer](QString remote, bool solved) {
+        // Без ответа сервера (отмена, истёк срок) остаётся локальный ответ
+        if (window.isNull() or same_answer(answer, remote) or remote == "canceled" or remote == "timeout")
+            return;
+        LOG_WARNING("ui", QString("Ответ сервера отличается от локального: %1 вместо %2").arg(remote, answer));
+        window->show_answer(remote, solved);
+    });
+}
+
+/**
+ * @brief Отображает ответ на уравнение
+ * @param answer Ответ в формате сервера
+ * @param solved true если ответ содержит корни
+ */
+void client_main_window::show_answer(QString answer, bool solved)
+{
+    if (solved)
+        this->slot_equation_ok(answer);
+    else
+        this->slot_equation_fail(answer);
+}
+
+/**
+ * @brief Создаёт обработчик ответа на уравнение, отправленное из этого окна
+ * @return Обработчик, передающий ответ в show_answer
+ *
+ * Если окно закрыто до получения ответа, ответ игнорируется.
+ */
+Client::answer_handler client_main_window::make_answer_handler()
+{
+    QPointer<client_main_window> window(this);
+    return [window](QString answer, bool solved) {
+        if (!window.isNull())
+            window->show_answer(answer, solved);
+    };
+}
+
 /**
  * @brief Слот успешного решения уравнения
  * @param answer Ответ сервера с решением
  */
 void client_main_window::slot_equation_ok(QString answer)
 {
+    trace_span span("update answer", "ui");
     QStringList answers = answer.split("$");
     QString text_for_notification = QString("Ответ: ");
 
@@ -164,6 +280,7 @@ void client_main_window::slot_equation_ok(QString answer)
  */
 void client_main_window::slot_equation_fail(QString& fail)
 {
+    trace_span span("update answer", "ui");
     QString text_for_answer = QString("Ошибка: %1").arg(fail);
     this->ui->label_answer_x->setText(text_for_answer);
     this->ui->label_answer_x->resize(ui->label_answer_x->sizeHint());
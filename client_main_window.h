@@ -4,11 +4,22 @@
 #include <QMainWindow>
 #include <QLineEdit>
 #include <QIntValidator>
+#include <QComboBox>
 #include "notification.h"
+#include "client.h"
+#include "bisection_solver.h"
 
 // Предварительные объявления классов
 class Widget; ///< Класс окна регистрации
-class Client; ///< Класс клиентского соединения
+
+/**
+ * @brief Место решения уравнения
+ */
+enum class solve_mode {
+    LOCAL_VERIFY, ///< Локально, затем проверка ответом сервера
+    LOCAL,        ///< Только локальный решатель
+    REMOTE,       ///< Только сервер
+};
 
 namespace Ui {
 class client_main_window;
@@ -67,8 +78,30 @@ private slots:
     void slot_equation_fail(QString& fail);
 
 private:
+    /**
+     * @brief Решает уравнение в выбранном режиме
+     * @param equation Уравнение с учётом знаков коэффициентов
+     */
+    void solve(const equation_request& equation);
+
+    /**
+     * @brief Отображает ответ на уравнение
+     * @param answer Ответ в формате сервера
+     * @param solved true если ответ содержит корни
+     */
+    void show_answer(QString answer, bool solved);
+
+    /**
+     * @brief Создаёт обработчик ответа на уравнение, отправленное из этого окна
+     * @return Обработчик ответа для Client::write_request
+     */
+    Client::answer_handler make_answer_handler();
+
     Ui::client_main_window *ui; ///< Указатель на графический интерфейс
     Client* client = nullptr;   ///< Указатель на клиентское соединение
+    QComboBox* comboBox_solve_mode = nullptr; ///< Переключатель места решения уравнения
+    bisection_solver solver;    ///< Локальный решатель
+    quint32 pending_request = 0; ///< Последний запрос к серверу (для отмены по Esc)
 };
 
 #endif // CLIENT_MAIN_WINDOW_H
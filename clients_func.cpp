@@ -1,10 +1,12 @@
 #include "clients_func.h"
+#include "logger.h"
 #include <QApplication>
 #include <QVector>
 #include <QRandomGenerator>
 #include <QWidget>
 #include <QLineEdit>
 #include <QCryptographicHash>
+#include <QDateTime>
 
 /**
  * @brief Проверяет строку на допустимые символы
@@ -146,13 +148,19 @@ bool clients_func::current_email(QString email) {
 /**
  * @brief Возвращает текущее время в формате строки
  * @return Строка с текущим временем в формате "[Месяц День Год Часы:Минуты:Секунды]"
+ *
+ * Время берётся из грубых часов журнала (logger::now_ms), а строка
+ * формируется заново только при смене секунды.
  */
 QString clients_func::get_client_time() {
-    time_t now_time = time(nullptr);
-    tm* time_struct = localtime(&now_time);
-    char time_format[100];
-    strftime(time_format, sizeof(time_format), "[%b %d %Y %H:%M:%S]", time_struct);
-    return QString(time_format);
+    thread_local qint64 cached_second = -1;
+    thread_local QString cached_time;
+    qint64 second = logger::now_ms() / 1000;
+    if (second != cached_second) {
+        cached_second = second;
+        cached_time = QDateTime::fromMSecsSinceEpoch(second * 1000).toString("[MMM dd yyyy HH:mm:ss]");
+    }
+    return cached_time;
 }
 
 /**
@@ -0,0 +1,153 @@
+#include "endpoint.h"
+#include "logger.h"
+#include <QSettings>
+#include <QUrl>
+
+/**
+ * @brief Создаёт TCP-адрес
+ * @param host Адрес сервера
+ * @param port Порт сервера
+ * @return Адрес
+ */
+endpoint endpoint::tcp(const QString& host, quint16 port) {
+    endpoint result;
+    result.type = kind::TCP;
+    result.host = host;
+    result.port = port;
+    return result;
+}
+
+/**
+ * @brief Создаёт адрес локального сокета
+ * @param name Путь или имя сокета
+ * @return Адрес
+ */
+endpoint endpoint::local(const QString& name) {
+    endpoint result;
+    result.type = kind::LOCAL;
+    result.name = name;
+    return result;
+}
+
+/**
+ * @brief Разбирает адрес из строки
+ * @param text Строка адреса
+ * @param out Разобранный адрес
+ * @return false если строка некорректна
+ */
+bool endpoint::parse(const QString& text, endpoint& out) {
+    QString value = text.trimmed();
+    for (const char* prefix : {"unix:", "local:"}) {
+        if (value.startsWith(prefix)) {
+            QString name = value.mid(int(qstrlen(prefix)));
+            if (name.isEmpty())
+                return false;
+            out = endpoint::local(name);
+            return true;
+        }
+    }
+
+    if (!value.contains("://"))
+        value.prepend("tcp://");
+    QUrl url(value, QUrl::StrictMode);
+    if (!url.isValid() or url.scheme() != "tcp" or url.host().isEmpty())
+        return false;
+    int port = url.port(endpoint::default_port);
+    if (port <= 0 or port > 65535)
+        return false;
+    out = endpoint::tcp(url.host(), quint16(port));
+    return true;
+}
+
+/**
+ * @brief Собирает значения настройки по убыванию приоритета
+ * @param arguments Аргументы командной строки
+ * @param option Имя параметра командной строки ("--server")
+ * @param environment Имя переменной окружения
+ * @param key Ключ в client.ini
+ * @return Непустые значения: из командной строки, окружения и файла настроек
+ */
+static QStringList setting_candidates(const QStringList& arguments, const QString& option,
+                                      const char* environment, const QString& key) {
+    QStringList candidates;
+    for (int i = 1; i < arguments.size(); i++) {
+        if (arguments[i] == option and i + 1 < arguments.size())
+            candidates.append(arguments[i + 1]);
+        else if (arguments[i].startsWith(option + "="))
+            candidates.append(arguments[i].mid(option.size() + 1));
+    }
+    candidates.append(qEnvironmentVariable(environment));
+    candidates.append(QSettings(ENDPOINT_CONFIG_FILE, QSettings::IniFormat).value(key).toString());
+    candidates.removeAll(QString());
+    return candidates;
+}
+
+/**
+ * @brief Возвращает настроенный адрес сервера
+ * @param arguments Аргументы командной строки
+ * @return Первый адрес из endpoint::configured_fleet
+ */
+endpoint endpoint::configured(const QStringList& arguments) {
+    return endpoint::configured_fleet(arguments).first();
+}
+
+/**
+ * @brief Возвращает настроенный список серверов
+ * @param arguments Аргументы командной строки
+ * @return Адреса из "--server <адрес>[,<адрес>...]" (или "--server=..."),
+ *         иначе из переменной окружения SOLVER_ENDPOINT, иначе из
+ *         client.ini, иначе один адрес 127.0.0.1:8080
+ *
+ * Некорректные адреса пропускаются с сообщением в отладочный вывод.
+ * Используется первая настройка, в которой есть хотя бы один
+ * корректный адрес.
+ */
+QList<endpoint> endpoint::configured_fleet(const QStringList& arguments) {
+    QStringList candidates = setting_candidates(arguments, "--server", ENDPOINT_ENVIRONMENT, "server/endpoint");
+    for (const QString& candidate : std::as_const(candidates)) {
+        QList<endpoint> result;
+        for (const QString& item : candidate.split(',', Qt::SkipEmptyParts)) {
+            endpoint address;
+            if (endpoint::parse(item, address))
+                result.append(address);
+            else
+                LOG_WARNING("endpoint", "Некорректный адрес сервера: " + item);
+        }
+        if (!result.isEmpty())
+            return result;
+    }
+    return {endpoint()};
+}
+
+/**
+ * @brief Возвращает настроенный адрес резервного соединения
+ * @param arguments Аргументы командной строки
+ * @param primary Адрес основного сервера
+ * @param out Адрес резервного соединения
+ * @return false если резервное соединение не настроено
+ *
+ * Значение "same" означает второе соединение с основным сервером.
+ */
+bool endpoint::configured_standby(const QStringList& arguments, const endpoint& primary, endpoint& out) {
+    QStringList candidates = setting_candidates(arguments, "--standby", STANDBY_ENVIRONMENT, "server/standby");
+    for (const QString& candidate : std::as_const(candidates)) {
+        if (candidate == "same") {
+            out = primary;
+            return true;
+        }
+        if (endpoint::parse(candidate, out))
+            return true;
+        LOG_WARNING("endpoint", "Некорректный адрес резервного сервера: " + candidate);
+    }
+    return false;
+}
+
+/**
+ * @brief Возвращает адрес строкой
+ * @return "tcp://host:port" или "unix:name"
+ */
+QString endpoint::to_string() const {
+    if (this->type == kind::LOCAL)
+        return "unix:" + this->name;
+    return QString("tcp://%1:%2").arg(this->host.contains(':') ? "[" + this->host + "]" : this->host).arg(this->port);
+}
@@ -0,0 +1,97 @@
+#ifndef ENDPOINT_H
+#define ENDPOINT_H
+
+#include <QList>
+#include <QString>
+#include <QStringList>
+
+/// Переменная окружения с адресом сервера (или списком адресов через запятую)
+#define ENDPOINT_ENVIRONMENT "SOLVER_ENDPOINT"
+/// Переменная окружения с адресом резервного соединения
+#define STANDBY_ENVIRONMENT "SOLVER_STANDBY_ENDPOINT"
+/// Файл настроек с адресом сервера (ключи server/endpoint и server/standby)
+#define ENDPOINT_CONFIG_FILE "client.ini"
+
+/**
+ * @brief Адрес сервера решения уравнений
+ *
+ * Записывается строкой:
+ * - "tcp://host:port", "host:port" или "host" - TCP (порт по умолчанию 8080);
+ * - "unix:/path/to/socket" или "local:name" - локальный сокет (QLocalSocket),
+ *   если сервер работает на той же машине.
+ */
+struct endpoint
+{
+    /**
+     * @brief Вид соединения
+     */
+    enum class kind {
+        TCP,   ///< TCP-соединение
+        LOCAL, ///< Локальный сокет (Unix domain socket / именованный канал)
+    };
+
+    static constexpr quint16 default_port = 8080; ///< Порт по умолчанию
+
+    kind type = kind::TCP;         ///< Вид соединения
+    QString host = "127.0.0.1";    ///< Адрес сервера (TCP)
+    quint16 port = default_port;   ///< Порт сервера (TCP)
+    QString name;                  ///< Путь или имя локального сокета (LOCAL)
+
+    /**
+     * @brief Создаёт TCP-адрес
+     * @param host Адрес сервера
+     * @param port Порт сервера
+     * @return Адрес
+     */
+    static endpoint tcp(const QString& host, quint16 port = default_port);
+
+    /**
+     * @brief Создаёт адрес локального сокета
+     * @param name Путь или имя сокета
+     * @return Адрес
+     */
+    static endpoint local(const QString& name);
+
+    /**
+     * @brief Разбирает адрес из строки
+     * @param text Строка адреса
+     * @param out Разобранный адрес
+     * @return false если строка некорректна
+     */
+    static bool parse(const QString& text, endpoint& out);
+
+    /**
+     * @brief Возвращает настроенный адрес сервера
+     * @param arguments Аргументы командной строки
+     * @return Адрес из "--server <адрес>", иначе из переменной окружения
+     *         SOLVER_ENDPOINT, иначе из client.ini, иначе 127.0.0.1:8080;
+     *         для списка серверов - первый из них
+     */
+    static endpoint configured(const QStringList& arguments);
+
+    /**
+     * @brief Возвращает настроенный список серверов
+     * @param arguments Аргументы командной строки
+     * @return Непустой список адресов; в настройке адреса перечисляются
+     *         через запятую: "--server host1:8080,host2:8080,unix:/tmp/s"
+     */
+    static QList<endpoint> configured_fleet(const QStringList& arguments);
+
+    /**
+     * @brief Возвращает настроенный адрес резервного соединения
+     * @param arguments Аргументы командной строки
+     * @param primary Адрес основного сервера
+     * @param out Адрес из "--standby <адрес>", переменной окружения
+     *        SOLVER_STANDBY_ENDPOINT или client.ini; "same" - основной сервер
+     * @return false если резервное соединение не настроено
+     */
+    static bool configured_standby(const QStringList& arguments, const endpoint& primary, endpoint& out);
+
+    /**
+     * @brief Возвращает адрес строкой
+     * @return "tcp://host:port" или "unix:name"
+     */
+    QString to_string() const;
+};
+
+#endif // ENDPOINT_H
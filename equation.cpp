@@ -0,0 +1,100 @@
+#include "equation.h"
+#include <QLocale>
+#include <QList>
+
+/**
+ * @brief Дописывает число в кратчайшем точном десятичном представлении
+ * @param out Буфер
+ * @param value Число
+ */
+static void append_number(QByteArray& out, double value) {
+    out.append(QByteArray::number(value, 'g', QLocale::FloatingPointShortest));
+}
+
+/**
+ * @brief Создаёт линейное уравнение ax + b = 0
+ * @param a Коэффициент при x
+ * @param b Свободный член
+ * @return Описание уравнения
+ */
+equation_request equation_request::linear(double a, double b) {
+    return equation_request{equation_type::LINEAR, a, b, 0};
+}
+
+/**
+ * @brief Создаёт квадратное уравнение ax² + bx + c = 0
+ * @param a Коэффициент при x²
+ * @param b Коэффициент при x
+ * @param c Свободный член
+ * @return Описание уравнения
+ */
+equation_request equation_request::quadratic(double a, double b, double c) {
+    return equation_request{equation_type::QUADRATIC, a, b, c};
+}
+
+/**
+ * @brief Возвращает имя вида уравнения в протоколе
+ * @return "linear" или "quadratic"
+ */
+const char* equation_request::type_name() const {
+    return this->type == equation_type::LINEAR ? "linear" : "quadratic";
+}
+
+/**
+ * @brief Дописывает уравнение в формате протокола "<вид>|a$b[$c]"
+ * @param out Буфер, в который дописывается уравнение
+ */
+void equation_request::append_to(QByteArray& out) const {
+    out.append(this->type_name());
+    out.append('|');
+    append_number(out, this->a);
+    out.append('$');
+    append_number(out, this->b);
+    if (this->type == equation_type::QUADRATIC) {
+        out.append('$');
+        append_number(out, this->c);
+    }
+}
+
+/**
+ * @brief Возвращает сообщение "equation|<вид>|a$b[$c]"
+ * @return Текст запроса для Client::write_request
+ */
+QString equation_request::to_message() const {
+    QByteArray message("equation|");
+    this->append_to(message);
+    return QString::fromLatin1(message);
+}
+
+/**
+ * @brief Разбирает уравнение в формате протокола "<вид>|a$b[$c]"
+ * @param text Текст уравнения
+ * @param out Разобранное уравнение
+ * @return false если вид неизвестен или коэффициенты некорректны
+ */
+bool equation_request::parse(QByteArrayView text, equation_request& out) {
+    qsizetype separator = text.indexOf('|');
+    if (separator < 0)
+        return false;
+
+    QByteArrayView type = text.first(separator);
+    QList<QByteArray> numbers = text.sliced(separator + 1).toByteArray().split('$');
+    double values[3] = {0, 0, 0};
+    if (type == "linear" and numbers.size() == 2)
+        out.type = equation_type::LINEAR;
+    else if (type == "quadratic" and numbers.size() == 3)
+        out.type = equation_type::QUADRATIC;
+    else
+        return false;
+
+    for (int i = 0; i < numbers.size(); i++) {
+        bool ok = false;
+        values[i] = numbers[i].toDouble(&ok);
+        if (!ok)
+            return false;
+    }
+    out.a = values[0];
+    out.b = values[1];
+    out.c = values[2];
+    return true;
+}
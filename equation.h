@@ -0,0 +1,81 @@
+#ifndef EQUATION_H
+#define EQUATION_H
+
+#include <QByteArray>
+#include <QByteArrayView>
+#include <QString>
+
+/**
+ * @brief Вид уравнения
+ */
+enum class equation_type {
+    LINEAR,    ///< Линейное уравнение ax + b = 0
+    QUADRATIC, ///< Квадратное уравнение ax² + bx + c = 0
+};
+
+/**
+ * @brief Коэффициенты одного уравнения
+ *
+ * Для линейного уравнения коэффициент c не используется.
+ */
+struct equation_request
+{
+    equation_type type = equation_type::LINEAR; ///< Вид уравнения
+    double a = 0; ///< Старший коэффициент
+    double b = 0; ///< Второй коэффициент
+    double c = 0; ///< Свободный член квадратного уравнения
+
+    /**
+     * @brief Создаёт линейное уравнение ax + b = 0
+     * @param a Коэффициент при x
+     * @param b Свободный член
+     * @return Описание уравнения
+     */
+    static equation_request linear(double a, double b);
+
+    /**
+     * @brief Создаёт квадратное уравнение ax² + bx + c = 0
+     * @param a Коэффициент при x²
+     * @param b Коэффициент при x
+     * @param c Свободный член
+     * @return Описание уравнения
+     */
+    static equation_request quadratic(double a, double b, double c);
+
+    /**
+     * @brief Возвращает имя вида уравнения в протоколе
+     * @return "linear" или "quadratic"
+     */
+    const char* type_name() const;
+
+    /**
+     * @brief Дописывает уравнение в формате протокола "<вид>|a$b[$c]"
+     * @param out Буфер, в который дописывается уравнение
+     */
+    void append_to(QByteArray& out) const;
+
+    /**
+     * @brief Возвращает сообщение "equation|<вид>|a$b[$c]"
+     * @return Текст запроса для Client::write_request
+     */
+    QString to_message() const;
+
+    /**
+     * @brief Разбирает уравнение в формате протокола "<вид>|a$b[$c]"
+     * @param text Текст уравнения
+     * @param out Разобранное уравнение
+     * @return false если вид неизвестен или коэффициенты некорректны
+     */
+    static bool parse(QByteArrayView text, equation_request& out);
+};
+
+/**
+ * @brief Результат решения одного уравнения
+ */
+struct solve_result
+{
+    QString answer;      ///< Ответ в формате сервера ("x1$x2", "no_solution", ...)
+    bool solved = false; ///< true если ответ содержит корни
+};
+
+#endif // EQUATION_H
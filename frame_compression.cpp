@@ -0,0 +1,134 @@
+#include "frame_compression.h"
+#include "frame_parser.h"
+#include <QtEndian>
+#ifdef HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+/// Уровень сжатия zlib (быстрое сжатие, текст пакетов всё равно сжимается хорошо)
+#define ZLIB_LEVEL 1
+/// Уровень сжатия zstd
+#define ZSTD_LEVEL 3
+
+/**
+ * @brief Возвращает степень сжатия
+ * @return Отношение размера до сжатия к размеру после (1 - сжатия не было)
+ */
+double compression_stats::ratio() const {
+    qint64 packed = this->sent_packed + this->received_packed;
+    qint64 raw = this->sent_raw + this->received_raw;
+    return packed > 0 ? double(raw) / packed : 1.0;
+}
+
+/**
+ * @brief Прибавляет счётчики другого соединения
+ * @param other Счётчики
+ * @return Ссылка на себя
+ */
+compression_stats& compression_stats::operator+=(const compression_stats& other) {
+    this->frames_packed += other.frames_packed;
+    this->sent_raw += other.sent_raw;
+    this->sent_packed += other.sent_packed;
+    this->frames_unpacked += other.frames_unpacked;
+    this->received_packed += other.received_packed;
+    this->received_raw += other.received_raw;
+    this->compress_ns += other.compress_ns;
+    this->decompress_ns += other.decompress_ns;
+    return *this;
+}
+
+/**
+ * @brief Проверяет, поддерживает ли сборка zstd
+ * @return true если собрано с HAVE_ZSTD
+ */
+bool frame_compression::zstd_available() {
+#ifdef HAVE_ZSTD
+    return true;
+#else
+    return false;
+#endif
+}
+
+/**
+ * @brief Проверяет, является ли сообщение сжатым
+ * @param message Содержимое кадра
+ * @return true если сообщение начинается с тега сжатия
+ */
+bool frame_compression::is_compressed(QByteArrayView message) {
+    return !message.isEmpty()
+           and (message[0] == frame_compression::zlib_tag or message[0] == frame_compression::zstd_tag);
+}
+
+/**
+ * @brief Сжимает сообщение
+ * @param method Алгоритм
+ * @param message Сообщение
+ * @param out Сжатое сообщение с тегом
+ * @return false если сжатие недоступно или не уменьшает сообщение
+ */
+bool frame_compression::compress(compression method, QByteArrayView message, QByteArray& out) {
+    if (method == compression::ZLIB) {
+        // qCompress пишет перед данными zlib размер исходного сообщения (4 байта, big-endian)
+        QByteArray packed = qCompress(reinterpret_cast<const uchar*>(message.data()), message.size(), ZLIB_LEVEL);
+        if (packed.isEmpty() or packed.size() + 1 >= message.size())
+            return false;
+        out.clear();
+        out.reserve(packed.size() + 1);
+        out.append(frame_compression::zlib_tag);
+        out.append(packed);
+        return true;
+    }
+#ifdef HAVE_ZSTD
+    if (method == compression::ZSTD) {
+        std::size_t capacity = ZSTD_compressBound(std::size_t(message.size()));
+        out.resize(qsizetype(capacity) + 1);
+        out[0] = frame_compression::zstd_tag;
+        std::size_t size = ZSTD_compress(out.data() + 1, capacity, message.data(), std::size_t(message.size()),
+                                         ZSTD_LEVEL);
+        if (ZSTD_isError(size) or qsizetype(size) + 1 >= message.size()) {
+            out.clear();
+            return false;
+        }
+        out.resize(qsizetype(size) + 1);
+        return true;
+    }
+#endif
+    return false;
+}
+
+/**
+ * @brief Распаковывает сообщение
+ * @param message Сжатое сообщение с тегом
+ * @param out Исходное сообщение
+ * @return false если данные повреждены или больше frame_parser::max_frame_size
+ *
+ * Размер исходного сообщения проверяется до выделения памяти, поэтому
+ * небольшой повреждённый кадр не может заставить выделить гигабайты.
+ */
+bool frame_compression::decompress(QByteArrayView message, QByteArray& out) {
+    if (!frame_compression::is_compressed(message))
+        return false;
+    QByteArrayView packed = message.sliced(1);
+
+    if (message[0] == frame_compression::zlib_tag) {
+        if (packed.size() < 4 or qFromBigEndian<quint32>(packed.data()) > quint32(frame_parser::max_frame_size))
+            return false;
+        out = qUncompress(reinterpret_cast<const uchar*>(packed.data()), packed.size());
+        return !out.isEmpty();
+    }
+#ifdef HAVE_ZSTD
+    unsigned long long size = ZSTD_getFrameContentSize(packed.data(), std::size_t(packed.size()));
+    if (size == ZSTD_CONTENTSIZE_ERROR or size == ZSTD_CONTENTSIZE_UNKNOWN
+        or size > quint64(frame_parser::max_frame_size))
+        return false;
+    out.resize(qsizetype(size));
+    std::size_t result = ZSTD_decompress(out.data(), std::size_t(size), packed.data(), std::size_t(packed.size()));
+    if (ZSTD_isError(result) or result != size) {
+        out.clear();
+        return false;
+    }
+    return true;
+#else
+    return false;
+#endif
+}
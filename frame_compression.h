@@ -0,0 +1,100 @@
+#ifndef FRAME_COMPRESSION_H
+#define FRAME_COMPRESSION_H
+
+#include <QByteArray>
+#include <QByteArrayView>
+
+/**
+ * @brief Алгоритм сжатия сообщений
+ */
+enum class compression {
+    NONE, ///< Без сжатия
+    ZLIB, ///< qCompress (zlib)
+    ZSTD, ///< zstd (только в сборке с HAVE_ZSTD)
+};
+
+/**
+ * @brief Счётчики сжатия одного или нескольких соединений
+ *
+ * Время - полное время вызовов сжатия и распаковки в сетевом потоке;
+ * они выполняются без ожидания, поэтому это время процессора.
+ */
+struct compression_stats
+{
+    qint64 frames_packed = 0;    ///< Отправлено сжатых сообщений
+    qint64 sent_raw = 0;         ///< Размер сжатых отправленных сообщений до сжатия
+    qint64 sent_packed = 0;      ///< Размер сжатых отправленных сообщений после сжатия
+    qint64 frames_unpacked = 0;  ///< Получено сжатых сообщений
+    qint64 received_packed = 0;  ///< Размер сжатых полученных сообщений
+    qint64 received_raw = 0;     ///< Размер сжатых полученных сообщений после распаковки
+    qint64 compress_ns = 0;      ///< Время сжатия
+    qint64 decompress_ns = 0;    ///< Время распаковки
+
+    /**
+     * @brief Возвращает степень сжатия
+     * @return Отношение размера до сжатия к размеру после (1 - сжатия не было)
+     */
+    double ratio() const;
+
+    /**
+     * @brief Прибавляет счётчики другого соединения
+     * @param other Счётчики
+     * @return Ссылка на себя
+     */
+    compression_stats& operator+=(const compression_stats& other);
+};
+
+/**
+ * @brief Сжатие отдельных сообщений
+ *
+ * Сжатое сообщение - байт тега алгоритма и сжатые данные исходного
+ * сообщения (текстового или binary_codec). Теги не пересекаются с
+ * тегами binary_codec и не являются буквами, поэтому сжатое сообщение
+ * отличается от остальных по первому байту. Сжимаются только сообщения
+ * не короче порога: короткие интерактивные запросы сжатие только
+ * замедлит.
+ */
+class frame_compression
+{
+private:
+    frame_compression() = delete;                         ///< Запрет создания экземпляров
+    frame_compression(const frame_compression&) = delete; ///< Запрет копирования
+    ~frame_compression() = delete;                        ///< Запрет удаления
+
+public:
+    static constexpr char zlib_tag = '\x10';                 ///< Сообщение сжато zlib
+    static constexpr char zstd_tag = '\x11';                 ///< Сообщение сжато zstd
+    static constexpr qsizetype default_threshold = 1024;     ///< Порог сжатия по умолчанию, байт
+
+    /**
+     * @brief Проверяет, поддерживает ли сборка zstd
+     * @return true если собрано с HAVE_ZSTD
+     */
+    static bool zstd_available();
+
+    /**
+     * @brief Проверяет, является ли сообщение сжатым
+     * @param message Содержимое кадра
+     * @return true если сообщение начинается с тега сжатия
+     */
+    static bool is_compressed(QByteArrayView message);
+
+    /**
+     * @brief Сжимает сообщение
+     * @param method Алгоритм
+     * @param message Сообщение
+     * @param out Сжатое сообщение с тегом
+     * @return false если сжатие недоступно или не уменьшает сообщение
+     */
+    static bool compress(compression method, QByteArrayView message, QByteArray& out);
+
+    /**
+     * @brief Распаковывает сообщение
+     * @param message Сжатое сообщение с тегом
+     * @param out Исходное сообщение
+     * @return false если данные повреждены или больше frame_parser::max_frame_size
+     */
+    static bool decompress(QByteArrayView message, QByteArray& out);
+};
+
+#endif // FRAME_COMPRESSION_H
@@ -0,0 +1,178 @@
+#include "frame_parser.h"
+#include <QtEndian>
+#include <cstring>
+
+/**
+ * @brief Конструктор разборщика
+ * @param mode Начальный режим кадрирования
+ */
+frame_parser::frame_parser(framing mode) : current_mode(mode) {}
+
+/**
+ * @brief Переключает режим кадрирования
+ * @param mode Новый режим
+ */
+void frame_parser::set_mode(framing mode) {
+    this->current_mode = mode;
+    this->scan = this->offset;
+}
+
+/**
+ * @brief Возвращает текущий режим кадрирования
+ * @return Режим кадрирования
+ */
+framing frame_parser::mode() const {
+    return this->current_mode;
+}
+
+/**
+ * @brief Дописывает полученные байты в приёмный буфер
+ * @param data Данные, прочитанные из сокета
+ *
+ * Обработанная часть буфера удаляется только когда она занимает больше
+ * половины буфера, поэтому каждый байт переносится в среднем не более одного раза.
+ */
+void frame_parser::feed(QByteArrayView data) {
+    if (this->offset == this->buffer.size()) {
+        // Всё разобрано: переиспользуем выделенную память без копирования
+        this->buffer.resize(0);
+        this->offset = 0;
+        this->scan = 0;
+    }
+    else if (this->offset > this->buffer.size() / 2) {
+        this->buffer.remove(0, this->offset);
+        this->scan -= this->offset;
+        this->offset = 0;
+    }
+    this->buffer.append(data.data(), data.size());
+}
+
+/**
+ * @brief Извлекает следующий полный кадр
+ * @param frame Представление содержимого кадра
+ * @return true если кадр извлечён, false если данных недостаточно
+ */
+bool frame_parser::next(QByteArrayView& frame) {
+    if (this->error)
+        return false;
+
+    const char* begin = this->buffer.constData();
+    qsizetype available = this->buffer.size() - this->offset;
+    if (available <= 0)
+        return false;
+
+    switch (this->current_mode) {
+    case framing::PLAIN:
+        // Старое поведение: всё, что пришло, считается одним сообщением
+        frame = QByteArrayView(begin + this->offset, available);
+        this->offset = this->buffer.size();
+        this->scan = this->offset;
+        return true;
+
+    case framing::LENGTH_PREFIXED: {
+        if (available < qsizetype(sizeof(quint32)))
+            return false;
+        qsizetype length = qFromBigEndian<quint32>(begin + this->offset);
+        if (length > max_frame_size) {
+            this->error = true;
+            return false;
+        }
+        if (available < qsizetype(sizeof(quint32)) + length)
+            return false;
+        frame = QByteArrayView(begin + this->offset + sizeof(quint32), length);
+        this->offset += sizeof(quint32) + length;
+        this->scan = this->offset;
+        return true;
+    }
+
+    case framing::DELIMITED: {
+        // Продолжаем поиск с места, где остановились в прошлый раз
+        const void* found = std::memchr(begin + this->scan, delimiter, this->buffer.size() - this->scan);
+        if (found == nullptr) {
+            this->scan = this->buffer.size();
+            if (this->scan - this->offset > max_frame_size)
+                this->error = true;
+            return false;
+        }
+        qsizetype end = static_cast<const char*>(found) - begin;
+        frame = QByteArrayView(begin + this->offset, end - this->offset);
+        this->offset = end + 1;
+        this->scan = this->offset;
+        return true;
+    }
+    }
+    return false;
+}
+
+/**
+ * @brief Возвращает ещё не разобранные байты
+ * @return Представление необработанной части буфера
+ */
+QByteArrayView frame_parser::pending() const {
+    return QByteArrayView(this->buffer.constData() + this->offset, this->buffer.size() - this->offset);
+}
+
+/**
+ * @brief Отбрасывает первые count необработанных байт
+ * @param count Количество байт
+ */
+void frame_parser::consume(qsizetype count) {
+    this->offset = qMin(this->offset + count, this->buffer.size());
+    this->scan = qMax(this->scan, this->offset);
+}
+
+/**
+ * @brief Проверяет, встретился ли некорректный кадр
+ * @return true если поток испорчен
+ */
+bool frame_parser::has_error() const {
+    return this->error;
+}
+
+/**
+ * @brief Очищает буфер и сбрасывает ошибку
+ */
+void frame_parser::reset() {
+    this->buffer.resize(0);
+    this->offset = 0;
+    this->scan = 0;
+    this->error = false;
+}
+
+/**
+ * @brief Упаковывает сообщение в кадр
+ * @param mode Режим кадрирования
+ * @param payload Содержимое сообщения
+ * @return Готовый к отправке кадр
+ */
+QByteArray frame_parser::encode(framing mode, QByteArrayView payload) {
+    QByteArray out;
+    out.reserve(payload.size() + sizeof(quint32));
+    frame_parser::encode_into(mode, payload, out);
+    return out;
+}
+
+/**
+ * @brief Дописывает кадр с сообщением в конец буфера
+ * @param mode Режим кадрирования
+ * @param payload Содержимое сообщения
+ * @param out Буфер, в который дописывается кадр
+ */
+void frame_parser::encode_into(framing mode, QByteArrayView payload, QByteArray& out) {
+    switch (mode) {
+    case framing::PLAIN:
+        out.append(payload.data(), payload.size());
+        break;
+    case framing::LENGTH_PREFIXED: {
+        char header[sizeof(quint32)];
+        qToBigEndian<quint32>(quint32(payload.size()), header);
+        out.append(header, sizeof(header));
+        out.append(payload.data(), payload.size());
+        break;
+    }
+    case framing::DELIMITED:
+        out.append(payload.data(), payload.size());
+        out.append(delimiter);
+        break;
+    }
+}
@@ -0,0 +1,112 @@
+#ifndef FRAME_PARSER_H
+#define FRAME_PARSER_H
+
+#include <QByteArray>
+#include <QByteArrayView>
+
+/**
+ * @brief Режим кадрирования сообщений в потоке TCP
+ */
+enum class framing {
+    PLAIN,           ///< Без кадрирования: всё прочитанное считается одним сообщением (старые серверы)
+    LENGTH_PREFIXED, ///< Перед сообщением идёт его длина (4 байта, big-endian)
+    DELIMITED,       ///< Сообщение завершается символом '\n'
+};
+
+/**
+ * @brief Инкрементальный разборщик кадров входящего потока
+ *
+ * Хранит постоянный приёмный буфер: данные дописываются в конец,
+ * готовые кадры выдаются как представления (QByteArrayView) внутрь буфера
+ * без копирования. Прочитанная часть буфера удаляется лениво, поэтому
+ * недочитанный хвост не копируется при каждом чтении из сокета.
+ */
+class frame_parser
+{
+public:
+    static constexpr qsizetype max_frame_size = 16 * 1024 * 1024; ///< Максимальный размер кадра
+    static constexpr char delimiter = '\n';                         ///< Разделитель кадров в режиме DELIMITED
+
+    /**
+     * @brief Конструктор разборщика
+     * @param mode Начальный режим кадрирования
+     */
+    explicit frame_parser(framing mode = framing::PLAIN);
+
+    /**
+     * @brief Переключает режим кадрирования
+     * @param mode Новый режим
+     *
+     * Уже накопленные, но не разобранные байты разбираются в новом режиме.
+     */
+    void set_mode(framing mode);
+
+    /**
+     * @brief Возвращает текущий режим кадрирования
+     * @return Режим кадрирования
+     */
+    framing mode() const;
+
+    /**
+     * @brief Дописывает полученные байты в приёмный буфер
+     * @param data Данные, прочитанные из сокета
+     */
+    void feed(QByteArrayView data);
+
+    /**
+     * @brief Извлекает следующий полный кадр
+     * @param frame Представление содержимого кадра (без заголовка/разделителя)
+     * @return true если кадр извлечён, false если данных недостаточно
+     *
+     * Представление действительно до следующего вызова feed() или reset().
+     */
+    bool next(QByteArrayView& frame);
+
+    /**
+     * @brief Возвращает ещё не разобранные байты
+     * @return Представление необработанной части буфера
+     */
+    QByteArrayView pending() const;
+
+    /**
+     * @brief Отбрасывает первые count необработанных байт
+     * @param count Количество байт
+     */
+    void consume(qsizetype count);
+
+    /**
+     * @brief Проверяет, встретился ли некорректный кадр
+     * @return true если поток испорчен (например, превышен max_frame_size)
+     */
+    bool has_error() const;
+
+    /**
+     * @brief Очищает буфер и сбрасывает ошибку
+     */
+    void reset();
+
+    /**
+     * @brief Упаковывает сообщение в кадр
+     * @param mode Режим кадрирования
+     * @param payload Содержимое сообщения
+     * @return Готовый к отправке кадр
+     */
+    static QByteArray encode(framing mode, QByteArrayView payload);
+
+    /**
+     * @brief Дописывает кадр с сообщением в конец буфера
+     * @param mode Режим кадрирования
+     * @param payload Содержимое сообщения
+     * @param out Буфер, в который дописывается кадр
+     */
+    static void encode_into(framing mode, QByteArrayView payload, QByteArray& out);
+
+private:
+    QByteArray buffer;         ///< Приёмный буфер
+    qsizetype offset = 0;      ///< Начало необработанных данных в буфере
+    qsizetype scan = 0;        ///< Позиция, с которой продолжается поиск разделителя
+    framing current_mode;      ///< Текущий режим кадрирования
+    bool error = false;        ///< Признак испорченного потока
+};
+
+#endif // FRAME_PARSER_H
@@ -0,0 +1,147 @@
+#include "handshake.h"
+#include <QByteArrayList>
+
+/**
+ * @brief Возвращает набор возможностей, предлагаемый клиентом
+ * @param preferred Режим кадрирования, запрашиваемый у сервера
+ * @return Все возможности этой сборки с заданным кадрированием
+ */
+handshake handshake::offer(framing preferred) {
+    handshake result;
+    result.version = handshake::current_version;
+    result.mode = preferred;
+    result.batch = true;
+    result.request_ids = true;
+    result.binary = preferred == framing::LENGTH_PREFIXED;
+    result.zlib = preferred == framing::LENGTH_PREFIXED;
+    result.zstd = preferred == framing::LENGTH_PREFIXED and frame_compression::zstd_available();
+    result.cancel = true;
+    return result;
+}
+
+/**
+ * @brief Возвращает алгоритм сжатия согласованного набора
+ * @return ZSTD, ZLIB или NONE
+ */
+compression handshake::compression_method() const {
+    if (this->zstd)
+        return compression::ZSTD;
+    return this->zlib ? compression::ZLIB : compression::NONE;
+}
+
+/**
+ * @brief Возвращает сообщение "hello|<версия>|<возможности>"
+ * @return Сообщение без кадрирования и без завершающего '\n'
+ */
+QByteArray handshake::to_message() const {
+    QByteArrayList capabilities;
+    if (this->mode != framing::PLAIN)
+        capabilities.append(handshake::framing_name(this->mode));
+    if (this->batch)
+        capabilities.append("batch");
+    if (this->request_ids)
+        capabilities.append("ids");
+    if (this->binary)
+        capabilities.append("binary");
+    if (this->zstd)
+        capabilities.append("zstd");
+    if (this->zlib)
+        capabilities.append("zlib");
+    if (this->cancel)
+        capabilities.append("cancel");
+    return "hello|" + QByteArray::number(this->version) + "|" + capabilities.join(',');
+}
+
+/**
+ * @brief Разбирает сообщение "hello|<версия>|<возможности>"
+ * @param message Сообщение без завершающего '\n'
+ * @param out Разобранный набор
+ * @return false если это не сообщение hello
+ */
+bool handshake::parse(QByteArrayView message, handshake& out) {
+    if (!message.startsWith("hello|"))
+        return false;
+    QByteArrayView body = message.sliced(6);
+    qsizetype separator = body.indexOf('|');
+    bool is_number = false;
+    int version = body.first(separator < 0 ? body.size() : separator).toInt(&is_number);
+    if (!is_number or version < handshake::current_version)
+        return false;
+
+    handshake result;
+    result.version = version;
+    if (separator >= 0) {
+        for (const QByteArray& capability : body.sliced(separator + 1).toByteArray().split(',')) {
+            if (capability == "batch")
+                result.batch = true;
+            else if (capability == "ids")
+                result.request_ids = true;
+            else if (capability == "binary")
+                result.binary = true;
+            else if (capability == "zlib")
+                result.zlib = true;
+            else if (capability == "zstd")
+                result.zstd = true;
+            else if (capability == "cancel")
+                result.cancel = true;
+            else if (result.mode == framing::PLAIN)
+                result.mode = handshake::framing_from_name(capability);
+        }
+    }
+    out = result;
+    return true;
+}
+
+/**
+ * @brief Согласует набор возможностей с предложением другой стороны
+ * @param offered Предложение другой стороны
+ * @return Возможности, которые поддерживают обе стороны
+ *
+ * Версия - меньшая из двух; кадрирование принимается, только если
+ * обе стороны назвали один и тот же режим. Двоичный формат требует
+ * кадрирования длиной и идентификаторов запросов, сжатие - кадрирования
+ * длиной; из алгоритмов сжатия остаётся один, zstd предпочтительнее.
+ * Отмена запросов и пакеты требуют идентификаторов: ответ на пакет
+ * без идентификатора нельзя отличить от ответа на одиночный запрос.
+ */
+handshake handshake::agree(const handshake& offered) const {
+    handshake result;
+    result.version = qMin(this->version, offered.version);
+    if (this->mode == offered.mode)
+        result.mode = offered.mode;
+    result.request_ids = this->request_ids and offered.request_ids;
+    result.batch = this->batch and offered.batch and result.request_ids;
+    result.binary = this->binary and offered.binary and result.request_ids
+                    and result.mode == framing::LENGTH_PREFIXED;
+    bool packable = result.mode == framing::LENGTH_PREFIXED;
+    result.zstd = packable and this->zstd and offered.zstd;
+    result.zlib = packable and !result.zstd and this->zlib and offered.zlib;
+    result.cancel = this->cancel and offered.cancel and result.request_ids;
+    return result;
+}
+
+/**
+ * @brief Возвращает имя режима кадрирования для протокола
+ * @param mode Режим кадрирования
+ * @return Имя режима
+ */
+QByteArray handshake::framing_name(framing mode) {
+    switch (mode) {
+    case framing::LENGTH_PREFIXED: return "length";
+    case framing::DELIMITED: return "line";
+    default: return "plain";
+    }
+}
+
+/**
+ * @brief Возвращает режим кадрирования по его имени в протоколе
+ * @param name Имя режима
+ * @return Режим кадрирования (PLAIN для неизвестных имён)
+ */
+framing handshake::framing_from_name(QByteArrayView name) {
+    if (name == "length")
+        return framing::LENGTH_PREFIXED;
+    if (name == "line")
+        return framing::DELIMITED;
+    return framing::PLAIN;
+}
@@ -0,0 +1,104 @@
+#ifndef HANDSHAKE_H
+#define HANDSHAKE_H
+
+#include <QByteArray>
+#include <QByteArrayView>
+#include <QMetaType>
+#include "frame_compression.h"
+#include "frame_parser.h"
+
+/**
+ * @brief Возможности протокола, согласуемые при подключении
+ *
+ * Сразу после подключения клиент без кадрирования отправляет
+ * "hello|<версия>|<возможность>,<возможность>,...", перечисляя всё, что
+ * умеет. Сервер отвечает строкой "hello|<версия>|<возможности>\n" с теми
+ * возможностями из списка клиента, которые поддерживает он сам; с этого
+ * момента обе стороны используют согласованный набор. Старый сервер на
+ * hello не отвечает или отвечает чем-то другим - тогда соединение
+ * работает как раньше: без кадрирования и без пакетов.
+ *
+ * Возможности:
+ * - "length" или "line" - кадрирование (frame_parser), не больше одной;
+ * - "batch" - пакеты уравнений "equation_batch|" (требует "ids");
+ * - "ids" - идентификаторы запросов в последнем поле;
+ * - "binary" - двоичные запросы и ответы (binary_codec); согласуется
+ *   только вместе с "length", так как двоичное сообщение может
+ *   содержать '\n';
+ * - "zstd", "zlib" - сжатие больших сообщений (frame_compression); тоже
+ *   только вместе с "length". Если обе стороны умеют оба алгоритма,
+ *   выбирается zstd;
+ * - "cancel" - сообщение "cancel|<id>": клиент больше не ждёт ответа на
+ *   запрос, и сервер может не решать его (требует "ids").
+ *
+ * Новые возможности добавляются новыми словами, поэтому клиент и сервер
+ * разных версий договариваются о пересечении своих наборов.
+ */
+struct handshake
+{
+    static constexpr int legacy_version = 1;  ///< Версия протокола сервера без hello
+    static constexpr int current_version = 2; ///< Версия протокола этой сборки
+
+    int version = legacy_version;   ///< Версия протокола
+    framing mode = framing::PLAIN;  ///< Кадрирование
+    bool batch = false;             ///< Пакеты уравнений
+    bool request_ids = false;       ///< Идентификаторы запросов
+    bool binary = false;            ///< Двоичные запросы и ответы
+    bool zlib = false;              ///< Сжатие zlib
+    bool zstd = false;              ///< Сжатие zstd
+    bool cancel = false;            ///< Отмена запросов сообщением cancel|
+
+    /**
+     * @brief Возвращает набор возможностей, предлагаемый клиентом
+     * @param preferred Режим кадрирования, запрашиваемый у сервера
+     * @return Все возможности этой сборки с заданным кадрированием
+     *         (двоичный формат и сжатие - только при кадрировании длиной)
+     */
+    static handshake offer(framing preferred);
+
+    /**
+     * @brief Возвращает алгоритм сжатия согласованного набора
+     * @return ZSTD, ZLIB или NONE
+     */
+    compression compression_method() const;
+
+    /**
+     * @brief Возвращает сообщение "hello|<версия>|<возможности>"
+     * @return Сообщение без кадрирования и без завершающего '\n'
+     */
+    QByteArray to_message() const;
+
+    /**
+     * @brief Разбирает сообщение "hello|<версия>|<возможности>"
+     * @param message Сообщение без завершающего '\n'
+     * @param out Разобранный набор; неизвестные возможности пропускаются
+     * @return false если это не сообщение hello
+     */
+    static bool parse(QByteArrayView message, handshake& out);
+
+    /**
+     * @brief Согласует набор возможностей с предложением другой стороны
+     * @param offered Предложение другой стороны
+     * @return Возможности, которые поддерживают обе стороны
+     */
+    handshake agree(const handshake& offered) const;
+
+    /**
+     * @brief Возвращает имя режима кадрирования для протокола
+     * @param mode Режим кадрирования
+     * @return Имя режима ("plain", "length" или "line")
+     */
+    static QByteArray framing_name(framing mode);
+
+    /**
+     * @brief Возвращает режим кадрирования по его имени в протоколе
+     * @param name Имя режима
+     * @return Режим кадрирования (PLAIN для неизвестных имён)
+     */
+    static framing framing_from_name(QByteArrayView name);
+};
+
+// Передаётся между потоками сигналом network_worker::connected
+Q_DECLARE_METATYPE(handshake)
+
+#endif // HANDSHAKE_H
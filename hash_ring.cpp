@@ -0,0 +1,91 @@
+#include "hash_ring.h"
+#include <QByteArray>
+#include <QSet>
+#include <algorithm>
+
+/**
+ * @brief Конструктор пустого кольца
+ * @param replicas Точек на кольце у одного узла
+ */
+hash_ring::hash_ring(int replicas) : replicas(qMax(1, replicas)) {}
+
+/**
+ * @brief Добавляет узел
+ * @param node Номер узла
+ * @param name Имя узла, задающее положение точек
+ */
+void hash_ring::add(int node, const QString& name) {
+    QByteArray base = name.toUtf8() + '#';
+    for (int i = 0; i < this->replicas; i++)
+        this->points.push_back(point{hash_ring::hash(base + QByteArray::number(i)), node});
+    std::sort(this->points.begin(), this->points.end(), [](const point& left, const point& right) {
+        return left.position < right.position or (left.position == right.position and left.node < right.node);
+    });
+    this->nodes++;
+}
+
+/**
+ * @brief Удаляет все узлы
+ */
+void hash_ring::clear() {
+    this->points.clear();
+    this->nodes = 0;
+}
+
+/**
+ * @brief Проверяет, есть ли на кольце узлы
+ * @return true если узлов нет
+ */
+bool hash_ring::is_empty() const {
+    return this->points.empty();
+}
+
+/**
+ * @brief Находит узел для ключа
+ * @param key Хеш ключа
+ * @param usable Проверка, можно ли использовать узел сейчас
+ * @return Первый подходящий узел по часовой стрелке или -1
+ */
+int hash_ring::lookup(quint64 key, const std::function<bool(int)>& usable) const {
+    if (this->points.empty())
+        return -1;
+    auto start = std::lower_bound(this->points.begin(), this->points.end(), key, [](const point& item, quint64 value) {
+        return item.position < value;
+    });
+    std::size_t first = std::size_t(start - this->points.begin());
+
+    // Каждый узел проверяется один раз, даже если его точки идут подряд
+    QSet<int> rejected;
+    for (std::size_t step = 0; step < this->points.size() and rejected.size() < this->nodes; step++) {
+        int node = this->points[(first + step) % this->points.size()].node;
+        if (rejected.contains(node))
+            continue;
+        if (usable(node))
+            return node;
+        rejected.insert(node);
+    }
+    return -1;
+}
+
+/**
+ * @brief Вычисляет хеш, одинаковый во всех процессах и на всех платформах
+ * @param data Данные
+ * @return 64-битный хеш
+ *
+ * qHash зависит от случайного зерна процесса, поэтому для кольца не
+ * подходит. Короткие близкие строки FNV-1a раскладывает неравномерно,
+ * поэтому результат дополнительно перемешивается (финализатор splitmix64).
+ */
+quint64 hash_ring::hash(QByteArrayView data) {
+    quint64 value = 14695981039346656037ull;
+    for (char byte : data) {
+        value ^= quint8(byte);
+        value *= 1099511628211ull;
+    }
+    value ^= value >> 30;
+    value *= 0xbf58476d1ce4e5b9ull;
+    value ^= value >> 27;
+    value *= 0x94d049bb133111ebull;
+    value ^= value >> 31;
+    return value;
+}
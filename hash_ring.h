@@ -0,0 +1,79 @@
+#ifndef HASH_RING_H
+#define HASH_RING_H
+
+#include <QByteArrayView>
+#include <QString>
+#include <functional>
+#include <vector>
+
+/**
+ * @brief Кольцо согласованного хеширования
+ *
+ * Каждый узел занимает на кольце replicas точек, положение которых
+ * зависит только от имени узла. Ключ принадлежит первому узлу по часовой
+ * стрелке от своего хеша, поэтому при выходе узла из строя на другие
+ * узлы переходят только его ключи, а у разных клиентов с одним и тем же
+ * списком серверов ключи распределяются одинаково.
+ */
+class hash_ring
+{
+public:
+    static constexpr int default_replicas = 160; ///< Точек на кольце у одного узла
+
+    /**
+     * @brief Конструктор пустого кольца
+     * @param replicas Точек на кольце у одного узла
+     */
+    explicit hash_ring(int replicas = default_replicas);
+
+    /**
+     * @brief Добавляет узел
+     * @param node Номер узла
+     * @param name Имя узла (например, адрес сервера), задающее положение точек
+     */
+    void add(int node, const QString& name);
+
+    /**
+     * @brief Удаляет все узлы
+     */
+    void clear();
+
+    /**
+     * @brief Проверяет, есть ли на кольце узлы
+     * @return true если узлов нет
+     */
+    bool is_empty() const;
+
+    /**
+     * @brief Находит узел для ключа
+     * @param key Хеш ключа
+     * @param usable Проверка, можно ли использовать узел сейчас
+     * @return Первый подходящий узел по часовой стрелке или -1, если подходящих нет
+     *
+     * Неподходящие узлы пропускаются, и их ключи достаются следующим
+     * узлам на кольце.
+     */
+    int lookup(quint64 key, const std::function<bool(int)>& usable) const;
+
+    /**
+     * @brief Вычисляет хеш, одинаковый во всех процессах и на всех платформах
+     * @param data Данные
+     * @return 64-битный хеш (FNV-1a с перемешиванием)
+     */
+    static quint64 hash(QByteArrayView data);
+
+private:
+    /**
+     * @brief Точка узла на кольце
+     */
+    struct point {
+        quint64 position; ///< Положение на кольце
+        int node;         ///< Номер узла
+    };
+
+    std::vector<point> points; ///< Точки всех узлов по возрастанию положения
+    int replicas;              ///< Точек на кольце у одного узла
+    int nodes = 0;             ///< Количество узлов
+};
+
+#endif // HASH_RING_H
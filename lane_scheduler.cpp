@@ -0,0 +1,43 @@
+#include "lane_scheduler.h"
+#include <QtGlobal>
+
+/**
+ * @brief Конструктор
+ * @param interactive_weight Вес интерактивной полосы
+ * @param bulk_weight Вес пакетной полосы
+ */
+lane_scheduler::lane_scheduler(int interactive_weight, int bulk_weight) :
+    weights{qMax(1, interactive_weight), qMax(1, bulk_weight)},
+    credit{0, 0}
+{}
+
+/**
+ * @brief Возвращает номер полосы для индексации массивов
+ * @param priority Класс сообщения
+ * @return 0 для INTERACTIVE, 1 для BULK
+ */
+int lane_scheduler::lane(send_priority priority) {
+    return priority == send_priority::INTERACTIVE ? 0 : 1;
+}
+
+/**
+ * @brief Выбирает полосу для следующего сообщения
+ * @param interactive_ready В интерактивной полосе есть сообщение, которое можно отправить
+ * @param bulk_ready В пакетной полосе есть сообщение, которое можно отправить
+ * @return Полоса; если готова только одна, то она
+ *
+ * Каждая готовая полоса получает свой вес, выбирается полоса с большим
+ * накопленным значением, и у неё вычитается сумма весов. Накопленное
+ * значение меняется только пока готовы обе полосы, поэтому простой
+ * одной из них не даёт ей потом обогнать другую на целую пачку.
+ */
+send_priority lane_scheduler::next(bool interactive_ready, bool bulk_ready) {
+    if (!interactive_ready or !bulk_ready)
+        return interactive_ready ? send_priority::INTERACTIVE : send_priority::BULK;
+
+    this->credit[0] += this->weights[0];
+    this->credit[1] += this->weights[1];
+    int chosen = this->credit[0] >= this->credit[1] ? 0 : 1;
+    this->credit[chosen] -= this->weights[0] + this->weights[1];
+    return chosen == 0 ? send_priority::INTERACTIVE : send_priority::BULK;
+}
@@ -0,0 +1,55 @@
+#ifndef LANE_SCHEDULER_H
+#define LANE_SCHEDULER_H
+
+/**
+ * @brief Класс исходящего сообщения
+ */
+enum class send_priority {
+    INTERACTIVE, ///< Запрос пользователя, который ждёт ответа в окне
+    BULK,        ///< Пакеты и сценарии: важна пропускная способность, а не задержка
+};
+
+/**
+ * @brief Взвешенный выбор полосы очереди отправки
+ *
+ * Сообщения разных классов ждут в отдельных полосах. Когда сообщения
+ * есть в обеих, полосы обслуживаются по очереди пропорционально весам
+ * (плавный взвешенный круговой выбор): при весах 8 и 1 на каждые девять
+ * сообщений приходится восемь интерактивных и одно пакетное. Поэтому
+ * интерактивный запрос не ждёт за тысячами пакетных, а пакетная полоса
+ * не голодает даже при потоке интерактивных.
+ */
+class lane_scheduler
+{
+public:
+    static constexpr int lane_count = 2;                 ///< Количество полос (по send_priority)
+    static constexpr int default_interactive_weight = 8; ///< Вес интерактивной полосы по умолчанию
+
+    /**
+     * @brief Конструктор
+     * @param interactive_weight Вес интерактивной полосы
+     * @param bulk_weight Вес пакетной полосы
+     */
+    explicit lane_scheduler(int interactive_weight = default_interactive_weight, int bulk_weight = 1);
+
+    /**
+     * @brief Выбирает полосу для следующего сообщения
+     * @param interactive_ready В интерактивной полосе есть сообщение, которое можно отправить
+     * @param bulk_ready В пакетной полосе есть сообщение, которое можно отправить
+     * @return Полоса; если готова только одна, то она
+     */
+    send_priority next(bool interactive_ready, bool bulk_ready);
+
+    /**
+     * @brief Возвращает номер полосы для индексации массивов
+     * @param priority Класс сообщения
+     * @return 0 для INTERACTIVE, 1 для BULK
+     */
+    static int lane(send_priority priority);
+
+private:
+    int weights[lane_count]; ///< Веса полос
+    int credit[lane_count];  ///< Накопленный приоритет полос
+};
+
+#endif // LANE_SCHEDULER_H
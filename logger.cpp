@@ -0,0 +1,330 @@
+#include "logger.h"
+#include <QByteArray>
+#include <QDateTime>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+
+/**
+ * @brief Ячейка кольцевого буфера журнала
+ *
+ * Порядковый номер ячейки с позицией p: p - ячейка свободна для записи
+ * с позиции p, p + 1 - запись опубликована и ждёт вывода.
+ */
+struct log_record {
+    std::atomic<quint64> sequence;     ///< Порядковый номер ячейки
+    qint64 time_ms;                    ///< Время грубых часов
+    log_level level;                   ///< Уровень
+    const char* component;             ///< Компонент
+    int length;                        ///< Длина текста, байт
+    char text[logger::text_capacity];  ///< Текст в UTF-8
+};
+
+/**
+ * @brief Кэш форматированной секунды времени записи
+ */
+struct log_timestamp {
+    qint64 second = -1; ///< Секунда от начала эпохи, для которой сформирован текст
+    QByteArray text;    ///< "yyyy-MM-ddTHH:mm:ss" местного времени
+};
+
+/**
+ * @brief Состояние журнала
+ *
+ * Создаётся при первой записи и не удаляется: записи деструкторов
+ * статических объектов после остановки фонового потока выводятся сразу.
+ */
+struct log_state {
+    log_record cells[logger::capacity];             ///< Кольцевой буфер
+    alignas(64) std::atomic<quint64> enqueue_position{0}; ///< Следующая позиция записи
+    alignas(64) std::atomic<quint64> drained_position{0}; ///< Следующая позиция вывода (только фоновый поток пишет)
+    std::atomic<qint64> clock_ms{0};                ///< Грубые часы
+    std::atomic<int> level{int(log_level::INFO)};   ///< Наименьший записываемый уровень
+    std::atomic<qint64> dropped{0};                 ///< Отброшено записей
+    std::atomic<bool> stopping{false};              ///< Фоновому потоку пора завершиться
+    std::atomic<bool> stopped{false};               ///< Фоновый поток завершён
+    qint64 reported_dropped = 0;                    ///< Отброшено записей на момент последнего сообщения об этом
+    log_timestamp timestamp;                        ///< Кэш времени фонового потока
+    QByteArray lines;                               ///< Строки одного такта вывода
+    std::FILE* output = stderr;                     ///< Файл вывода
+    std::thread drainer;                            ///< Фоновый поток
+};
+
+static log_state* state();
+
+/**
+ * @brief Возвращает название уровня
+ * @param level Уровень
+ * @return Название в нижнем регистре
+ */
+static const char* level_name(log_level level) {
+    switch (level) {
+    case log_level::DEBUG:
+        return "debug";
+    case log_level::INFO:
+        return "info";
+    case log_level::WARNING:
+        return "warning";
+    case log_level::CRITICAL:
+        return "critical";
+    }
+    return "info";
+}
+
+/**
+ * @brief Разбирает название уровня
+ * @param name Название (debug, info, warning или critical)
+ * @param out Уровень
+ * @return false если название неизвестно
+ */
+static bool parse_level(const QByteArray& name, log_level& out) {
+    for (log_level level : {log_level::DEBUG, log_level::INFO, log_level::WARNING, log_level::CRITICAL}) {
+        if (name.compare(level_name(level), Qt::CaseInsensitive) == 0) {
+            out = level;
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Дописывает строку записи в формате logfmt
+ * @param line Буфер вывода
+ * @param timestamp Кэш форматированной секунды
+ * @param time_ms Время записи
+ * @param level Уровень
+ * @param component Компонент
+ * @param text Текст в UTF-8
+ *
+ * Дата форматируется через QDateTime только при смене секунды.
+ */
+static void format_record(QByteArray& line, log_timestamp& timestamp, qint64 time_ms, log_level level,
+                          const char* component, QByteArrayView text) {
+    qint64 second = time_ms / 1000;
+    if (second != timestamp.second) {
+        timestamp.second = second;
+        timestamp.text = QDateTime::fromMSecsSinceEpoch(second * 1000).toString("yyyy-MM-dd'T'HH:mm:ss").toLatin1();
+    }
+    char millis[8];
+    std::snprintf(millis, sizeof(millis), ".%03d", int(time_ms % 1000));
+
+    line.append("time=").append(timestamp.text).append(millis);
+    line.append(" level=").append(level_name(level));
+    line.append(" component=").append(component);
+    line.append(" message=\"");
+    for (char symbol : text) {
+        if (symbol == '"' or symbol == '\\')
+            line.append('\\').append(symbol);
+        else if (symbol == '\n')
+            line.append("\\n");
+        else
+            line.append(symbol);
+    }
+    line.append("\"\n");
+}
+
+/**
+ * @brief Выводит опубликованные записи
+ * @param log Состояние журнала
+ *
+ * Вызывается только фоновым потоком (или при остановке после него).
+ */
+static void drain(log_state* log) {
+    quint64 position = log->drained_position.load(std::memory_order_relaxed);
+    for (;;) {
+        log_record& cell = log->cells[position % logger::capacity];
+        if (cell.sequence.load(std::memory_order_acquire) != position + 1)
+            break;
+        format_record(log->lines, log->timestamp, cell.time_ms, cell.level, cell.component,
+                      QByteArrayView(cell.text, cell.length));
+        cell.sequence.store(position + logger::capacity, std::memory_order_release);
+        position++;
+    }
+
+    qint64 dropped = log->dropped.load(std::memory_order_relaxed);
+    if (dropped != log->reported_dropped) {
+        QByteArray text = "Буфер журнала заполнен, отброшено записей: "
+                          + QByteArray::number(dropped - log->reported_dropped);
+        format_record(log->lines, log->timestamp, log->clock_ms.load(std::memory_order_relaxed), log_level::WARNING,
+                      "log", text);
+        log->reported_dropped = dropped;
+    }
+
+    if (!log->lines.isEmpty()) {
+        std::fwrite(log->lines.constData(), 1, std::size_t(log->lines.size()), log->output);
+        std::fflush(log->output);
+        log->lines.clear();
+    }
+    log->drained_position.store(position, std::memory_order_release);
+}
+
+/**
+ * @brief Цикл фонового потока: раз в такт обновляет часы и выводит записи
+ * @param log Состояние журнала
+ */
+static void drain_loop(log_state* log) {
+    while (!log->stopping.load(std::memory_order_acquire)) {
+        log->clock_ms.store(QDateTime::currentMSecsSinceEpoch(), std::memory_order_relaxed);
+        drain(log);
+        std::this_thread::sleep_for(std::chrono::milliseconds(logger::tick_ms));
+    }
+    drain(log);
+}
+
+/**
+ * @brief Останавливает фоновый поток при завершении программы
+ *
+ * Регистрируется через atexit, поэтому вызывается до деструкторов
+ * статических объектов, созданных раньше первой записи.
+ */
+static void stop() {
+    log_state* log = state();
+    log->stopping.store(true, std::memory_order_release);
+    if (log->drainer.joinable())
+        log->drainer.join();
+    log->stopped.store(true, std::memory_order_release);
+}
+
+/**
+ * @brief Создаёт состояние журнала и запускает фоновый поток
+ * @return Состояние журнала
+ */
+static log_state* start() {
+    log_state* log = new log_state;
+    for (int i = 0; i < logger::capacity; i++)
+        log->cells[i].sequence.store(quint64(i), std::memory_order_relaxed);
+    log->clock_ms.store(QDateTime::currentMSecsSinceEpoch(), std::memory_order_relaxed);
+
+    log_level level = LOG_COMPILED_LEVEL > log_level::INFO ? LOG_COMPILED_LEVEL : log_level::INFO;
+    parse_level(qgetenv(LOG_LEVEL_ENVIRONMENT), level);
+    log->level.store(int(level), std::memory_order_relaxed);
+
+    QByteArray path = qgetenv(LOG_FILE_ENVIRONMENT);
+    if (!path.isEmpty()) {
+        std::FILE* file = std::fopen(path.constData(), "a");
+        if (file != nullptr)
+            log->output = file;
+    }
+
+    log->drainer = std::thread(drain_loop, log);
+    std::atexit(stop);
+    return log;
+}
+
+/**
+ * @brief Возвращает состояние журнала, создавая его при первом вызове
+ * @return Состояние журнала
+ */
+static log_state* state() {
+    static log_state* instance = start();
+    return instance;
+}
+
+/**
+ * @brief Проверяет, записываются ли записи уровня
+ * @param level Уровень
+ * @return true если уровень не ниже заданного SOLVER_LOG_LEVEL или set_level
+ */
+bool logger::enabled(log_level level) {
+    return level >= logger::compiled_level and int(level) >= state()->level.load(std::memory_order_relaxed);
+}
+
+/**
+ * @brief Задаёт наименьший записываемый уровень
+ * @param level Уровень
+ */
+void logger::set_level(log_level level) {
+    state()->level.store(int(level), std::memory_order_relaxed);
+}
+
+/**
+ * @brief Добавляет запись в журнал
+ * @param level Уровень
+ * @param component Компонент (строковый литерал, хранится указатель)
+ * @param text Текст в UTF-8
+ *
+ * Ячейка занимается сравнением с обменом позиции записи; если ячейка
+ * ещё не выведена (буфер заполнен), запись отбрасывается. Текст длиннее
+ * text_capacity обрезается по границе символа UTF-8.
+ */
+void logger::write(log_level level, const char* component, QByteArrayView text) {
+    log_state* log = state();
+    qint64 length = qMin<qint64>(text.size(), logger::text_capacity);
+    if (length < text.size())
+        while (length > 0 and (uchar(text[length]) & 0xC0) == 0x80)
+            length--;
+
+    if (log->stopped.load(std::memory_order_acquire)) {
+        QByteArray line;
+        log_timestamp timestamp;
+        format_record(line, timestamp, QDateTime::currentMSecsSinceEpoch(), level, component, text.first(length));
+        std::fwrite(line.constData(), 1, std::size_t(line.size()), log->output);
+        std::fflush(log->output);
+        return;
+    }
+
+    quint64 position = log->enqueue_position.load(std::memory_order_relaxed);
+    log_record* cell = nullptr;
+    for (;;) {
+        cell = &log->cells[position % logger::capacity];
+        qint64 lag = qint64(cell->sequence.load(std::memory_order_acquire) - position);
+        if (lag == 0) {
+            if (log->enqueue_position.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+                break;
+        }
+        else if (lag < 0) {
+            log->dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        else {
+            position = log->enqueue_position.load(std::memory_order_relaxed);
+        }
+    }
+
+    cell->time_ms = log->clock_ms.load(std::memory_order_relaxed);
+    cell->level = level;
+    cell->component = component;
+    cell->length = int(length);
+    std::memcpy(cell->text, text.data(), std::size_t(length));
+    cell->sequence.store(position + 1, std::memory_order_release);
+}
+
+/**
+ * @brief Добавляет запись в журнал
+ * @param level Уровень
+ * @param component Компонент (строковый литерал, хранится указатель)
+ * @param text Текст
+ */
+void logger::write(log_level level, const char* component, QStringView text) {
+    logger::write(level, component, QByteArrayView(text.toUtf8()));
+}
+
+/**
+ * @brief Возвращает время грубых часов
+ * @return Миллисекунды от начала эпохи Unix с точностью до tick_ms
+ */
+qint64 logger::now_ms() {
+    return state()->clock_ms.load(std::memory_order_relaxed);
+}
+
+/**
+ * @brief Ждёт вывода всех записей, добавленных до вызова
+ */
+void logger::flush() {
+    log_state* log = state();
+    quint64 target = log->enqueue_position.load(std::memory_order_acquire);
+    while (!log->stopped.load(std::memory_order_acquire)
+           and log->drained_position.load(std::memory_order_acquire) < target)
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+}
+
+/**
+ * @brief Возвращает количество записей, отброшенных из-за заполненного буфера
+ * @return Количество записей
+ */
+qint64 logger::dropped() {
+    return state()->dropped.load(std::memory_order_relaxed);
+}
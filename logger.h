@@ -0,0 +1,132 @@
+#ifndef LOGGER_H
+#define LOGGER_H
+
+#include <QByteArrayView>
+#include <QStringView>
+#include <QtGlobal>
+
+/// Переменная окружения с уровнем журнала: debug, info, warning или critical
+#define LOG_LEVEL_ENVIRONMENT "SOLVER_LOG_LEVEL"
+/// Переменная окружения с путём файла журнала (без неё журнал пишется в stderr)
+#define LOG_FILE_ENVIRONMENT "SOLVER_LOG_FILE"
+
+/**
+ * @brief Уровень важности записи журнала
+ */
+enum class log_level {
+    DEBUG,    ///< Отладка: каждое сообщение, внутреннее состояние
+    INFO,     ///< Обычные события: подключение, согласование, вход
+    WARNING,  ///< Отклонения, с которыми клиент справляется сам
+    CRITICAL, ///< Ошибки, после которых операция не выполнена
+};
+
+/// Наименьший уровень, записи которого вообще компилируются (в сборке release - INFO)
+#ifndef LOG_COMPILED_LEVEL
+#ifdef QT_NO_DEBUG
+#define LOG_COMPILED_LEVEL log_level::INFO
+#else
+#define LOG_COMPILED_LEVEL log_level::DEBUG
+#endif
+#endif
+
+/**
+ * @brief Журнал с уровнями важности
+ *
+ * Запись - время, уровень, компонент (строковый литерал) и текст в
+ * UTF-8. Записывающий поток только копирует её в ячейку кольцевого
+ * буфера без блокировок (очередь Вьюкова с порядковым номером в каждой
+ * ячейке) и не ждёт вывода; форматирует и выводит записи фоновый поток,
+ * он же раз в такт обновляет грубые часы, из которых берётся время
+ * записи. Если буфер заполнен, запись отбрасывается, а количество
+ * отброшенных записей выводится позже отдельной строкой.
+ *
+ * Записи выводятся в формате logfmt:
+ * time=2024-05-01T12:00:00.125 level=info component=client message="..."
+ *
+ * Записи уровней ниже LOG_COMPILED_LEVEL убираются при компиляции
+ * вместе с вычислением текста (макросы LOG_DEBUG и другие), остальные
+ * проверяются по уровню из SOLVER_LOG_LEVEL до форматирования текста.
+ */
+class logger
+{
+private:
+    logger() = delete;              ///< Запрет создания экземпляров
+    logger(const logger&) = delete; ///< Запрет копирования
+    ~logger() = delete;             ///< Запрет удаления
+
+public:
+    static constexpr int capacity = 4096;                  ///< Количество ячеек кольцевого буфера
+    static constexpr int text_capacity = 232;              ///< Наибольшая длина текста записи, байт (длиннее - обрезается)
+    static constexpr int tick_ms = 10;                     ///< Такт фонового потока и точность грубых часов, мс
+    static constexpr log_level compiled_level = LOG_COMPILED_LEVEL; ///< Наименьший компилируемый уровень
+
+    /**
+     * @brief Проверяет, записываются ли записи уровня
+     * @param level Уровень
+     * @return true если уровень не ниже заданного SOLVER_LOG_LEVEL или set_level
+     */
+    static bool enabled(log_level level);
+
+    /**
+     * @brief Задаёт наименьший записываемый уровень
+     * @param level Уровень
+     */
+    static void set_level(log_level level);
+
+    /**
+     * @brief Добавляет запись в журнал
+     * @param level Уровень
+     * @param component Компонент (строковый литерал, хранится указатель)
+     * @param text Текст в UTF-8
+     */
+    static void write(log_level level, const char* component, QByteArrayView text);
+
+    /**
+     * @brief Добавляет запись в журнал
+     * @param level Уровень
+     * @param component Компонент (строковый литерал, хранится указатель)
+     * @param text Текст
+     */
+    static void write(log_level level, const char* component, QStringView text);
+
+    /**
+     * @brief Возвращает время грубых часов
+     * @return Миллисекунды от начала эпохи Unix с точностью до tick_ms
+     */
+    static qint64 now_ms();
+
+    /**
+     * @brief Ждёт вывода всех записей, добавленных до вызова
+     */
+    static void flush();
+
+    /**
+     * @brief Возвращает количество записей, отброшенных из-за заполненного буфера
+     * @return Количество записей
+     */
+    static qint64 dropped();
+};
+
+/**
+ * @brief Добавляет запись, если её уровень компилируется и включён
+ *
+ * Текст вычисляется только для записываемых уровней.
+ */
+#define LOG_WRITE(level, component, text)                                  \
+    do {                                                                   \
+        if constexpr (level >= logger::compiled_level) {                   \
+            if (logger::enabled(level))                                    \
+                logger::write(level, component, text);                     \
+        }                                                                  \
+    } while (false)
+
+/// Отладочная запись (в сборке release не компилируется)
+#define LOG_DEBUG(component, text) LOG_WRITE(log_level::DEBUG, component, text)
+/// Запись об обычном событии
+#define LOG_INFO(component, text) LOG_WRITE(log_level::INFO, component, text)
+/// Запись об отклонении
+#define LOG_WARNING(component, text) LOG_WRITE(log_level::WARNING, component, text)
+/// Запись об ошибке
+#define LOG_CRITICAL(component, text) LOG_WRITE(log_level::CRITICAL, component, text)
+
+#endif // LOGGER_H
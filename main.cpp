@@ -2,6 +2,9 @@
 #include <QApplication>
 #include <client.h>
 #include "notification.h"
+#include "clients_func.h"
+#include "result_store.h"
+#include "logger.h"
 #include "QValidator"
 
 // Определяем алиас для класса Widget, чтобы избежать конфликта имен
@@ -15,20 +18,43 @@
  * @param argv Массив аргументов командной строки
  * @return Код возврата приложения
  *
+ * С аргументом --compact-cache только уплотняет хранилище ответов и завершается.
+ *
  * Основные действия:
  * 1. Создает QApplication - ядро Qt-приложения
  * 2. Инициализирует единственный экземпляр клиента (Singleton)
- * 3. Создает и отображает окно регистрации
- * 4. Запускает главный цикл обработки событий
+ * 3. Подключает показ ошибки соединения
+ * 4. Создает и отображает окно регистрации
+ * 5. Запускает главный цикл обработки событий
  */
 int main(int argc, char *argv[])
 {
     // Инициализация Qt-приложения
     QApplication a(argc, argv);
 
+    // Команда уплотнения постоянного хранилища ответов
+    if (a.arguments().contains("--compact-cache")) {
+        result_store store(result_store::default_path);
+        bool compacted = store.open() and store.compact();
+        if (compacted)
+            LOG_INFO("store", "Уплотнение хранилища ответов выполнено");
+        else
+            LOG_CRITICAL("store", "Ошибка уплотнения хранилища ответов");
+        return compacted ? 0 : 1;
+    }
+
     // Создание клиентского соединения (Singleton)
     Client* make_client = Client::get_instance();
 
+    // Модальное окно показывается в отдельной итерации цикла событий, а не внутри Client::write.
+    // Клиент переподключается сам; окно означает, что очередь на время разрыва заполнена
+    QObject::connect(make_client, &Client::server_unavailable, &a, []() {
+        clients_func::create_messagebox("Ошибка", "Нет подключения к серверу, запрос не отправлен. Повторите попытку позже");
+    }, Qt::QueuedConnection);
+    QObject::connect(make_client, &Client::server_timeout, &a, []() {
+        clients_func::create_messagebox("Ошибка", "Сервер не ответил вовремя. Повторите попытку позже");
+    }, Qt::QueuedConnection);
+
     // Создание и отображение окна регистрации
     window* window_reg = new window(make_client);
 
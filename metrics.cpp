@@ -0,0 +1,269 @@
+#include "metrics.h"
+#include <QSaveFile>
+#include <cmath>
+
+/**
+ * @brief Увеличивает счётчик
+ * @param amount Приращение
+ */
+void metric_counter::add(qint64 amount) {
+    this->total += amount;
+}
+
+/**
+ * @brief Переносит в счётчик итог, который считается в другом месте
+ * @param total Итог (меньший текущего значения не учитывается)
+ */
+void metric_counter::advance_to(qint64 total) {
+    this->total = qMax(this->total, total);
+}
+
+/**
+ * @brief Возвращает значение счётчика
+ * @return Значение
+ */
+qint64 metric_counter::value() const {
+    return this->total;
+}
+
+/**
+ * @brief Задаёт значение
+ * @param value Значение
+ */
+void metric_gauge::set(double value) {
+    this->current = value;
+}
+
+/**
+ * @brief Возвращает значение
+ * @return Значение
+ */
+double metric_gauge::value() const {
+    return this->current;
+}
+
+/**
+ * @brief Возвращает ячейку значения
+ * @param ns Значение, нс
+ * @return Номер ячейки
+ *
+ * Значения меньше sub_bucket_count занимают по ячейке; для остальных
+ * номер складывается из номера старшего бита и следующих за ним
+ * sub_bucket_bits бит.
+ */
+int latency_histogram::bucket_of(qint64 ns) {
+    quint64 value = quint64(qMax<qint64>(0, ns));
+    if (value < quint64(latency_histogram::sub_bucket_count))
+        return int(value);
+    int exponent = 63 - qCountLeadingZeroBits(value);
+    int shift = exponent - latency_histogram::sub_bucket_bits;
+    int sub_bucket = int(value >> shift) & (latency_histogram::sub_bucket_count - 1);
+    return latency_histogram::sub_bucket_count * (shift + 1) + sub_bucket;
+}
+
+/**
+ * @brief Возвращает наибольшее значение ячейки
+ * @param bucket Номер ячейки
+ * @return Значение, нс
+ */
+qint64 latency_histogram::upper_bound(int bucket) {
+    if (bucket < latency_histogram::sub_bucket_count)
+        return bucket;
+    int shift = bucket / latency_histogram::sub_bucket_count - 1;
+    quint64 lowest = quint64(latency_histogram::sub_bucket_count + bucket % latency_histogram::sub_bucket_count)
+                     << shift;
+    return qint64(lowest + (quint64(1) << shift) - 1);
+}
+
+/**
+ * @brief Добавляет значение
+ * @param ns Задержка, нс (отрицательная считается нулевой)
+ */
+void latency_histogram::record(qint64 ns) {
+    this->buckets[std::size_t(latency_histogram::bucket_of(ns))]++;
+    this->total++;
+    this->total_ns += qMax<qint64>(0, ns);
+}
+
+/**
+ * @brief Возвращает количество значений
+ * @return Количество
+ */
+qint64 latency_histogram::count() const {
+    return this->total;
+}
+
+/**
+ * @brief Возвращает сумму значений
+ * @return Сумма, нс
+ */
+qint64 latency_histogram::sum() const {
+    return this->total_ns;
+}
+
+/**
+ * @brief Возвращает перцентиль
+ * @param fraction Доля от 0 до 1 (0.99 - 99-й перцентиль)
+ * @return Верхняя граница ячейки перцентиля, нс (0 - значений нет)
+ */
+qint64 latency_histogram::percentile(double fraction) const {
+    if (this->total == 0)
+        return 0;
+    qint64 rank = qMax<qint64>(1, qint64(std::ceil(qBound(0.0, fraction, 1.0) * this->total)));
+    qint64 seen = 0;
+    for (int bucket = 0; bucket < latency_histogram::bucket_count; bucket++) {
+        seen += this->buckets[std::size_t(bucket)];
+        if (seen >= rank)
+            return latency_histogram::upper_bound(bucket);
+    }
+    return latency_histogram::upper_bound(latency_histogram::bucket_count - 1);
+}
+
+/**
+ * @brief Возвращает количество значений не больше границы
+ * @param bound_ns Граница, нс
+ * @return Количество значений в ячейках, целиком лежащих не выше границы
+ */
+qint64 latency_histogram::count_at_most(qint64 bound_ns) const {
+    qint64 result = 0;
+    for (int bucket = 0; bucket < latency_histogram::bucket_count; bucket++) {
+        if (latency_histogram::upper_bound(bucket) > bound_ns)
+            break;
+        result += this->buckets[std::size_t(bucket)];
+    }
+    return result;
+}
+
+/**
+ * @brief Добавляет ряд
+ * @param kind Вид
+ * @param name Имя метрики
+ * @param help Описание
+ * @param labels Метки
+ * @return Ряд
+ */
+metrics_registry::series& metrics_registry::add(metric_kind kind, const QByteArray& name, const QByteArray& help,
+                                                const QByteArray& labels) {
+    std::unique_ptr<series> entry(new series{kind, name, help, labels, {}, {}, nullptr, {}});
+    this->entries.push_back(std::move(entry));
+    return *this->entries.back();
+}
+
+/**
+ * @brief Создаёт счётчик
+ * @param name Имя метрики
+ * @param help Описание
+ * @param labels Метки ряда
+ * @return Счётчик
+ */
+metric_counter* metrics_registry::counter(const QByteArray& name, const QByteArray& help, const QByteArray& labels) {
+    return &this->add(metric_kind::COUNTER, name, help, labels).counter;
+}
+
+/**
+ * @brief Создаёт величину
+ * @param name Имя метрики
+ * @param help Описание
+ * @param labels Метки ряда
+ * @return Величина
+ */
+metric_gauge* metrics_registry::gauge(const QByteArray& name, const QByteArray& help, const QByteArray& labels) {
+    return &this->add(metric_kind::GAUGE, name, help, labels).gauge;
+}
+
+/**
+ * @brief Создаёт гистограмму задержек
+ * @param name Имя метрики (выводится в секундах)
+ * @param help Описание
+ * @param bounds Границы ячеек вывода le, с (по возрастанию)
+ * @param labels Метки ряда
+ * @return Гистограмма
+ */
+latency_histogram* metrics_registry::histogram(const QByteArray& name, const QByteArray& help,
+                                               const QList<double>& bounds, const QByteArray& labels) {
+    series& entry = this->add(metric_kind::HISTOGRAM, name, help, labels);
+    entry.histogram.reset(new latency_histogram);
+    entry.bounds = bounds;
+    return entry.histogram.get();
+}
+
+/**
+ * @brief Формирует имя ряда с метками
+ * @param name Имя
+ * @param labels Метки ряда
+ * @param extra Дополнительная метка (например, le="0.5")
+ * @return "name{labels,extra}" или "name", если меток нет
+ */
+static QByteArray series_name(const QByteArray& name, const QByteArray& labels, const QByteArray& extra = QByteArray()) {
+    QByteArray all = labels;
+    if (!extra.isEmpty())
+        all += (all.isEmpty() ? "" : ",") + extra;
+    return all.isEmpty() ? name : name + '{' + all + '}';
+}
+
+/**
+ * @brief Формирует текст всех метрик
+ * @return Текстовый формат Prometheus 0.0.4
+ *
+ * Гистограмма выводится накопительными ячейками le по границам,
+ * заданным при создании; ячейка le получает значения из ячеек
+ * гистограммы, целиком лежащих не выше границы.
+ */
+QByteArray metrics_registry::to_prometheus() const {
+    static const char* const kind_names[] = {"counter", "gauge", "histogram"};
+    QByteArray out;
+    QList<QByteArray> written;
+    for (const std::unique_ptr<series>& first : this->entries) {
+        if (written.contains(first->name))
+            continue;
+        written.append(first->name);
+        out += "# HELP " + first->name + ' ' + first->help + '\n';
+        out += "# TYPE " + first->name + ' ' + kind_names[int(first->kind)] + '\n';
+
+        for (const std::unique_ptr<series>& entry : this->entries) {
+            if (entry->name != first->name)
+                continue;
+            if (entry->kind == metric_kind::COUNTER) {
+                out += series_name(entry->name, entry->labels) + ' ' + QByteArray::number(entry->counter.value()) + '\n';
+                continue;
+            }
+            if (entry->kind == metric_kind::GAUGE) {
+                out += series_name(entry->name, entry->labels) + ' ' + QByteArray::number(entry->gauge.value(), 'g', 15)
+                       + '\n';
+                continue;
+            }
+            const latency_histogram& histogram = *entry->histogram;
+            for (double bound : std::as_const(entry->bounds)) {
+                QByteArray le = "le=\"" + QByteArray::number(bound, 'g', 6) + '"';
+                out += series_name(entry->name + "_bucket", entry->labels, le) + ' '
+                       + QByteArray::number(histogram.count_at_most(qint64(bound * 1e9))) + '\n';
+            }
+            out += series_name(entry->name + "_bucket", entry->labels, "le=\"+Inf\"") + ' '
+                   + QByteArray::number(histogram.count()) + '\n';
+            out += series_name(entry->name + "_sum", entry->labels) + ' '
+                   + QByteArray::number(histogram.sum() / 1e9, 'g', 15) + '\n';
+            out += series_name(entry->name + "_count", entry->labels) + ' ' + QByteArray::number(histogram.count())
+                   + '\n';
+        }
+    }
+    return out;
+}
+
+/**
+ * @brief Записывает метрики в файл
+ * @param path Путь файла (для textfile collector node exporter - *.prom)
+ * @return false если файл не удалось записать
+ *
+ * Файл заменяется целиком, поэтому читатель не видит его наполовину записанным.
+ */
+bool metrics_registry::write_text_file(const QString& path) const {
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly))
+        return false;
+    QByteArray text = this->to_prometheus();
+    if (file.write(text) != text.size()) {
+        file.cancelWriting();
+        return false;
+    }
+    return file.commit();
+}
@@ -0,0 +1,225 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <QByteArray>
+#include <QList>
+#include <QString>
+#include <QtGlobal>
+#include <array>
+#include <memory>
+#include <vector>
+
+/// Переменная окружения с путём файла метрик в текстовом формате Prometheus
+#define METRICS_FILE_ENVIRONMENT "SOLVER_METRICS_FILE"
+
+/**
+ * @brief Счётчик, который только растёт
+ */
+class metric_counter
+{
+public:
+    /**
+     * @brief Увеличивает счётчик
+     * @param amount Приращение
+     */
+    void add(qint64 amount = 1);
+
+    /**
+     * @brief Переносит в счётчик итог, который считается в другом месте
+     * @param total Итог (меньший текущего значения не учитывается)
+     */
+    void advance_to(qint64 total);
+
+    /**
+     * @brief Возвращает значение счётчика
+     * @return Значение
+     */
+    qint64 value() const;
+
+private:
+    qint64 total = 0; ///< Значение
+};
+
+/**
+ * @brief Текущее значение величины
+ */
+class metric_gauge
+{
+public:
+    /**
+     * @brief Задаёт значение
+     * @param value Значение
+     */
+    void set(double value);
+
+    /**
+     * @brief Возвращает значение
+     * @return Значение
+     */
+    double value() const;
+
+private:
+    double current = 0; ///< Значение
+};
+
+/**
+ * @brief Гистограмма задержек с логарифмическими ячейками (как HDR Histogram)
+ *
+ * Каждая степень двойки делится на sub_bucket_count равных ячеек,
+ * поэтому относительная погрешность значения не больше
+ * 1 / sub_bucket_count при любом порядке величины, а запись - несколько
+ * битовых операций без поиска. Значения хранятся в наносекундах.
+ */
+class latency_histogram
+{
+public:
+    static constexpr int sub_bucket_bits = 3;                    ///< Двоичный логарифм количества ячеек на степень двойки
+    static constexpr int sub_bucket_count = 1 << sub_bucket_bits; ///< Ячеек на степень двойки
+    static constexpr int bucket_count = sub_bucket_count * (64 - sub_bucket_bits); ///< Всего ячеек (значения до 2^63)
+
+    /**
+     * @brief Добавляет значение
+     * @param ns Задержка, нс (отрицательная считается нулевой)
+     */
+    void record(qint64 ns);
+
+    /**
+     * @brief Возвращает количество значений
+     * @return Количество
+     */
+    qint64 count() const;
+
+    /**
+     * @brief Возвращает сумму значений
+     * @return Сумма, нс
+     */
+    qint64 sum() const;
+
+    /**
+     * @brief Возвращает перцентиль
+     * @param fraction Доля от 0 до 1 (0.99 - 99-й перцентиль)
+     * @return Верхняя граница ячейки перцентиля, нс (0 - значений нет)
+     */
+    qint64 percentile(double fraction) const;
+
+    /**
+     * @brief Возвращает количество значений не больше границы
+     * @param bound_ns Граница, нс
+     * @return Количество значений в ячейках, целиком лежащих не выше границы
+     */
+    qint64 count_at_most(qint64 bound_ns) const;
+
+private:
+    /**
+     * @brief Возвращает ячейку значения
+     * @param ns Значение, нс
+     * @return Номер ячейки
+     */
+    static int bucket_of(qint64 ns);
+
+    /**
+     * @brief Возвращает наибольшее значение ячейки
+     * @param bucket Номер ячейки
+     * @return Значение, нс
+     */
+    static qint64 upper_bound(int bucket);
+
+    std::array<qint64, bucket_count> buckets{}; ///< Количество значений по ячейкам
+    qint64 total = 0;                          ///< Количество значений
+    qint64 total_ns = 0;                       ///< Сумма значений
+};
+
+/**
+ * @brief Реестр метрик с выводом в текстовом формате Prometheus
+ *
+ * Метрика задаётся именем, описанием и набором меток в виде готовой
+ * строки (например, type="equation"); ряды с одним именем выводятся
+ * вместе под одним заголовком. Указатели на метрики действительны, пока
+ * существует реестр. Реестр не защищён от одновременного доступа: им
+ * пользуется только поток владельца.
+ */
+class metrics_registry
+{
+public:
+    /**
+     * @brief Создаёт счётчик
+     * @param name Имя метрики
+     * @param help Описание
+     * @param labels Метки ряда
+     * @return Счётчик
+     */
+    metric_counter* counter(const QByteArray& name, const QByteArray& help, const QByteArray& labels = QByteArray());
+
+    /**
+     * @brief Создаёт величину
+     * @param name Имя метрики
+     * @param help Описание
+     * @param labels Метки ряда
+     * @return Величина
+     */
+    metric_gauge* gauge(const QByteArray& name, const QByteArray& help, const QByteArray& labels = QByteArray());
+
+    /**
+     * @brief Создаёт гистограмму задержек
+     * @param name Имя метрики (выводится в секундах)
+     * @param help Описание
+     * @param bounds Границы ячеек вывода le, с (по возрастанию)
+     * @param labels Метки ряда
+     * @return Гистограмма
+     */
+    latency_histogram* histogram(const QByteArray& name, const QByteArray& help, const QList<double>& bounds,
+                                 const QByteArray& labels = QByteArray());
+
+    /**
+     * @brief Формирует текст всех метрик
+     * @return Текстовый формат Prometheus 0.0.4
+     */
+    QByteArray to_prometheus() const;
+
+    /**
+     * @brief Записывает метрики в файл
+     * @param path Путь файла (для textfile collector node exporter - *.prom)
+     * @return false если файл не удалось записать
+     *
+     * Файл заменяется целиком, поэтому читатель не видит его наполовину записанным.
+     */
+    bool write_text_file(const QString& path) const;
+
+private:
+    /**
+     * @brief Вид метрики
+     */
+    enum class metric_kind {
+        COUNTER,   ///< metric_counter
+        GAUGE,     ///< metric_gauge
+        HISTOGRAM, ///< latency_histogram
+    };
+
+    /**
+     * @brief Ряд метрики
+     */
+    struct series {
+        metric_kind kind;               ///< Вид
+        QByteArray name;                ///< Имя метрики
+        QByteArray help;                ///< Описание
+        QByteArray labels;              ///< Метки
+        metric_counter counter;         ///< Значение счётчика
+        metric_gauge gauge;             ///< Значение величины
+        std::unique_ptr<latency_histogram> histogram; ///< Гистограмма
+        QList<double> bounds;           ///< Границы ячеек вывода гистограммы, с
+    };
+
+    /**
+     * @brief Добавляет ряд
+     * @param kind Вид
+     * @param name Имя метрики
+     * @param help Описание
+     * @param labels Метки
+     * @return Ряд
+     */
+    series& add(metric_kind kind, const QByteArray& name, const QByteArray& help, const QByteArray& labels);
+
+    std::vector<std::unique_ptr<series>> entries; ///< Ряды в порядке создания
+};
+
+#endif // METRICS_H
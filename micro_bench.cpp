@@ -0,0 +1,172 @@
+#include "frame_parser.h"
+#include "bisection_kernel.h"
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QRandomGenerator>
+#include <QStringList>
+#include <QList>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+#include <algorithm>
+#include <cmath>
+
+/**
+ * @file micro_bench.cpp
+ * @brief Микробенчмарки клиентских компонентов без сети и интерфейса
+ *
+ * Запуск: micro_bench [имя_бенчмарка ...]. Без аргументов выполняются все.
+ */
+
+/**
+ * @brief Формирует поток из count кадров с типичными ответами сервера
+ * @param mode Режим кадрирования
+ * @param count Количество кадров
+ * @return Поток байт, как он пришёл бы из сокета
+ */
+static QByteArray make_reply_stream(framing mode, int count) {
+    static const QList<QByteArray> replies = {
+        "answer|2$3", "answer|-2", "answer|no_solution", "answer|-3$3",
+        "answer|infinity_solutions", "auth|ok", "answer|-2.5$1"
+    };
+    QByteArray stream;
+    stream.reserve(count * 20);
+    for (int i = 0; i < count; i++)
+        frame_parser::encode_into(mode, replies[i % replies.size()], stream);
+    return stream;
+}
+
+/**
+ * @brief Прогоняет поток через разборщик кусками заданных размеров
+ * @param mode Режим кадрирования
+ * @param stream Поток байт
+ * @param chunks Размеры последовательных кусков (повторяются по кругу)
+ * @param label Название сценария для вывода
+ */
+static void run_parser_case(framing mode, const QByteArray& stream, const QList<int>& chunks, const char* label) {
+    frame_parser parser(mode);
+    qint64 frames = 0;
+
+    QElapsedTimer timer;
+    timer.start();
+    qsizetype position = 0;
+    int chunk_index = 0;
+    while (position < stream.size()) {
+        qsizetype length = qMin<qsizetype>(chunks[chunk_index++ % chunks.size()], stream.size() - position);
+        parser.feed(QByteArrayView(stream.constData() + position, length));
+        position += length;
+
+        QByteArrayView frame;
+        while (parser.next(frame))
+            frames++;
+    }
+    double seconds = timer.nsecsElapsed() / 1e9;
+
+    std::printf("  %-28s %10lld frames  %8.2f Mframes/s  %8.1f MB/s\n",
+                label, static_cast<long long>(frames),
+                frames / seconds / 1e6, stream.size() / seconds / (1024.0 * 1024.0));
+}
+
+/**
+ * @brief Бенчмарк разборщика кадров на фрагментированных и склеенных потоках
+ */
+static void bench_frame_parser() {
+    const int frame_count = 2000000;
+    struct mode_case { framing mode; const char* name; };
+    const mode_case modes[] = {
+        {framing::LENGTH_PREFIXED, "length-prefixed"},
+        {framing::DELIMITED, "delimited"},
+    };
+
+    // Размеры кусков: мелкая фрагментация TCP-сегментов и крупные склеенные чтения
+    QList<int> fragmented;
+    QRandomGenerator generator(42);
+    for (int i = 0; i < 4096; i++)
+        fragmented.append(generator.bounded(1, 64));
+    const QList<int> coalesced = {64 * 1024};
+    const QList<int> mtu_sized = {1448};
+
+    std::printf("frame_parser\n");
+    for (const mode_case& item : modes) {
+        QByteArray stream = make_reply_stream(item.mode, frame_count);
+        std::printf(" %s (%.1f MB)\n", item.name, stream.size() / (1024.0 * 1024.0));
+        run_parser_case(item.mode, stream, fragmented, "fragmented 1..63 B");
+        run_parser_case(item.mode, stream, mtu_sized, "segments 1448 B");
+        run_parser_case(item.mode, stream, coalesced, "coalesced 64 KiB");
+    }
+}
+
+/**
+ * @brief Бенчмарк ядра метода половинного деления: скалярная и AVX2-реализации
+ *
+ * Уравнения вида k(x - x1)(x - x2) со случайными корнями из [-100; 100];
+ * каждое даёт два интервала смены знака, как в bisection_solver.
+ */
+static void bench_bisection() {
+    const std::size_t equation_count = 1000000;
+    const double tolerance = 1e-12;
+    const int max_iterations = 200;
+
+    std::vector<double> a, b, c, lo, hi;
+    QRandomGenerator generator(7);
+    for (std::size_t i = 0; i < equation_count; i++) {
+        double x1 = generator.bounded(200.0) - 100;
+        double x2 = generator.bounded(200.0) - 100;
+        double k = generator.bounded(20.0) - 10;
+        if (k == 0 or x1 == x2)
+            continue;
+        double qa = k, qb = -k * (x1 + x2), qc = k * x1 * x2;
+        double vertex = -qb / (2 * qa);
+        double bound = 1 + std::max(std::abs(qb / qa), std::abs(qc / qa));
+        for (int side = 0; side < 2; side++) {
+            a.push_back(qa);
+            b.push_back(qb);
+            c.push_back(qc);
+            lo.push_back(side == 0 ? -bound : vertex);
+            hi.push_back(side == 0 ? vertex : bound);
+        }
+    }
+
+    std::vector<double> scalar_roots(a.size());
+    std::vector<double> vector_roots(a.size());
+    bisection_kernel::batch data{a.data(), b.data(), c.data(), lo.data(), hi.data(), nullptr, a.size()};
+
+    std::printf("bisection_kernel (%zu intervals, best: %s)\n", a.size(),
+                bisection_kernel::name(bisection_kernel::best_available()));
+    const bisection_kernel::isa kinds[] = {bisection_kernel::isa::SCALAR, bisection_kernel::isa::AVX2};
+    for (bisection_kernel::isa kind : kinds) {
+        data.root = kind == bisection_kernel::isa::SCALAR ? scalar_roots.data() : vector_roots.data();
+        QElapsedTimer timer;
+        timer.start();
+        bisection_kernel::solve(data, tolerance, max_iterations, kind);
+        double seconds = timer.nsecsElapsed() / 1e9;
+        std::printf("  %-8s %10.2f M equations/s  %10.2f M roots/s\n", bisection_kernel::name(kind),
+                    equation_count / seconds / 1e6, a.size() / seconds / 1e6);
+    }
+
+    std::size_t mismatches = 0;
+    for (std::size_t i = 0; i < a.size(); i++)
+        mismatches += std::memcmp(&scalar_roots[i], &vector_roots[i], sizeof(double)) != 0;
+    std::printf("  roots differing from scalar: %zu\n", mismatches);
+}
+
+/**
+ * @brief Точка входа бенчмарков
+ * @param argc Количество аргументов командной строки
+ * @param argv Имена бенчмарков для запуска
+ * @return Код возврата
+ */
+int main(int argc, char *argv[])
+{
+    QCoreApplication a(argc, argv);
+    QStringList selected = a.arguments().mid(1);
+    auto enabled = [&selected](const char* name) {
+        return selected.isEmpty() or selected.contains(QString(name));
+    };
+
+    if (enabled("parser"))
+        bench_frame_parser();
+    if (enabled("bisection"))
+        bench_bisection();
+    return 0;
+}
@@ -0,0 +1,25 @@
+QT = core
+
+CONFIG += c++17 console
+CONFIG -= app_bundle
+
+TARGET = micro_bench
+
+CONFIG -=debug_and_release
+CONFIG += release
+
+DESTDIR = $$PWD/build
+
+OBJECTS_DIR = ./build/micro_bench/obj
+MOC_DIR = ./build/micro_bench/moc
+
+INCLUDEPATH = "$$PWD/include"
+
+SOURCES += \
+    $$PWD/src/bisection_kernel.cpp \
+    $$PWD/src/frame_parser.cpp \
+    $$PWD/src/micro_bench.cpp
+
+HEADERS += \
+    $$PWD/include/bisection_kernel.h \
+    $$PWD/include/frame_parser.h
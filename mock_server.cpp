@@ -0,0 +1,418 @@
+#include "mock_server.h"
+#include "binary_codec.h"
+#include <QTimer>
+#include <QList>
+#include <QStringList>
+
+/**
+ * @brief Конструктор сервера
+ * @param options Поведение сервера
+ * @param parent Родительский объект
+ */
+mock_server::mock_server(const settings& options, QObject* parent) :
+    QObject(parent),
+    server(new QTcpServer(this)),
+    local_server(new QLocalServer(this)),
+    options(options),
+    random(QRandomGenerator::securelySeeded())
+{
+    this->clock.start();
+    connect(this->server, &QTcpServer::newConnection, this, &mock_server::accept);
+    connect(this->local_server, &QLocalServer::newConnection, this, &mock_server::accept_local);
+}
+
+/**
+ * @brief Начинает принимать соединения
+ * @param address Адрес
+ * @param port Порт (0 - любой свободный)
+ * @return true если порт открыт
+ */
+bool mock_server::listen(const QHostAddress& address, quint16 port) {
+    return this->server->listen(address, port);
+}
+
+/**
+ * @brief Начинает принимать соединения через локальный сокет
+ * @param name Путь или имя сокета
+ * @return true если сокет открыт
+ *
+ * Оставшийся от прошлого запуска файл сокета удаляется.
+ */
+bool mock_server::listen_local(const QString& name) {
+    QLocalServer::removeServer(name);
+    return this->local_server->listen(name);
+}
+
+/**
+ * @brief Возвращает открытый порт
+ * @return Номер порта
+ */
+quint16 mock_server::port() const {
+    return this->server->serverPort();
+}
+
+/**
+ * @brief Возвращает количество решённых уравнений
+ * @return Количество уравнений, включая уравнения из пакетов
+ */
+qint64 mock_server::equations_solved() const {
+    return this->solved.load(std::memory_order_relaxed);
+}
+
+/**
+ * @brief Принимает новые TCP-соединения
+ */
+void mock_server::accept() {
+    while (this->server->hasPendingConnections()) {
+        QTcpSocket* socket = this->server->nextPendingConnection();
+        socket->setSocketOption(QAbstractSocket::LowDelayOption, 1);
+        connect(socket, &QTcpSocket::disconnected, socket, &QObject::deleteLater);
+        this->add_peer(socket);
+    }
+}
+
+/**
+ * @brief Принимает новые соединения через локальный сокет
+ */
+void mock_server::accept_local() {
+    while (this->local_server->hasPendingConnections()) {
+        QLocalSocket* socket = this->local_server->nextPendingConnection();
+        connect(socket, &QLocalSocket::disconnected, socket, &QObject::deleteLater);
+        this->add_peer(socket);
+    }
+}
+
+/**
+ * @brief Начинает обслуживать принятое соединение
+ * @param socket Сокет клиента
+ *
+ * Состояние соединения удаляется вместе с сокетом; отложенные ответы
+ * привязаны к сокету и отменяются при его удалении.
+ */
+void mock_server::add_peer(QIODevice* socket) {
+    peer* client = new peer;
+    client->socket = socket;
+    connect(socket, &QIODevice::readyRead, this, [this, client]() { this->read(client); });
+    this->sockets.insert(socket);
+    connect(socket, &QObject::destroyed, this, [this, socket]() { this->sockets.remove(socket); });
+    connect(socket, &QObject::destroyed, [client]() { delete client; });
+}
+
+/**
+ * @brief Немедленно разрывает все клиентские соединения
+ * @return Количество разорванных соединений
+ */
+int mock_server::drop_connections() {
+    const QList<QIODevice*> dropped = this->sockets.values();
+    for (QIODevice* socket : dropped) {
+        if (auto* tcp = qobject_cast<QAbstractSocket*>(socket))
+            tcp->abort();
+        else if (auto* local = qobject_cast<QLocalSocket*>(socket))
+            local->abort();
+    }
+    return int(dropped.size());
+}
+
+/**
+ * @brief Читает данные клиента
+ * @param client Соединение
+ */
+void mock_server::read(peer* client) {
+    client->parser.feed(client->socket->readAll());
+    QByteArrayView frame;
+    while (client->parser.next(frame)) {
+        if (client->method == compression::NONE or !frame_compression::is_compressed(frame)) {
+            this->handle(client, frame);
+            continue;
+        }
+        QByteArray message;
+        if (!frame_compression::decompress(frame, message)) {
+            client->socket->close();
+            return;
+        }
+        this->handle(client, message);
+    }
+
+    if (client->parser.has_error())
+        client->socket->close();
+}
+
+/**
+ * @brief Обрабатывает одно сообщение клиента
+ * @param client Соединение
+ * @param message Содержимое кадра
+ *
+ * Согласование (hello| или устаревший framing|) допускается только
+ * первым сообщением и отвечается без кадрирования строкой,
+ * завершающейся '\n'. Сервер поддерживает оба режима кадрирования,
+ * пакеты, идентификаторы и двоичный формат, поэтому принимает всё, что
+ * предложил клиент из этого набора; идентификаторы запросов (а с ними и
+ * зависящие от них возможности) можно отключить настройкой request_ids.
+ */
+void mock_server::handle(peer* client, QByteArrayView message) {
+    bool first = client->first_message;
+    client->first_message = false;
+
+    handshake offered;
+    if (message.startsWith("hello|")) {
+        if (!first or !this->options.negotiate or !handshake::parse(message, offered))
+            return;
+        handshake supported = handshake::offer(offered.mode);
+        supported.request_ids = this->options.request_ids;
+        handshake agreed = supported.agree(offered);
+        client->socket->write(agreed.to_message() + "\n");
+        client->mode = agreed.mode;
+        client->method = agreed.compression_method();
+        client->parser.set_mode(agreed.mode);
+        return;
+    }
+    if (message.startsWith("framing|")) {
+        // Клиенты, собранные до появления hello
+        if (!first or !this->options.negotiate)
+            return;
+        framing mode = handshake::framing_from_name(message.sliced(8));
+        client->socket->write("framing|" + handshake::framing_name(mode) + "\n");
+        client->mode = mode;
+        client->parser.set_mode(mode);
+        return;
+    }
+
+    if (binary_codec::is_binary(message)) {
+        // Повреждённый запрос без разбираемого идентификатора остаётся без ответа
+        quint32 id = 0;
+        QByteArray reply = this->solve_binary(message, id);
+        if (!reply.isEmpty())
+            this->reply_later(client, reply, false, id);
+        return;
+    }
+
+    if (message.startsWith("equation|") or message.startsWith("equation_batch|")) {
+        qint64 id = -1;
+        QByteArray reply = this->solve(message, id);
+        this->reply_later(client, reply, id < 0, id);
+        return;
+    }
+    if (message.startsWith("cancel|")) {
+        // Ответ, уже отправленный или ещё не задержанный, отменять нечего
+        bool valid = false;
+        quint32 id = message.sliced(7).toByteArray().toUInt(&valid);
+        if (valid and client->delayed.contains(id))
+            client->canceled.insert(id);
+        return;
+    }
+
+    QByteArray reply = this->account(message);
+    if (!reply.isEmpty())
+        this->enqueue(client, reply);
+}
+
+/**
+ * @brief Решает одиночное уравнение или пакет
+ * @param message Сообщение "equation|<вид>|a$b[$c][|id]" или
+ *                "equation_batch|<вид>|a$b;<вид>|a$b$c|id"
+ * @param id Идентификатор запроса (-1, если его нет)
+ * @return Ответ "answer|<решение>[|id]" или "answer_batch|r1;r2|id"
+ */
+QByteArray mock_server::solve(QByteArrayView message, qint64& id) {
+    if (message.startsWith("equation_batch|")) {
+        QByteArrayView body = message.sliced(15);
+        qsizetype id_separator = body.lastIndexOf('|');
+        bool id_valid = false;
+        id = body.sliced(id_separator + 1).toByteArray().toUInt(&id_valid);
+        if (!id_valid)
+            id = -1;
+
+        QList<QByteArray> items = body.first(qMax<qsizetype>(id_separator, 0)).toByteArray().split(';');
+        QList<equation_request> equations;
+        QList<bool> valid;
+        for (const QByteArray& item : std::as_const(items)) {
+            equation_request equation;
+            valid.append(equation_request::parse(item, equation));
+            equations.append(equation);
+        }
+        QStringList answers = this->solver.solve_batch(equations);
+        for (int i = 0; i < answers.size(); i++)
+            if (!valid[i])
+                answers[i] = "error";
+        this->solved += equations.size();
+        return "answer_batch|" + answers.join(';').toUtf8() + "|" + body.sliced(id_separator + 1).toByteArray();
+    }
+
+    // "<вид>|a$b" без идентификатора или "<вид>|a$b|id"
+    QByteArrayView body = message.sliced(9);
+    qsizetype id_separator = body.lastIndexOf('|');
+    bool has_id = id_separator > 0 and body.indexOf('|') != id_separator;
+    if (has_id) {
+        bool id_valid = false;
+        id = body.sliced(id_separator + 1).toByteArray().toUInt(&id_valid);
+        if (!id_valid)
+            id = -1;
+    }
+
+    equation_request equation;
+    QByteArray answer = equation_request::parse(has_id ? body.first(id_separator) : body, equation)
+                            ? this->solver.solve(equation).toUtf8() : QByteArray("error");
+    this->solved++;
+    QByteArray reply = "answer|" + answer;
+    if (has_id)
+        reply += "|" + body.sliced(id_separator + 1).toByteArray();
+    return reply;
+}
+
+/**
+ * @brief Решает двоичный запрос (binary_codec)
+ * @param message Двоичный запрос на одно уравнение или пакет
+ * @param id Идентификатор запроса
+ * @return Двоичный ответ; пустой, если запрос повреждён
+ */
+QByteArray mock_server::solve_binary(QByteArrayView message, quint32& id) {
+    QList<equation_request> equations;
+    bool batch = false;
+    if (!binary_codec::decode_request(message, equations, id, batch))
+        return QByteArray();
+
+    QStringList answers = batch ? this->solver.solve_batch(equations) : QStringList{this->solver.solve(equations[0])};
+    this->solved += equations.size();
+    QByteArray reply;
+    binary_codec::encode_answer(answers, id, batch, reply);
+    return reply;
+}
+
+/**
+ * @brief Обрабатывает регистрацию, вход и сброс пароля
+ * @param message "reg|login$hash$email$...", "login|login$hash" или "reset|login$hash$email$..."
+ * @return Ответ сервера (пустой для неизвестных сообщений)
+ */
+QByteArray mock_server::account(QByteArrayView message) {
+    QString text = QString::fromUtf8(message);
+    QString command = text.section('|', 0, 0);
+    QStringList fields = text.section('|', 1).split('$');
+    QString login = fields.value(0);
+
+    if (command == "reg" or command == "register") {
+        if (fields.size() < 3 or login.isEmpty() or this->accounts.contains(login))
+            return "register|error";
+        this->accounts.insert(login, account_record{fields[1], fields[2]});
+        return "register|ok";
+    }
+    if (command == "login") {
+        auto record = this->accounts.constFind(login);
+        if (record != this->accounts.constEnd())
+            return record->password_hash == fields.value(1) ? "auth|ok" : "auth|error";
+        return this->options.accept_any_login and !login.isEmpty() ? "auth|ok" : "auth|error";
+    }
+    if (command == "reset") {
+        auto record = this->accounts.find(login);
+        if (fields.size() < 3 or record == this->accounts.end() or record->email != fields[2])
+            return "reset|error";
+        record->password_hash = fields[1];
+        return "reset|ok";
+    }
+    return QByteArray();
+}
+
+/**
+ * @brief Отправляет ответ после искусственной задержки
+ * @param client Соединение
+ * @param reply Ответ без кадрирования
+ * @param ordered Ответ не должен обгонять предыдущие (запрос без идентификатора)
+ * @param id Идентификатор запроса для отмены (-1 - без идентификатора)
+ *
+ * Ответы с идентификатором при разбросе задержки могут приходить
+ * не в порядке запросов, как у настоящего многопоточного сервера.
+ * Задержанный ответ не отправляется, если клиент успел прислать
+ * "cancel|<id>".
+ */
+void mock_server::reply_later(peer* client, const QByteArray& reply, bool ordered, qint64 id) {
+    qint64 delay = this->options.latency_ms;
+    if (this->options.jitter_ms > 0)
+        delay += this->random.bounded(this->options.jitter_ms + 1);
+
+    if (ordered) {
+        qint64 now = this->clock.elapsed();
+        client->last_due = qMax(client->last_due, now + delay);
+        delay = client->last_due - now;
+    }
+
+    if (delay <= 0) {
+        this->enqueue(client, reply);
+        return;
+    }
+    if (id >= 0)
+        client->delayed.insert(quint32(id));
+    QTimer::singleShot(std::chrono::milliseconds(delay), Qt::PreciseTimer, client->socket, [this, client, reply, id]() {
+        if (id >= 0) {
+            client->delayed.remove(quint32(id));
+            if (client->canceled.remove(quint32(id)))
+                return;
+        }
+        this->enqueue(client, reply);
+    });
+}
+
+/**
+ * @brief Добавляет ответ к склеиваемым и отправляет их, когда набралось достаточно
+ * @param client Соединение
+ * @param reply Ответ без кадрирования
+ *
+ * Ответ не короче порога сжимается, если сжатие согласовано при hello.
+ */
+void mock_server::enqueue(peer* client, const QByteArray& reply) {
+    QByteArray packed;
+    bool large = this->options.compression_threshold > 0 and reply.size() >= this->options.compression_threshold;
+    if (client->method != compression::NONE and large and frame_compression::compress(client->method, reply, packed))
+        frame_parser::encode_into(client->mode, packed, client->coalesced);
+    else
+        frame_parser::encode_into(client->mode, reply, client->coalesced);
+    client->coalesced_count++;
+
+    if (client->coalesced_count >= this->options.coalesce_count) {
+        this->flush(client);
+    }
+    else if (client->coalesced_count == 1) {
+        QTimer::singleShot(this->options.coalesce_window_ms, client->socket, [this, client]() {
+            this->flush(client);
+        });
+    }
+}
+
+/**
+ * @brief Записывает склеенные ответы в сокет
+ * @param client Соединение
+ */
+void mock_server::flush(peer* client) {
+    if (client->coalesced.isEmpty())
+        return;
+    client->outgoing.append(client->coalesced);
+    client->coalesced.clear();
+    client->coalesced_count = 0;
+
+    if (this->options.fragment_size <= 0) {
+        client->socket->write(client->outgoing);
+        client->outgoing.clear();
+    }
+    else if (!client->draining) {
+        this->drain(client);
+    }
+}
+
+/**
+ * @brief Записывает очередной кусок дробимого ответа
+ * @param client Соединение
+ *
+ * Каждый кусок отправляется отдельной записью в своей итерации цикла
+ * событий, поэтому клиент получает ответы по частям.
+ */
+void mock_server::drain(peer* client) {
+    qsizetype length = qMin<qsizetype>(this->options.fragment_size, client->outgoing.size());
+    client->socket->write(client->outgoing.constData(), length);
+    if (QAbstractSocket* tcp = qobject_cast<QAbstractSocket*>(client->socket))
+        tcp->flush();
+    else if (QLocalSocket* local = qobject_cast<QLocalSocket*>(client->socket))
+        local->flush();
+    client->outgoing.remove(0, length);
+
+    client->draining = !client->outgoing.isEmpty();
+    if (client->draining)
+        QTimer::singleShot(0, client->socket, [this, client]() { this->drain(client); });
+}
@@ -0,0 +1,217 @@
+#ifndef MOCK_SERVER_H
+#define MOCK_SERVER_H
+
+#include <QObject>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QLocalServer>
+#include <QLocalSocket>
+#include <QHostAddress>
+#include <QElapsedTimer>
+#include <QByteArray>
+#include <QHash>
+#include <QSet>
+#include <QRandomGenerator>
+#include <QString>
+#include "frame_compression.h"
+#include "frame_parser.h"
+#include "handshake.h"
+#include "bisection_solver.h"
+#include <atomic>
+
+/**
+ * @brief Заменитель сервера решения уравнений для бенчмарков без внешних служб
+ *
+ * Понимает тот же протокол, что и настоящий сервер: reg|, login|, reset|,
+ * согласование возможностей hello| (и прежнее framing|), equation|,
+ * equation_batch| и двоичные запросы binary_codec; сжатые сообщения
+ * (frame_compression) распаковывает, большие ответы сжимает.
+ * Уравнения решаются локальным bisection_solver. Ответы можно задерживать
+ * (задержка и разброс), дробить на мелкие куски и склеивать по несколько,
+ * чтобы воспроизводимо проверять сетевую часть клиента на одной машине.
+ *
+ * Объект можно перенести в отдельный поток и использовать внутри процесса
+ * бенчмарка; запуск отдельной программой - mock_server.pro.
+ */
+class mock_server : public QObject
+{
+    Q_OBJECT
+
+public:
+    /**
+     * @brief Поведение сервера
+     */
+    struct settings {
+        int latency_ms = 0;             ///< Задержка перед ответом на уравнение
+        int jitter_ms = 0;              ///< Случайная добавка к задержке от 0 до jitter_ms
+        int fragment_size = 0;          ///< Размер кусков, на которые дробятся ответы (0 - не дробить)
+        int coalesce_count = 1;         ///< Сколько ответов склеивать в одну запись
+        int coalesce_window_ms = 1;     ///< Максимальное ожидание набора coalesce_count ответов
+        bool negotiate = true;          ///< false - вести себя как старый сервер без hello и кадрирования
+        bool request_ids = true;        ///< false - не согласовывать идентификаторы запросов
+        bool accept_any_login = true;   ///< Принимать вход без предварительной регистрации
+        int compression_threshold = frame_compression::default_threshold; ///< Минимальный сжимаемый ответ, байт (0 - не сжимать)
+    };
+
+    /**
+     * @brief Конструктор сервера
+     * @param options Поведение сервера
+     * @param parent Родительский объект
+     */
+    explicit mock_server(const settings& options, QObject* parent = nullptr);
+
+    /**
+     * @brief Начинает принимать соединения
+     * @param address Адрес
+     * @param port Порт (0 - любой свободный)
+     * @return true если порт открыт
+     */
+    bool listen(const QHostAddress& address = QHostAddress::LocalHost, quint16 port = 0);
+
+    /**
+     * @brief Начинает принимать соединения через локальный сокет
+     * @param name Путь или имя сокета
+     * @return true если сокет открыт
+     */
+    bool listen_local(const QString& name);
+
+    /**
+     * @brief Возвращает открытый порт
+     * @return Номер порта
+     */
+    quint16 port() const;
+
+    /**
+     * @brief Возвращает количество решённых уравнений
+     * @return Количество уравнений, включая уравнения из пакетов
+     */
+    qint64 equations_solved() const;
+
+    /**
+     * @brief Немедленно разрывает все клиентские соединения
+     * @return Количество разорванных соединений
+     *
+     * Имитирует падение сервера: ответы, ожидающие задержки, теряются.
+     * Новые соединения продолжают приниматься.
+     */
+    int drop_connections();
+
+private:
+    /**
+     * @brief Состояние одного клиентского соединения
+     */
+    struct peer {
+        QIODevice* socket = nullptr;   ///< Сокет клиента (TCP или локальный)
+        frame_parser parser;           ///< Разборщик входящего потока
+        framing mode = framing::PLAIN; ///< Согласованный режим кадрирования
+        compression method = compression::NONE; ///< Согласованный алгоритм сжатия
+        bool first_message = true;     ///< Ещё не получено ни одного сообщения
+        QByteArray coalesced;          ///< Ответы, ожидающие склейки
+        int coalesced_count = 0;       ///< Количество ответов в coalesced
+        QByteArray outgoing;           ///< Байты, ожидающие записи кусками
+        bool draining = false;         ///< Запись кусками запланирована
+        qint64 last_due = 0;           ///< Момент последнего ответа без идентификатора (мс)
+        QSet<quint32> delayed;         ///< Идентификаторы ответов, ожидающих задержки
+        QSet<quint32> canceled;        ///< Отменённые клиентом из delayed
+    };
+
+    /**
+     * @brief Принимает новые TCP-соединения
+     */
+    void accept();
+
+    /**
+     * @brief Принимает новые соединения через локальный сокет
+     */
+    void accept_local();
+
+    /**
+     * @brief Начинает обслуживать принятое соединение
+     * @param socket Сокет клиента
+     */
+    void add_peer(QIODevice* socket);
+
+    /**
+     * @brief Читает данные клиента
+     * @param client Соединение
+     */
+    void read(peer* client);
+
+    /**
+     * @brief Обрабатывает одно сообщение клиента
+     * @param client Соединение
+     * @param message Содержимое кадра
+     */
+    void handle(peer* client, QByteArrayView message);
+
+    /**
+     * @brief Решает одиночное уравнение или пакет
+     * @param message Сообщение "equation|..." или "equation_batch|..."
+     * @param id Идентификатор запроса (-1, если его нет)
+     * @return Ответ "answer|..." или "answer_batch|..."
+     */
+    QByteArray solve(QByteArrayView message, qint64& id);
+
+    /**
+     * @brief Решает двоичный запрос (binary_codec)
+     * @param message Двоичный запрос на одно уравнение или пакет
+     * @param id Идентификатор запроса
+     * @return Двоичный ответ; пустой, если запрос повреждён
+     */
+    QByteArray solve_binary(QByteArrayView message, quint32& id);
+
+    /**
+     * @brief Обрабатывает регистрацию, вход и сброс пароля
+     * @param message Сообщение клиента
+     * @return Ответ сервера
+     */
+    QByteArray account(QByteArrayView message);
+
+    /**
+     * @brief Отправляет ответ после искусственной задержки
+     * @param client Соединение
+     * @param reply Ответ без кадрирования
+     * @param ordered Ответ не должен обгонять предыдущие (запрос без идентификатора)
+     * @param id Идентификатор запроса для отмены (-1 - без идентификатора)
+     */
+    void reply_later(peer* client, const QByteArray& reply, bool ordered, qint64 id = -1);
+
+    /**
+     * @brief Добавляет ответ к склеиваемым и отправляет их, когда набралось достаточно
+     * @param client Соединение
+     * @param reply Ответ без кадрирования
+     */
+    void enqueue(peer* client, const QByteArray& reply);
+
+    /**
+     * @brief Записывает склеенные ответы в сокет
+     * @param client Соединение
+     */
+    void flush(peer* client);
+
+    /**
+     * @brief Записывает очередной кусок дробимого ответа
+     * @param client Соединение
+     */
+    void drain(peer* client);
+
+    /**
+     * @brief Учётная запись, созданная через reg|
+     */
+    struct account_record {
+        QString password_hash; ///< SHA-256 пароля
+        QString email;         ///< Почта
+    };
+
+    QTcpServer* server;                          ///< Слушающий TCP-сокет
+    QLocalServer* local_server;                  ///< Слушающий локальный сокет
+    settings options;                            ///< Поведение сервера
+    bisection_solver solver;                     ///< Решатель уравнений
+    QRandomGenerator random;                     ///< Генератор разброса задержки
+    QElapsedTimer clock;                         ///< Часы для упорядочивания ответов
+    QHash<QString, account_record> accounts;     ///< Учётные записи по логину
+    QSet<QIODevice*> sockets;                    ///< Сокеты обслуживаемых клиентов
+    std::atomic<qint64> solved{0};               ///< Количество решённых уравнений (читается из других потоков)
+};
+
+#endif // MOCK_SERVER_H
@@ -0,0 +1,44 @@
+QT = core network
+
+CONFIG += c++17 console
+CONFIG -= app_bundle
+
+TARGET = mock_server
+
+CONFIG -=debug_and_release
+CONFIG += release
+
+DESTDIR = $$PWD/build
+
+OBJECTS_DIR = ./build/mock_server/obj
+MOC_DIR = ./build/mock_server/moc
+
+INCLUDEPATH = "$$PWD/include"
+
+# Сжатие zstd подключается, если библиотека установлена; иначе только zlib (qCompress)
+packagesExist(libzstd) {
+    CONFIG += link_pkgconfig
+    PKGCONFIG += libzstd
+    DEFINES += HAVE_ZSTD
+}
+
+SOURCES += \
+    $$PWD/src/binary_codec.cpp \
+    $$PWD/src/bisection_kernel.cpp \
+    $$PWD/src/bisection_solver.cpp \
+    $$PWD/src/equation.cpp \
+    $$PWD/src/frame_compression.cpp \
+    $$PWD/src/frame_parser.cpp \
+    $$PWD/src/handshake.cpp \
+    $$PWD/src/mock_server.cpp \
+    $$PWD/src/mock_server_main.cpp
+
+HEADERS += \
+    $$PWD/include/binary_codec.h \
+    $$PWD/include/bisection_kernel.h \
+    $$PWD/include/bisection_solver.h \
+    $$PWD/include/equation.h \
+    $$PWD/include/frame_compression.h \
+    $$PWD/include/frame_parser.h \
+    $$PWD/include/handshake.h \
+    $$PWD/include/mock_server.h
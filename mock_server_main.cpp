@@ -0,0 +1,64 @@
+#include "mock_server.h"
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <cstdio>
+
+/**
+ * @file mock_server_main.cpp
+ * @brief Отдельный запуск заменителя сервера решения уравнений
+ *
+ * Пример: mock_server --port 8080 --local /tmp/solver.sock --latency 2 --jitter 3 --fragment 7 --coalesce 4
+ */
+
+/**
+ * @brief Точка входа заменителя сервера
+ * @param argc Количество аргументов командной строки
+ * @param argv Аргументы командной строки
+ * @return Код возврата
+ */
+int main(int argc, char *argv[])
+{
+    QCoreApplication a(argc, argv);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Заменитель сервера решения уравнений");
+    parser.addHelpOption();
+    parser.addOptions({
+        {"port", "Порт.", "port", "8080"},
+        {"local", "Дополнительно слушать локальный сокет с заданным путём или именем.", "name"},
+        {"latency", "Задержка ответа на уравнение, мс.", "ms", "0"},
+        {"jitter", "Случайная добавка к задержке от 0 до заданной, мс.", "ms", "0"},
+        {"fragment", "Дробить ответы на куски заданного размера, байт.", "bytes", "0"},
+        {"coalesce", "Склеивать ответы по заданному количеству.", "n", "1"},
+        {"coalesce-window", "Максимальное ожидание склейки, мс.", "ms", "1"},
+        {"compression-threshold", "Сжимать ответы не короче заданного размера, байт (0 - не сжимать).", "bytes", "1024"},
+        {"legacy", "Не отвечать на hello и запрос кадрирования, как старый сервер."},
+        {"no-ids", "Не согласовывать идентификаторы запросов."},
+        {"strict-auth", "Принимать вход только после регистрации."},
+    });
+    parser.process(a);
+
+    mock_server::settings options;
+    options.latency_ms = qMax(0, parser.value("latency").toInt());
+    options.jitter_ms = qMax(0, parser.value("jitter").toInt());
+    options.fragment_size = qMax(0, parser.value("fragment").toInt());
+    options.coalesce_count = qMax(1, parser.value("coalesce").toInt());
+    options.coalesce_window_ms = qMax(0, parser.value("coalesce-window").toInt());
+    options.compression_threshold = qMax(0, parser.value("compression-threshold").toInt());
+    options.negotiate = !parser.isSet("legacy");
+    options.request_ids = !parser.isSet("no-ids");
+    options.accept_any_login = !parser.isSet("strict-auth");
+
+    mock_server server(options);
+    if (!server.listen(QHostAddress::Any, quint16(parser.value("port").toUInt()))) {
+        std::fprintf(stderr, "cannot listen on port %s\n", qPrintable(parser.value("port")));
+        return 1;
+    }
+    if (parser.isSet("local") and !server.listen_local(parser.value("local"))) {
+        std::fprintf(stderr, "cannot listen on local socket %s\n", qPrintable(parser.value("local")));
+        return 1;
+    }
+    std::printf("mock_server listening on port %u\n", server.port());
+    std::fflush(stdout);
+    return a.exec();
+}
@@ -0,0 +1,550 @@
+#include "network_worker.h"
+#include "binary_codec.h"
+#include "logger.h"
+#include "trace.h"
+#include <QElapsedTimer>
+
+/// Время ожидания ответа сервера на hello (мс)
+#define NEGOTIATION_TIMEOUT_MS 2000
+/// Наибольший объём пакетных кадров в буфере записи сокета (байт); остальные ждут в полосе
+#define SOCKET_BUDGET (64 * 1024)
+
+/**
+ * @brief Извлекает идентификатор запроса из ответа сервера для трассировки
+ * @param message Содержимое кадра
+ * @return Идентификатор; 0 для ответа без идентификатора и прочих сообщений
+ */
+static quint32 response_id(QByteArrayView message) {
+    if (message.startsWith(binary_codec::answer_tag) or message.startsWith(binary_codec::answer_batch_tag)) {
+        if (message.size() < 5)
+            return 0;
+        return quint32(quint8(message[1])) | quint32(quint8(message[2])) << 8 | quint32(quint8(message[3])) << 16
+               | quint32(quint8(message[4])) << 24;
+    }
+    // "answer|<решение>|<id>" и "answer_batch|<ответы>|<id>"; у старого сервера полей два
+    if ((!message.startsWith("answer|") and !message.startsWith("answer_batch|")) or message.count('|') < 2)
+        return 0;
+    return message.sliced(message.lastIndexOf('|') + 1).toUInt();
+}
+
+/**
+ * @brief Конструктор сетевой части
+ * @param offer Возможности протокола, предлагаемые серверу
+ * @param parent Родительский объект
+ *
+ * Таймер создаётся дочерним объектом, поэтому переносится в сетевой
+ * поток вместе с network_worker. Соединение создаётся в connect_to.
+ */
+network_worker::network_worker(const handshake& offer, QObject* parent) :
+    QObject(parent),
+    negotiation_timer(new QTimer(this)),
+    offered(offer)
+{
+    // Старый сервер не отвечает на hello: остаёмся в прежнем режиме
+    this->negotiation_timer->setSingleShot(true);
+    connect(this->negotiation_timer, &QTimer::timeout, this, [this]() {
+        this->apply_handshake(handshake());
+    });
+}
+
+/**
+ * @brief Подключается к серверу
+ * @param address Адрес сервера (TCP или локальный сокет)
+ *
+ * Соединение нужного вида создаётся в потоке network_worker; при смене
+ * вида адреса прежнее соединение удаляется.
+ */
+void network_worker::connect_to(const endpoint& address) {
+    if (this->socket != nullptr and this->socket->type() != address.type) {
+        this->socket->abort();
+        this->socket->deleteLater();
+        this->socket = nullptr;
+    }
+    if (this->socket == nullptr) {
+        this->socket = transport::create(address.type, this);
+        connect(this->socket, &transport::connected, this, &network_worker::on_connected);
+        connect(this->socket, &transport::disconnected, this, &network_worker::on_disconnected);
+        connect(this->socket, &transport::ready_read, this, &network_worker::read);
+        connect(this->socket, &transport::bytes_written, this, &network_worker::on_bytes_written);
+        connect(this->socket, &transport::error_occurred, this, &network_worker::on_error);
+    }
+    this->socket->open(address);
+}
+
+/**
+ * @brief Обработчик установки соединения
+ *
+ * Отправляет серверу hello с предлагаемыми возможностями. До получения
+ * ответа исходящие сообщения накапливаются в pending_writes, а сигнал
+ * connected испускается после согласования.
+ */
+void network_worker::on_connected() {
+    this->link_up = true;
+    this->socket->configure(this->options);
+    this->parser.reset();
+    this->parser.set_mode(framing::PLAIN);
+    this->agreed = handshake();
+
+    // Запрос отправляется без кадрирования, ответ сервера завершается '\n'
+    this->negotiating = true;
+    QByteArray hello = this->offered.to_message();
+    this->socket->write(hello);
+    this->sent_bytes.fetch_add(hello.size(), std::memory_order_relaxed);
+    this->negotiation_timer->start(NEGOTIATION_TIMEOUT_MS);
+}
+
+/**
+ * @brief Обработчик разрыва соединения
+ */
+void network_worker::on_disconnected() {
+    this->link_up = false;
+    this->negotiation_timer->stop();
+    this->negotiating = false;
+    this->pending_writes.clear();
+    this->parser.reset();
+    this->socket->close();
+    // Данные разорванного соединения уже не будут отправлены
+    bool wanted = false;
+    for (int lane = 0; lane < lane_scheduler::lane_count; lane++) {
+        this->lanes[lane].clear();
+        this->lane_bytes[lane] = 0;
+        this->queued[lane] = 0;
+        wanted = this->drain_wanted[lane].exchange(false) or wanted;
+    }
+    this->buffered = 0;
+    if (wanted)
+        emit this->drained();
+    emit this->disconnected();
+}
+
+/**
+ * @brief Обработчик ошибки сокета
+ *
+ * Ошибки установленного соединения завершаются сигналом disconnected;
+ * здесь сообщается только о неудачной попытке подключения.
+ */
+void network_worker::on_error() {
+    if (!this->link_up and !this->socket->is_open())
+        emit this->connection_failed();
+}
+
+/**
+ * @brief Отправляет сообщение серверу
+ * @param message Сообщение без кадрирования
+ * @param priority Полоса очереди отправки
+ */
+void network_worker::send(const QByteArray& message, send_priority priority) {
+    if (this->socket == nullptr or !this->socket->is_open())
+        return;
+    if (this->negotiating) {
+        // Возможности протокола ещё не согласованы
+        this->pending_writes.append(message);
+        return;
+    }
+    QByteArray packed;
+    const QByteArray& payload = this->pack(message, packed);
+    QByteArray frame = frame_parser::encode(this->agreed.mode, payload);
+    // Ответы без идентификаторов сопоставляются по порядку запросов, и полосы не должны его менять
+    int lane = lane_scheduler::lane(this->agreed.request_ids ? priority : send_priority::BULK);
+    this->lane_bytes[lane] += frame.size();
+    this->lanes[lane].append(std::move(frame));
+    if (!this->coalesce_writes) {
+        this->flush_outbound();
+        return;
+    }
+
+    if (!this->flush_scheduled) {
+        // Запись выполняется после всех команд, уже стоящих в очереди потока
+        this->flush_scheduled = true;
+        QMetaObject::invokeMethod(this, &network_worker::flush_outbound, Qt::QueuedConnection);
+    }
+}
+
+/**
+ * @brief Переносит кадры из полос в буфер записи сокета
+ *
+ * Полосы обслуживаются по весам lane_scheduler. Пакетных кадров в
+ * буфере записи сокета держится не больше SOCKET_BUDGET, остальные ждут
+ * в полосе, поэтому интерактивный кадр, пришедший во время большого
+ * пакета, попадает в сокет сразу, а не за мегабайтами пакетных.
+ * Интерактивные кадры бюджетом не ограничиваются. При склейке записей
+ * все выбранные кадры передаются ядру одним системным вызовом сразу,
+ * не дожидаясь уведомления о готовности сокета к записи.
+ *
+ * Отрезок "socket flush" относится к сетевому потоку, а не к запросу:
+ * одна запись несёт кадры многих запросов, поэтому в args отрезка
+ * только количество кадров и байт.
+ */
+void network_worker::flush_outbound() {
+    this->flush_scheduled = false;
+    if (this->socket == nullptr or !this->socket->is_open())
+        return;
+
+    trace_span span("socket flush", "network");
+    qint64 sent_before = this->sent_bytes.load(std::memory_order_relaxed);
+    qint64 room = SOCKET_BUDGET - this->socket->bytes_to_write();
+    QByteArray out;
+    qint64 frames = 0;
+    const int interactive = lane_scheduler::lane(send_priority::INTERACTIVE);
+    const int bulk = lane_scheduler::lane(send_priority::BULK);
+    for (;;) {
+        bool interactive_ready = !this->lanes[interactive].isEmpty();
+        bool bulk_ready = !this->lanes[bulk].isEmpty() and room > 0;
+        if (!interactive_ready and !bulk_ready)
+            break;
+        int lane = lane_scheduler::lane(this->scheduler.next(interactive_ready, bulk_ready));
+        QByteArray frame = this->lanes[lane].takeFirst();
+        this->lane_bytes[lane] -= frame.size();
+        frames++;
+        if (lane == bulk)
+            room -= frame.size();
+        if (this->coalesce_writes) {
+            out.append(frame);
+            continue;
+        }
+        this->socket->write(frame);
+        this->socket->flush();
+        this->writes++;
+        this->sent_bytes.fetch_add(frame.size(), std::memory_order_relaxed);
+    }
+    if (!out.isEmpty()) {
+        this->socket->write(out);
+        this->socket->flush();
+        this->writes++;
+        this->sent_bytes.fetch_add(out.size(), std::memory_order_relaxed);
+    }
+    span.add_arg("frames", frames);
+    span.add_arg("bytes", this->sent_bytes.load(std::memory_order_relaxed) - sent_before);
+    this->update_backlog();
+}
+
+/**
+ * @brief Обработчик передачи части буфера записи операционной системе
+ *
+ * Освободившееся место в бюджете сокета занимают кадры из полос.
+ */
+void network_worker::on_bytes_written() {
+    bool pending = false;
+    for (const QList<QByteArray>& lane : this->lanes)
+        pending = pending or !lane.isEmpty();
+    if (pending)
+        this->flush_outbound();
+    else
+        this->update_backlog();
+}
+
+/**
+ * @brief Включает или выключает склейку записей
+ * @param enabled true - одна запись в сокет за итерацию цикла событий
+ */
+void network_worker::set_write_coalescing(bool enabled) {
+    this->coalesce_writes = enabled;
+    if (!enabled)
+        this->flush_outbound();
+}
+
+/**
+ * @brief Задаёт параметры сокета для следующих подключений
+ * @param options Параметры сокета
+ *
+ * К уже установленному соединению параметры применяются сразу.
+ */
+void network_worker::set_socket_options(const socket_options& options) {
+    this->options = options;
+    if (this->socket != nullptr and this->socket->is_open())
+        this->socket->configure(options);
+}
+
+/**
+ * @brief Задаёт минимальный размер сжимаемого сообщения
+ * @param bytes Порог, байт (0 - не сжимать)
+ */
+void network_worker::set_compression_threshold(qsizetype bytes) {
+    this->compression_threshold = qMax<qsizetype>(0, bytes);
+}
+
+/**
+ * @brief Возвращает количество записей в сокет
+ * @return Количество вызовов transport::write (только из сетевого потока)
+ */
+qint64 network_worker::write_calls() const {
+    return this->writes;
+}
+
+/**
+ * @brief Возвращает количество байт, записанных в сокет
+ * @return Байт с кадрированием и сжатием, включая hello (можно вызывать из любого потока)
+ */
+qint64 network_worker::bytes_sent() const {
+    return this->sent_bytes.load(std::memory_order_relaxed);
+}
+
+/**
+ * @brief Возвращает количество байт, прочитанных из сокета
+ * @return Байт с кадрированием и сжатием (можно вызывать из любого потока)
+ */
+qint64 network_worker::bytes_received() const {
+    return this->received_bytes.load(std::memory_order_relaxed);
+}
+
+/**
+ * @brief Возвращает счётчики сжатия соединения
+ * @return Копия счётчиков
+ */
+compression_stats network_worker::compression_counters() const {
+    QMutexLocker locker(&this->stats_lock);
+    return this->stats;
+}
+
+/**
+ * @brief Передаёт сообщения сетевому потоку
+ * @param messages Сообщения без кадрирования
+ * @param priority Полоса очереди отправки
+ *
+ * Размер сообщений вычитается из backlog после того, как send положит
+ * их в полосу, где они учитываются уже как queued.
+ */
+void network_worker::post(const QByteArrayList& messages, send_priority priority) {
+    qint64 size = 0;
+    for (const QByteArray& message : messages)
+        size += message.size();
+    int lane = lane_scheduler::lane(priority);
+    this->posted[lane] += size;
+    QMetaObject::invokeMethod(this, [this, messages, size, priority, lane]() {
+        for (const QByteArray& message : messages)
+            this->send(message, priority);
+        this->posted[lane] -= size;
+        this->update_backlog();
+    }, Qt::QueuedConnection);
+}
+
+/**
+ * @brief Задаёт пороги неотправленных данных
+ * @param high Верхний порог, байт
+ * @param low Нижний порог, байт (не больше верхнего)
+ */
+void network_worker::set_watermarks(qint64 high, qint64 low) {
+    this->high_watermark = qMax<qint64>(1, high);
+    this->low_watermark = qBound<qint64>(0, low, this->high_watermark);
+}
+
+/**
+ * @brief Возвращает объём неотправленных данных полосы
+ * @param priority Полоса
+ * @return Байт в очереди сетевого потока и в полосе; буфер записи
+ *         сокета относится к пакетной полосе
+ */
+qint64 network_worker::backlog(send_priority priority) const {
+    int lane = lane_scheduler::lane(priority);
+    qint64 bytes = this->posted[lane] + this->queued[lane];
+    return priority == send_priority::BULK ? bytes + this->buffered : bytes;
+}
+
+/**
+ * @brief Проверяет, достиг ли объём неотправленных данных полосы верхнего порога
+ * @param priority Полоса
+ * @return true если отправку в полосу нужно приостановить
+ *
+ * Сетевой поток может освободить полосу между проверкой backlog и
+ * установкой флага drain_wanted, и тогда drained не пришёл бы никогда.
+ * Поэтому backlog перечитывается после установки флага: если он выше
+ * нижнего порога, update_backlog увидит флаг, когда полоса освободится;
+ * если уже не выше, флаг снимается и полоса считается свободной.
+ * Пакетная полоса не может остановить интерактивную.
+ */
+bool network_worker::congested(send_priority priority) {
+    if (this->backlog(priority) < this->high_watermark)
+        return false;
+    int lane = lane_scheduler::lane(priority);
+    this->drain_wanted[lane] = true;
+    if (this->backlog(priority) > this->low_watermark)
+        return true;
+    this->drain_wanted[lane] = false;
+    return false;
+}
+
+/**
+ * @brief Обновляет размеры полос и буфера записи в backlog и сообщает об освобождении
+ *
+ * Вызывается сетевым потоком после каждой записи в сокет и при передаче
+ * части буфера операционной системе (transport::bytes_written).
+ */
+void network_worker::update_backlog() {
+    this->buffered = this->socket != nullptr ? this->socket->bytes_to_write() : 0;
+    bool drained = false;
+    for (send_priority priority : {send_priority::INTERACTIVE, send_priority::BULK}) {
+        int lane = lane_scheduler::lane(priority);
+        this->queued[lane] = this->lane_bytes[lane];
+        if (this->backlog(priority) <= this->low_watermark and this->drain_wanted[lane].exchange(false))
+            drained = true;
+    }
+    if (drained)
+        emit this->drained();
+}
+
+/**
+ * @brief Сжимает сообщение, если это согласовано и оно не короче порога
+ * @param message Сообщение
+ * @param packed Буфер для сжатого сообщения
+ * @return Ссылка на message или на packed
+ *
+ * Если сжатие не уменьшает сообщение, оно отправляется как есть;
+ * время такой попытки тоже учитывается.
+ */
+const QByteArray& network_worker::pack(const QByteArray& message, QByteArray& packed) {
+    compression method = this->agreed.compression_method();
+    if (method == compression::NONE or this->compression_threshold <= 0
+        or message.size() < this->compression_threshold)
+        return message;
+
+    QElapsedTimer timer;
+    timer.start();
+    bool smaller = frame_compression::compress(method, message, packed);
+    qint64 elapsed = timer.nsecsElapsed();
+
+    QMutexLocker locker(&this->stats_lock);
+    this->stats.compress_ns += elapsed;
+    if (!smaller)
+        return message;
+    this->stats.frames_packed++;
+    this->stats.sent_raw += message.size();
+    this->stats.sent_packed += packed.size();
+    return packed;
+}
+
+/**
+ * @brief Распаковывает сжатое сообщение
+ * @param frame Содержимое кадра
+ * @param out Исходное сообщение
+ * @return false если кадр повреждён
+ */
+bool network_worker::unpack(QByteArrayView frame, QByteArray& out) {
+    QElapsedTimer timer;
+    timer.start();
+    bool valid = frame_compression::decompress(frame, out);
+    qint64 elapsed = timer.nsecsElapsed();
+
+    QMutexLocker locker(&this->stats_lock);
+    this->stats.decompress_ns += elapsed;
+    if (valid) {
+        this->stats.frames_unpacked++;
+        this->stats.received_packed += frame.size();
+        this->stats.received_raw += out.size();
+    }
+    return valid;
+}
+
+/**
+ * @brief Обрабатывает ответ сервера на hello
+ * @return true если согласование завершено, false если ответ ещё не получен полностью
+ *
+ * Сервер отвечает строкой "hello|<версия>|<возможности>\n". Если поток
+ * начинается с чего-то другого, это старый сервер: возможности не
+ * согласованы, а полученные данные разбираются как обычные сообщения.
+ */
+bool network_worker::finish_handshake() {
+    static const QByteArrayView prefix("hello|");
+    QByteArrayView data = this->parser.pending();
+
+    if (!prefix.startsWith(data.first(qMin(data.size(), prefix.size())))) {
+        this->apply_handshake(handshake());
+        return true;
+    }
+    qsizetype end = data.indexOf(frame_parser::delimiter);
+    if (end < 0)
+        return false;
+
+    handshake reply;
+    if (!handshake::parse(data.first(end), reply))
+        reply = handshake();
+    this->parser.consume(end + 1);
+    // Сервер не может включить то, что клиент не предлагал
+    this->apply_handshake(this->offered.agree(reply));
+    return true;
+}
+
+/**
+ * @brief Завершает согласование и отправляет накопленные сообщения
+ * @param features Согласованные возможности
+ */
+void network_worker::apply_handshake(const handshake& features) {
+    if (!this->negotiating)
+        return;
+    this->negotiation_timer->stop();
+    this->negotiating = false;
+    this->agreed = features;
+    this->parser.set_mode(features.mode);
+    LOG_INFO("network", "Согласовано: " + features.to_message());
+    emit this->connected(features);
+
+    QByteArray out;
+    for (const QByteArray& message : std::as_const(this->pending_writes)) {
+        QByteArray packed;
+        frame_parser::encode_into(features.mode, this->pack(message, packed), out);
+    }
+    this->pending_writes.clear();
+    if (!out.isEmpty()) {
+        this->socket->write(out);
+        this->writes++;
+        this->sent_bytes.fetch_add(out.size(), std::memory_order_relaxed);
+        this->update_backlog();
+    }
+}
+
+/**
+ * @brief Читает данные из сокета
+ *
+ * Все полные кадры, накопившиеся к моменту чтения, отправляются
+ * в поток интерфейса одним сигналом. Сжатые кадры распаковываются
+ * здесь, поэтому поток интерфейса получает исходные сообщения.
+ *
+ * Отрезок "socket read" относится к потоку, а не к запросу: за одно
+ * чтение разбираются ответы многих запросов. На дорожку каждого запроса
+ * попадает событие "response received" в момент разбора его ответа;
+ * ответы сервера без идентификаторов сопоставляются только в потоке
+ * интерфейса, поэтому такого события у них нет.
+ */
+void network_worker::read() {
+    trace_span span("socket read", "network");
+    bool tracing = trace::enabled();
+    QByteArrayList messages;
+    bool corrupted = false;
+    while (!corrupted and this->socket->bytes_available() > 0) {
+        QByteArray data = this->socket->read_all();
+        this->received_bytes.fetch_add(data.size(), std::memory_order_relaxed);
+        this->parser.feed(data);
+        if (this->negotiating and !this->finish_handshake())
+            continue;
+
+        QByteArrayView frame;
+        while (!corrupted and this->parser.next(frame)) {
+            if (this->agreed.compression_method() == compression::NONE
+                or !frame_compression::is_compressed(frame)) {
+                messages.append(frame.toByteArray());
+            }
+            else {
+                QByteArray message;
+                corrupted = !this->unpack(frame, message);
+                if (corrupted)
+                    break;
+                messages.append(std::move(message));
+            }
+            quint32 id = tracing ? response_id(messages.last()) : 0;
+            if (id != 0)
+                trace::async_instant("response received", id);
+        }
+    }
+
+    span.add_arg("messages", messages.size());
+    if (!messages.isEmpty())
+        emit this->messages_received(messages);
+
+    if (corrupted) {
+        LOG_CRITICAL("network", "Повреждённый сжатый кадр от сервера, соединение разорвано");
+        this->socket->abort();
+    }
+    else if (this->parser.has_error()) {
+        LOG_CRITICAL("network", "Некорректный кадр от сервера, соединение разорвано");
+        this->socket->abort();
+    }
+}
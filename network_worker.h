@@ -0,0 +1,272 @@
+#ifndef NETWORK_WORKER_H
+#define NETWORK_WORKER_H
+
+#include <QObject>
+#include <QTimer>
+#include <QByteArray>
+#include <QByteArrayList>
+#include <QMutex>
+#include <QString>
+#include "frame_compression.h"
+#include "frame_parser.h"
+#include "handshake.h"
+#include "endpoint.h"
+#include "transport.h"
+#include "lane_scheduler.h"
+#include <atomic>
+
+/**
+ * @brief Сетевая часть клиента, работающая в отдельном потоке
+ *
+ * Владеет соединением (transport) и разборщиком кадров. Команды принимает через
+ * очередь событий своего потока, разобранные сообщения отдаёт пачками
+ * сигналом messages_received, поэтому перерисовка окон и модальные
+ * диалоги в потоке интерфейса не задерживают сетевой ввод-вывод.
+ *
+ * Исходящие кадры ждут в двух полосах (send_priority), и в буфер записи
+ * сокета пакетных кадров попадает не больше небольшого бюджета, поэтому
+ * интерактивный кадр не стоит за большим пакетом. Если сервер не
+ * согласовал идентификаторы запросов, все кадры идут пакетной полосой
+ * в порядке отправки: его ответы сопоставляются с запросами по порядку.
+ *
+ * Объём неотправленных данных (backlog) каждой полосы учитывается
+ * атомарно: в него входят сообщения, переданные через post, но ещё не
+ * обработанные сетевым потоком, кадры в полосе и (для пакетной полосы)
+ * буфер записи сокета. Поток интерфейса проверяет его методом congested
+ * и ждёт сигнала drained, а не копит сообщения без ограничения.
+ */
+class network_worker : public QObject
+{
+    Q_OBJECT
+
+public:
+    /**
+     * @brief Конструктор сетевой части
+     * @param offer Возможности протокола, предлагаемые серверу (handshake::offer)
+     * @param parent Родительский объект
+     */
+    explicit network_worker(const handshake& offer, QObject* parent = nullptr);
+
+public slots:
+    /**
+     * @brief Подключается к серверу
+     * @param address Адрес сервера (TCP или локальный сокет)
+     */
+    void connect_to(const endpoint& address);
+
+    /**
+     * @brief Отправляет сообщение серверу
+     * @param message Сообщение без кадрирования
+     * @param priority Полоса очереди отправки
+     *
+     * При склейке записей кадр попадает в полосу, из которой кадры
+     * записываются в сокет одним вызовом в конце итерации цикла событий.
+     */
+    void send(const QByteArray& message, send_priority priority = send_priority::BULK);
+
+    /**
+     * @brief Включает или выключает склейку записей
+     * @param enabled true - одна запись в сокет за итерацию цикла событий
+     */
+    void set_write_coalescing(bool enabled);
+
+    /**
+     * @brief Задаёт параметры сокета для следующих подключений
+     * @param options Параметры сокета
+     */
+    void set_socket_options(const socket_options& options);
+
+    /**
+     * @brief Задаёт минимальный размер сжимаемого сообщения
+     * @param bytes Порог, байт (0 - не сжимать)
+     *
+     * Сообщения сжимаются, только если сервер согласовал сжатие при hello.
+     */
+    void set_compression_threshold(qsizetype bytes);
+
+public:
+    /**
+     * @brief Возвращает количество записей в сокет
+     * @return Количество вызовов transport::write (только из сетевого потока)
+     */
+    qint64 write_calls() const;
+
+    /**
+     * @brief Возвращает количество байт, записанных в сокет
+     * @return Байт с кадрированием и сжатием, включая hello (можно вызывать из любого потока)
+     */
+    qint64 bytes_sent() const;
+
+    /**
+     * @brief Возвращает количество байт, прочитанных из сокета
+     * @return Байт с кадрированием и сжатием (можно вызывать из любого потока)
+     */
+    qint64 bytes_received() const;
+
+    /**
+     * @brief Возвращает счётчики сжатия соединения
+     * @return Копия счётчиков (можно вызывать из любого потока)
+     */
+    compression_stats compression_counters() const;
+
+    /**
+     * @brief Передаёт сообщения сетевому потоку
+     * @param messages Сообщения без кадрирования
+     * @param priority Полоса очереди отправки
+     *
+     * Можно вызывать из любого потока. Сообщения отправляются одной
+     * командой очереди событий, их размер сразу входит в backlog.
+     */
+    void post(const QByteArrayList& messages, send_priority priority = send_priority::BULK);
+
+    /**
+     * @brief Задаёт пороги неотправленных данных
+     * @param high Верхний порог, байт: при нём congested возвращает true
+     * @param low Нижний порог, байт: при нём испускается drained
+     *
+     * Можно вызывать из любого потока.
+     */
+    void set_watermarks(qint64 high, qint64 low);
+
+    /**
+     * @brief Возвращает объём неотправленных данных полосы
+     * @param priority Полоса
+     * @return Байт в очереди сетевого потока, в полосе и (для пакетной) в буфере записи сокета
+     */
+    qint64 backlog(send_priority priority) const;
+
+    /**
+     * @brief Проверяет, достиг ли объём неотправленных данных полосы верхнего порога
+     * @param priority Полоса
+     * @return true если отправку в полосу нужно приостановить
+     *
+     * При true сетевая часть испустит drained, когда объём опустится до
+     * нижнего порога. Можно вызывать из любого потока.
+     */
+    bool congested(send_priority priority);
+
+signals:
+    /**
+     * @brief Соединение установлено и возможности протокола согласованы
+     * @param features Согласованные возможности (для старого сервера - handshake())
+     */
+    void connected(const handshake& features);
+
+    /**
+     * @brief Соединение разорвано
+     */
+    void disconnected();
+
+    /**
+     * @brief Попытка подключения не удалась
+     */
+    void connection_failed();
+
+    /**
+     * @brief Получены сообщения от сервера
+     * @param messages Содержимое всех полных кадров, прочитанных за одно чтение
+     */
+    void messages_received(const QByteArrayList& messages);
+
+    /**
+     * @brief Объём неотправленных данных опустился до нижнего порога
+     *
+     * Испускается один раз после каждого congested, вернувшего true,
+     * а также при разрыве соединения.
+     */
+    void drained();
+
+private slots:
+    /**
+     * @brief Обработчик установки соединения
+     */
+    void on_connected();
+
+    /**
+     * @brief Обработчик разрыва соединения
+     */
+    void on_disconnected();
+
+    /**
+     * @brief Читает данные из сокета
+     */
+    void read();
+
+    /**
+     * @brief Обработчик ошибки сокета
+     */
+    void on_error();
+
+    /**
+     * @brief Обработчик передачи части буфера записи операционной системе
+     */
+    void on_bytes_written();
+
+private:
+    /**
+     * @brief Обрабатывает ответ сервера на hello
+     * @return true если согласование завершено, false если ответ ещё не получен полностью
+     */
+    bool finish_handshake();
+
+    /**
+     * @brief Завершает согласование и отправляет накопленные сообщения
+     * @param features Согласованные возможности
+     */
+    void apply_handshake(const handshake& features);
+
+    /**
+     * @brief Переносит кадры из полос в буфер записи сокета
+     */
+    void flush_outbound();
+
+    /**
+     * @brief Сжимает сообщение, если это согласовано и оно не короче порога
+     * @param message Сообщение
+     * @param packed Буфер для сжатого сообщения
+     * @return Ссылка на message или на packed
+     */
+    const QByteArray& pack(const QByteArray& message, QByteArray& packed);
+
+    /**
+     * @brief Распаковывает сжатое сообщение
+     * @param frame Содержимое кадра
+     * @param out Исходное сообщение
+     * @return false если кадр повреждён
+     */
+    bool unpack(QByteArrayView frame, QByteArray& out);
+
+    /**
+     * @brief Обновляет размеры полос и буфера записи в backlog и сообщает об освобождении
+     */
+    void update_backlog();
+
+    transport* socket = nullptr;        ///< Соединение с сервером
+    QTimer* negotiation_timer;          ///< Таймер ожидания ответа на согласование
+    frame_parser parser;                ///< Разборщик входящего потока
+    handshake offered;                  ///< Возможности, предлагаемые серверу
+    handshake agreed;                   ///< Согласованные возможности
+    bool negotiating = false;           ///< Идёт согласование возможностей
+    bool link_up = false;               ///< Соединение установлено (connected уже испущен)
+    QByteArrayList pending_writes;      ///< Сообщения, ожидающие окончания согласования
+    QByteArrayList lanes[lane_scheduler::lane_count]; ///< Кадры, ожидающие записи в сокет (по send_priority)
+    qint64 lane_bytes[lane_scheduler::lane_count] = {}; ///< Размер кадров в полосах
+    lane_scheduler scheduler;           ///< Выбор полосы для следующего кадра
+    bool flush_scheduled = false;       ///< Запись кадров из полос запланирована
+    bool coalesce_writes = true;        ///< Склеивать записи одной итерации цикла событий
+    socket_options options;             ///< Параметры сокета
+    qint64 writes = 0;                  ///< Количество записей в сокет
+    qsizetype compression_threshold = frame_compression::default_threshold; ///< Минимальный размер сжимаемого сообщения
+    mutable QMutex stats_lock;          ///< Защита stats (читается из потока интерфейса)
+    compression_stats stats;            ///< Счётчики сжатия
+    std::atomic<qint64> posted[lane_scheduler::lane_count] = {}; ///< Байт в командах post, ещё не обработанных сетевым потоком
+    std::atomic<qint64> queued[lane_scheduler::lane_count] = {}; ///< Копия lane_bytes для других потоков
+    std::atomic<qint64> buffered{0};    ///< Байт в буфере записи сокета
+    std::atomic<qint64> sent_bytes{0};  ///< Байт, записанных в сокет за всё время
+    std::atomic<qint64> received_bytes{0}; ///< Байт, прочитанных из сокета за всё время
+    std::atomic<qint64> high_watermark{4 << 20}; ///< Верхний порог backlog полосы, байт
+    std::atomic<qint64> low_watermark{1 << 20};  ///< Нижний порог backlog полосы, байт
+    std::atomic<bool> drain_wanted[lane_scheduler::lane_count] = {}; ///< После congested ожидается сигнал drained
+};
+
+#endif // NETWORK_WORKER_H
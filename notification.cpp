@@ -1,5 +1,6 @@
 #include "notification.h"
 #include "ui_notification.h"
+#include "logger.h"
 #include <QTimer>
 
 /**
@@ -36,7 +37,7 @@ notification::notification(QString title, QString text, QWidget *parent) :
  */
 notification::~notification()
 {
-    qDebug() << "Вызван деструктор уведомления";
+    LOG_DEBUG("ui", "Вызван деструктор уведомления");
     delete ui;
 }
 
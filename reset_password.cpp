@@ -1,6 +1,7 @@
 #include "reg_form.h"
 #include "ui_reg_form.h"
 #include "clients_func.h"
+#include "logger.h"
 #include <QMessageBox>
 #include "notification.h"
 #include "auth_form.h"
@@ -61,7 +62,7 @@ Widget::~Widget()
     disconnect(this->client, &Client::register_ok, this, &Widget::register_successful);
     disconnect(this->client, &Client::register_error, this, &Widget::register_error);
 
-    qDebug() << "Вызвался деструктор окна регистрации";
+    LOG_DEBUG("ui", "Вызвался деструктор окна регистрации");
     delete ui;
 }
 
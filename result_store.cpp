@@ -0,0 +1,395 @@
+#include "result_store.h"
+#include <QSaveFile>
+#include <QByteArray>
+#include <QList>
+#include <QLocale>
+#include <QStringList>
+#include <atomic>
+#include <cstddef>
+#include <cstring>
+
+/// Версия формата файла хранилища
+#define RESULT_STORE_VERSION 2
+/// Максимальная доля занятых ячеек, после которой таблица увеличивается
+#define RESULT_STORE_MAX_LOAD 0.7
+
+/// Состояния ответа в ячейке (как в binary_codec)
+#define STATUS_ROOTS 0
+#define STATUS_NO_SOLUTION 1
+#define STATUS_INFINITY_SOLUTIONS 2
+
+/**
+ * @brief Заголовок файла хранилища (64 байта)
+ *
+ * Числа хранятся в порядке байт платформы.
+ */
+struct result_store::header {
+    char magic[4];     ///< Сигнатура "EQRS"
+    quint32 version;   ///< Версия формата
+    quint32 capacity;  ///< Количество ячеек (степень двойки)
+    quint32 count;     ///< Количество занятых ячеек
+    char reserved[48]; ///< Зарезервировано
+};
+
+/**
+ * @brief Ячейка хеш-таблицы (64 байта)
+ *
+ * Ответ хранится состоянием и корнями, а не текстом, поэтому его
+ * размер не зависит от количества знаков в корнях.
+ */
+struct result_store::slot {
+    quint64 hash;       ///< Хеш нормализованного уравнения
+    double p;           ///< Коэффициент p ключа
+    double q;           ///< Коэффициент q ключа
+    double roots[2];    ///< Корни (для состояния STATUS_ROOTS)
+    quint32 checksum;   ///< Контрольная сумма ячейки (без полей checksum и state)
+    quint8 kind;        ///< Вид ключа
+    quint8 status;      ///< Состояние ответа
+    quint8 count;       ///< Количество корней
+    quint8 state;       ///< 0 - ячейка пуста, 1 - занята
+    char reserved[16];  ///< Зарезервировано
+};
+
+/**
+ * @brief Проверяет совпадение ключа с ключом ячейки
+ * @param cell Ячейка
+ * @param hash Хеш ключа
+ * @param value Ключ
+ * @return true если ключи совпадают
+ */
+template<typename slot_type>
+static bool same_key(const slot_type& cell, quint64 hash, const answer_cache::key& value) {
+    return cell.hash == hash and cell.kind == value.kind and cell.p == value.p and cell.q == value.q;
+}
+
+/**
+ * @brief Записывает ответ в ячейку
+ * @param answer Ответ в формате сервера
+ * @param cell Ячейка
+ * @return false если ответ не является решением ("error" и прочее)
+ */
+template<typename slot_type>
+static bool store_answer(const QString& answer, slot_type& cell) {
+    if (answer == "no_solution") {
+        cell.status = STATUS_NO_SOLUTION;
+        return true;
+    }
+    if (answer == "infinity_solutions") {
+        cell.status = STATUS_INFINITY_SOLUTIONS;
+        return true;
+    }
+
+    QStringList parts = answer.split('$');
+    bool valid = !answer.isEmpty() and parts.size() <= 2;
+    for (qsizetype i = 0; valid and i < parts.size(); i++)
+        cell.roots[i] = parts[i].toDouble(&valid);
+    cell.status = STATUS_ROOTS;
+    cell.count = quint8(parts.size());
+    return valid;
+}
+
+/**
+ * @brief Формирует ответ из ячейки
+ * @param cell Ячейка
+ * @return Ответ в формате сервера; корни - в кратчайшем точном представлении
+ */
+template<typename slot_type>
+static QString load_answer(const slot_type& cell) {
+    if (cell.status == STATUS_NO_SOLUTION)
+        return "no_solution";
+    if (cell.status == STATUS_INFINITY_SOLUTIONS)
+        return "infinity_solutions";
+
+    QString answer;
+    for (int i = 0; i < cell.count; i++) {
+        if (i != 0)
+            answer += '$';
+        answer += QString::number(cell.roots[i], 'g', QLocale::FloatingPointShortest);
+    }
+    return answer;
+}
+
+/**
+ * @brief Конструктор хранилища
+ * @param path Путь к файлу хранилища
+ * @param capacity Начальное количество ячеек (степень двойки)
+ */
+result_store::result_store(const QString& path, quint32 capacity) :
+    path(path),
+    initial_capacity(capacity)
+{
+    static_assert(sizeof(header) == 64, "header must be 64 bytes");
+    static_assert(sizeof(slot) == 64, "slot must be 64 bytes");
+}
+
+/**
+ * @brief Деструктор: снимает отображение файла
+ */
+result_store::~result_store() {
+    this->unmap();
+}
+
+/**
+ * @brief Открывает или создаёт файл хранилища
+ * @return true если хранилище готово к работе
+ */
+bool result_store::open() {
+    this->unmap();
+    this->file.setFileName(this->path);
+    if (this->file.exists() and this->file.open(QIODevice::ReadWrite) and this->map())
+        return true;
+    return this->create(this->initial_capacity);
+}
+
+/**
+ * @brief Проверяет, открыто ли хранилище
+ * @return true если файл отображён в память
+ */
+bool result_store::is_open() const {
+    return this->memory != nullptr;
+}
+
+/**
+ * @brief Вычисляет хеш нормализованного уравнения
+ * @param value Ключ
+ * @return Хеш (splitmix64 по битовому представлению коэффициентов)
+ */
+quint64 result_store::hash_key(const answer_cache::key& value) {
+    auto mix = [](quint64 x) {
+        x += 0x9E3779B97F4A7C15ULL;
+        x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+        return x ^ (x >> 31);
+    };
+    quint64 p_bits = 0;
+    quint64 q_bits = 0;
+    std::memcpy(&p_bits, &value.p, sizeof(p_bits));
+    std::memcpy(&q_bits, &value.q, sizeof(q_bits));
+    return mix(mix(mix(value.kind) ^ p_bits) ^ q_bits);
+}
+
+/**
+ * @brief Вычисляет контрольную сумму содержимого ячейки
+ * @param cell Ячейка
+ * @return Контрольная сумма FNV-1a
+ */
+quint32 result_store::checksum(const slot& cell) {
+    slot copy = cell;
+    copy.checksum = 0;
+    copy.state = 0;
+    const uchar* bytes = reinterpret_cast<const uchar*>(&copy);
+    quint32 sum = 2166136261u;
+    for (size_t i = 0; i < sizeof(copy); i++) {
+        sum ^= bytes[i];
+        sum *= 16777619u;
+    }
+    return sum;
+}
+
+/**
+ * @brief Создаёт пустой файл хранилища
+ * @param slots Количество ячеек
+ * @return true если файл создан и отображён
+ */
+bool result_store::create(quint32 slots) {
+    this->unmap();
+    if (!this->file.open(QIODevice::ReadWrite | QIODevice::Truncate))
+        return false;
+    if (!this->file.resize(sizeof(header) + qint64(slots) * sizeof(slot))) {
+        this->file.close();
+        return false;
+    }
+    this->memory = this->file.map(0, this->file.size());
+    if (this->memory == nullptr) {
+        this->file.close();
+        return false;
+    }
+
+    header* head = reinterpret_cast<header*>(this->memory);
+    std::memcpy(head->magic, "EQRS", sizeof(head->magic));
+    head->version = RESULT_STORE_VERSION;
+    head->capacity = slots;
+    head->count = 0;
+    return true;
+}
+
+/**
+ * @brief Отображает открытый файл в память и проверяет заголовок
+ * @return true если заголовок корректен
+ */
+bool result_store::map() {
+    if (this->file.size() < qint64(sizeof(header)))
+        return false;
+    this->memory = this->file.map(0, this->file.size());
+    if (this->memory == nullptr)
+        return false;
+
+    const header* head = reinterpret_cast<const header*>(this->memory);
+    bool valid = std::memcmp(head->magic, "EQRS", sizeof(head->magic)) == 0 and
+                 head->version == RESULT_STORE_VERSION and
+                 head->capacity != 0 and (head->capacity & (head->capacity - 1)) == 0 and
+                 this->file.size() == qint64(sizeof(header)) + qint64(head->capacity) * qint64(sizeof(slot));
+    if (!valid) {
+        this->unmap();
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Снимает отображение и закрывает файл
+ */
+void result_store::unmap() {
+    if (this->memory != nullptr) {
+        this->file.unmap(this->memory);
+        this->memory = nullptr;
+    }
+    this->file.close();
+}
+
+/**
+ * @brief Возвращает ячейки таблицы
+ * @return Указатель на первую ячейку
+ */
+result_store::slot* result_store::slots() const {
+    return reinterpret_cast<slot*>(this->memory + sizeof(header));
+}
+
+/**
+ * @brief Возвращает количество записей
+ * @return Количество занятых ячеек
+ */
+quint32 result_store::size() const {
+    return this->memory == nullptr ? 0 : reinterpret_cast<const header*>(this->memory)->count;
+}
+
+/**
+ * @brief Возвращает количество ячеек
+ * @return Ёмкость таблицы
+ */
+quint32 result_store::capacity() const {
+    return this->memory == nullptr ? 0 : reinterpret_cast<const header*>(this->memory)->capacity;
+}
+
+/**
+ * @brief Ищет ответ на уравнение
+ * @param equation Уравнение
+ * @param answer Найденный ответ
+ * @return true если ответ найден
+ *
+ * Ячейки с неверной контрольной суммой пропускаются, но не прерывают
+ * последовательность проб.
+ */
+bool result_store::lookup(const equation_request& equation, QString& answer) const {
+    if (this->memory == nullptr)
+        return false;
+
+    answer_cache::key value = answer_cache::normalize(equation);
+    quint64 hash = result_store::hash_key(value);
+    quint32 mask = this->capacity() - 1;
+    const slot* table = this->slots();
+
+    for (quint32 probe = 0, i = hash & mask; probe <= mask; probe++, i = (i + 1) & mask) {
+        const slot& cell = table[i];
+        if (cell.state == 0)
+            return false;
+        if (same_key(cell, hash, value) and cell.checksum == result_store::checksum(cell)) {
+            answer = load_answer(cell);
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Сохраняет ответ на уравнение
+ * @param equation Уравнение
+ * @param answer Ответ в формате сервера
+ * @return true если ответ записан
+ *
+ * Сначала записывается содержимое ячейки и контрольная сумма, затем
+ * (после барьера памяти) признак занятости.
+ */
+bool result_store::insert(const equation_request& equation, const QString& answer) {
+    slot filled = {};
+    if (this->memory == nullptr or !store_answer(answer, filled))
+        return false;
+
+    if (this->size() + 1 > this->capacity() * RESULT_STORE_MAX_LOAD and !this->compact(this->capacity() * 2))
+        return false;
+
+    answer_cache::key value = answer_cache::normalize(equation);
+    quint64 hash = result_store::hash_key(value);
+    quint32 mask = this->capacity() - 1;
+    slot* table = this->slots();
+
+    for (quint32 probe = 0, i = hash & mask; probe <= mask; probe++, i = (i + 1) & mask) {
+        slot& cell = table[i];
+        bool empty = cell.state == 0;
+        if (!empty and !same_key(cell, hash, value))
+            continue;
+
+        filled.hash = hash;
+        filled.p = value.p;
+        filled.q = value.q;
+        filled.kind = value.kind;
+        filled.checksum = result_store::checksum(filled);
+
+        // Содержимое публикуется раньше признака занятости
+        std::memcpy(&cell, &filled, offsetof(slot, state));
+        std::atomic_thread_fence(std::memory_order_release);
+        if (empty) {
+            cell.state = 1;
+            reinterpret_cast<header*>(this->memory)->count++;
+        }
+        return true;
+    }
+    return false;
+}
+
+/**
+ * @brief Уплотняет хранилище
+ * @param capacity Новое количество ячеек (0 - подобрать по количеству записей)
+ * @return true если уплотнение выполнено
+ */
+bool result_store::compact(quint32 capacity) {
+    if (this->memory == nullptr)
+        return false;
+
+    // Собираем целые записи
+    QList<slot> live;
+    const slot* table = this->slots();
+    for (quint32 i = 0; i < this->capacity(); i++) {
+        if (table[i].state == 1 and table[i].checksum == result_store::checksum(table[i]))
+            live.append(table[i]);
+    }
+
+    quint32 slots = 1024;
+    while (slots < capacity or slots * RESULT_STORE_MAX_LOAD / 2 < live.size())
+        slots *= 2;
+
+    QByteArray image(sizeof(header) + qsizetype(slots) * sizeof(slot), '\0');
+    header* head = reinterpret_cast<header*>(image.data());
+    std::memcpy(head->magic, "EQRS", sizeof(head->magic));
+    head->version = RESULT_STORE_VERSION;
+    head->capacity = slots;
+    head->count = quint32(live.size());
+
+    slot* rebuilt = reinterpret_cast<slot*>(image.data() + sizeof(header));
+    for (const slot& cell : std::as_const(live)) {
+        quint32 i = cell.hash & (slots - 1);
+        while (rebuilt[i].state != 0)
+            i = (i + 1) & (slots - 1);
+        rebuilt[i] = cell;
+    }
+
+    // Старый файл закрывается до атомарной замены
+    this->unmap();
+    QSaveFile output(this->path);
+    bool written = output.open(QIODevice::WriteOnly) and
+                   output.write(image) == image.size() and
+                   output.commit();
+
+    this->file.setFileName(this->path);
+    return this->file.open(QIODevice::ReadWrite) and this->map() and written;
+}
@@ -0,0 +1,140 @@
+#ifndef RESULT_STORE_H
+#define RESULT_STORE_H
+
+#include <QFile>
+#include <QString>
+#include "answer_cache.h"
+
+/**
+ * @brief Постоянное хранилище ответов в отображаемом в память файле
+ *
+ * Хеш-таблица с открытой адресацией прямо в файле: при запуске файл
+ * только отображается в память (QFile::map), разбор не требуется.
+ * Ключ - нормализованное уравнение (answer_cache::normalize).
+ * Запись ячейки завершается контрольной суммой, поэтому ячейка,
+ * запись которой прервалась аварийным завершением, считается пустой.
+ */
+class result_store
+{
+public:
+    static constexpr const char* default_path = "cache/results.bin"; ///< Файл рядом с cache/auth_data.json
+
+    /**
+     * @brief Конструктор хранилища
+     * @param path Путь к файлу хранилища
+     * @param capacity Начальное количество ячеек (степень двойки)
+     */
+    explicit result_store(const QString& path, quint32 capacity = 1 << 16);
+
+    /**
+     * @brief Деструктор: снимает отображение файла
+     */
+    ~result_store();
+
+    result_store(const result_store&) = delete;
+    result_store& operator=(const result_store&) = delete;
+
+    /**
+     * @brief Открывает или создаёт файл хранилища
+     * @return true если хранилище готово к работе
+     *
+     * Файл с неверным заголовком пересоздаётся.
+     */
+    bool open();
+
+    /**
+     * @brief Проверяет, открыто ли хранилище
+     * @return true если файл отображён в память
+     */
+    bool is_open() const;
+
+    /**
+     * @brief Ищет ответ на уравнение
+     * @param equation Уравнение
+     * @param answer Найденный ответ
+     * @return true если ответ найден
+     */
+    bool lookup(const equation_request& equation, QString& answer) const;
+
+    /**
+     * @brief Сохраняет ответ на уравнение
+     * @param equation Уравнение
+     * @param answer Ответ в формате сервера
+     * @return true если ответ записан (false - ответ не является решением)
+     *
+     * При заполнении таблицы больше чем на 70% выполняется уплотнение
+     * с увеличением ёмкости вдвое.
+     */
+    bool insert(const equation_request& equation, const QString& answer);
+
+    /**
+     * @brief Уплотняет хранилище
+     * @param capacity Новое количество ячеек (0 - подобрать по количеству записей)
+     * @return true если уплотнение выполнено
+     *
+     * Переписывает файл, оставляя только целые записи. Новый файл
+     * записывается рядом и атомарно заменяет старый (QSaveFile).
+     */
+    bool compact(quint32 capacity = 0);
+
+    /**
+     * @brief Возвращает количество записей
+     * @return Количество занятых ячеек
+     */
+    quint32 size() const;
+
+    /**
+     * @brief Возвращает количество ячеек
+     * @return Ёмкость таблицы
+     */
+    quint32 capacity() const;
+
+private:
+    struct header;
+    struct slot;
+
+    /**
+     * @brief Вычисляет хеш нормализованного уравнения
+     * @param value Ключ
+     * @return Хеш, одинаковый на всех платформах и при каждом запуске
+     */
+    static quint64 hash_key(const answer_cache::key& value);
+
+    /**
+     * @brief Вычисляет контрольную сумму содержимого ячейки
+     * @param cell Ячейка
+     * @return Контрольная сумма
+     */
+    static quint32 checksum(const slot& cell);
+
+    /**
+     * @brief Создаёт пустой файл хранилища
+     * @param slots Количество ячеек
+     * @return true если файл создан и отображён
+     */
+    bool create(quint32 slots);
+
+    /**
+     * @brief Отображает открытый файл в память и проверяет заголовок
+     * @return true если заголовок корректен
+     */
+    bool map();
+
+    /**
+     * @brief Снимает отображение и закрывает файл
+     */
+    void unmap();
+
+    /**
+     * @brief Возвращает ячейки таблицы
+     * @return Указатель на первую ячейку
+     */
+    slot* slots() const;
+
+    QString path;                ///< Путь к файлу хранилища
+    quint32 initial_capacity;    ///< Ёмкость нового файла
+    QFile file;                  ///< Файл хранилища
+    uchar* memory = nullptr;     ///< Отображение файла в память
+};
+
+#endif // RESULT_STORE_H
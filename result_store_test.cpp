@@ -0,0 +1,136 @@
+#include "result_store.h"
+#include <QCoreApplication>
+#include <QFile>
+#include <QTemporaryDir>
+#include <cstdio>
+
+/// Размер заголовка и ячейки файла хранилища (result_store::header, result_store::slot)
+#define HEADER_SIZE 64
+#define SLOT_SIZE 64
+/// Смещения полей в ячейке: первый корень, контрольная сумма, признак занятости
+#define SLOT_ROOTS_OFFSET 24
+#define SLOT_CHECKSUM_OFFSET 40
+#define SLOT_STATE_OFFSET 47
+
+/**
+ * @file result_store_test.cpp
+ * @brief Проверка хранилища ответов result_store
+ *
+ * Запуск: result_store_test. Код возврата 0 - все проверки пройдены.
+ */
+
+/**
+ * @brief Проверяет условие и выводит результат
+ * @param passed Условие
+ * @param label Название проверки
+ * @return Условие
+ */
+static bool check(bool passed, const char* label) {
+    std::printf("%-48s %s\n", label, passed ? "ok" : "FAIL");
+    return passed;
+}
+
+/**
+ * @brief Портит занятые ячейки файла хранилища, как прерванная запись
+ * @param path Путь к закрытому файлу хранилища
+ * @param capacity Количество ячеек
+ * @return Количество испорченных ячеек
+ *
+ * В первой занятой ячейке меняется байт корня, во второй - байт
+ * контрольной суммы; признак занятости остаётся.
+ */
+static int damage_slots(const QString& path, quint32 capacity) {
+    QFile file(path);
+    if (!file.open(QIODevice::ReadWrite))
+        return 0;
+    int damaged = 0;
+    for (quint32 i = 0; i < capacity and damaged < 2; i++) {
+        qint64 start = HEADER_SIZE + qint64(i) * SLOT_SIZE;
+        file.seek(start + SLOT_STATE_OFFSET);
+        char state = 0;
+        if (!file.getChar(&state) or state != 1)
+            continue;
+        qint64 offset = start + (damaged == 0 ? SLOT_ROOTS_OFFSET : SLOT_CHECKSUM_OFFSET);
+        file.seek(offset);
+        char byte = 0;
+        file.getChar(&byte);
+        file.seek(offset);
+        file.putChar(char(byte ^ 0x5A));
+        damaged++;
+    }
+    return damaged;
+}
+
+/**
+ * @brief Точка входа
+ * @param argc Количество аргументов командной строки
+ * @param argv Аргументы командной строки
+ * @return 0 если все проверки пройдены
+ */
+int main(int argc, char *argv[])
+{
+    QCoreApplication a(argc, argv);
+    QTemporaryDir directory;
+    QString path = directory.filePath("results.bin");
+    bool passed = true;
+
+    // Корни с полной точностью занимают 40 символов
+    const QString long_answer = "-0.29289321881345254$-1.7071067811865475";
+    equation_request long_equation = equation_request::quadratic(2, 4, 1);
+    equation_request short_equation = equation_request::quadratic(1, -5, 6);
+    equation_request empty_equation = equation_request::quadratic(1, 0, 1);
+    {
+        result_store store(path);
+        passed &= check(store.open(), "open");
+        passed &= check(store.insert(long_equation, long_answer), "insert long answer");
+        passed &= check(store.insert(short_equation, "2$3"), "insert short answer");
+        passed &= check(store.insert(empty_equation, "no_solution"), "insert no_solution");
+        passed &= check(!store.insert(equation_request::quadratic(0, 0, 1), "error"), "reject error");
+
+        QString answer;
+        passed &= check(store.lookup(long_equation, answer) and answer == long_answer, "lookup long answer");
+    }
+
+    {
+        result_store reopened(path);
+        QString answer;
+        passed &= check(reopened.open() and reopened.size() == 3, "reopen");
+        passed &= check(reopened.lookup(long_equation, answer) and answer == long_answer,
+                        "lookup long answer after reopen");
+        passed &= check(reopened.lookup(short_equation, answer) and answer == "2$3", "lookup short answer");
+        passed &= check(reopened.lookup(empty_equation, answer) and answer == "no_solution", "lookup no_solution");
+        passed &= check(!reopened.lookup(equation_request::quadratic(1, 2, 3), answer), "lookup missing");
+        passed &= check(reopened.compact() and reopened.size() == 3, "compact");
+        passed &= check(reopened.lookup(short_equation, answer) and answer == "2$3", "lookup after compact");
+    }
+    {
+        result_store compacted(path);
+        QString answer;
+        passed &= check(compacted.open() and compacted.size() == 3, "reopen after compact");
+        passed &= check(compacted.lookup(long_equation, answer) and answer == long_answer,
+                        "lookup long answer after compact");
+        passed &= check(compacted.lookup(empty_equation, answer) and answer == "no_solution",
+                        "lookup no_solution after compact");
+    }
+
+    // Ячейки с повреждённым содержимым не возвращаются и отбрасываются уплотнением
+    const quint32 small_capacity = 16;
+    QString damaged_path = directory.filePath("damaged.bin");
+    {
+        result_store store(damaged_path, small_capacity);
+        passed &= check(store.open() and store.insert(long_equation, long_answer)
+                        and store.insert(short_equation, "2$3"), "insert before damage");
+    }
+    passed &= check(damage_slots(damaged_path, small_capacity) == 2, "damage slots on disk");
+    {
+        result_store damaged(damaged_path, small_capacity);
+        QString answer;
+        passed &= check(damaged.open(), "reopen damaged");
+        passed &= check(!damaged.lookup(long_equation, answer) and !damaged.lookup(short_equation, answer),
+                        "reject damaged slots");
+        passed &= check(damaged.insert(empty_equation, "no_solution") and damaged.lookup(empty_equation, answer)
+                        and answer == "no_solution", "insert next to damaged slots");
+        passed &= check(damaged.compact() and damaged.size() == 1, "compact drops damaged slots");
+    }
+    return passed ? 0 : 1;
+}
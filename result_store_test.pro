@@ -0,0 +1,27 @@
+QT = core
+
+CONFIG += c++17 console
+CONFIG -= app_bundle
+
+TARGET = result_store_test
+
+CONFIG -=debug_and_release
+CONFIG += release
+
+DESTDIR = $$PWD/build
+
+OBJECTS_DIR = ./build/result_store_test/obj
+MOC_DIR = ./build/result_store_test/moc
+
+INCLUDEPATH = "$$PWD/include"
+
+SOURCES += \
+    $$PWD/src/answer_cache.cpp \
+    $$PWD/src/equation.cpp \
+    $$PWD/src/result_store.cpp \
+    $$PWD/src/result_store_test.cpp
+
+HEADERS += \
+    $$PWD/include/answer_cache.h \
+    $$PWD/include/equation.h \
+    $$PWD/include/result_store.h
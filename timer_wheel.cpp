@@ -0,0 +1,119 @@
+#include "timer_wheel.h"
+#include <algorithm>
+
+/**
+ * @brief Конструктор пустого колеса
+ * @param tick_ms Длина такта, мс
+ * @param slot_count Количество ячеек
+ */
+timer_wheel::timer_wheel(int tick_ms, int slot_count) :
+    slots(std::size_t(qMax(1, slot_count))),
+    tick_ms(qMax(1, tick_ms))
+{}
+
+/**
+ * @brief Возвращает ячейку такта
+ * @param tick_number Номер такта
+ * @return Ячейка колеса
+ */
+std::vector<timer_wheel::entry>& timer_wheel::slot(qint64 tick_number) {
+    return this->slots[std::size_t(tick_number % qint64(this->slots.size()))];
+}
+
+/**
+ * @brief Возвращает такт, к концу которого срок истекает
+ * @param deadline_ms Момент истечения, мс
+ * @return Номер такта (округление вверх)
+ *
+ * Поэтому при обработке ячейки текущего такта в ней остаются только
+ * сроки следующих оборотов.
+ */
+qint64 timer_wheel::tick_of(qint64 deadline_ms) const {
+    return (qMax<qint64>(0, deadline_ms) + this->tick_ms - 1) / this->tick_ms;
+}
+
+/**
+ * @brief Добавляет срок
+ * @param id Идентификатор запроса
+ * @param deadline_ms Момент истечения по часам владельца, мс
+ *
+ * Срок, попадающий в уже обработанный такт, откладывается до
+ * следующего, чтобы он не ждал полного оборота колеса.
+ */
+void timer_wheel::schedule(quint32 id, qint64 deadline_ms) {
+    qint64 tick_number = qMax(this->tick_of(deadline_ms), this->current + 1);
+    this->slot(tick_number).push_back(entry{id, deadline_ms});
+    this->count++;
+}
+
+/**
+ * @brief Удаляет срок, если он ещё не истёк
+ * @param id Идентификатор запроса
+ * @param deadline_ms Момент истечения, переданный в schedule
+ *
+ * Срок ищется только в своей ячейке, поэтому удаление не просматривает
+ * остальные сроки. Отложенный в schedule срок ищется и в ячейке
+ * следующего такта.
+ */
+void timer_wheel::remove(quint32 id, qint64 deadline_ms) {
+    auto matches = [id, deadline_ms](const entry& item) {
+        return item.id == id and item.deadline_ms == deadline_ms;
+    };
+    qint64 tick_number = this->tick_of(deadline_ms);
+    for (qint64 candidate : {tick_number, this->current + 1}) {
+        std::vector<entry>& cell = this->slot(qMax<qint64>(0, candidate));
+        auto found = std::find_if(cell.begin(), cell.end(), matches);
+        if (found != cell.end()) {
+            *found = cell.back();
+            cell.pop_back();
+            this->count--;
+            return;
+        }
+    }
+}
+
+/**
+ * @brief Извлекает истёкшие сроки
+ * @param now_ms Текущий момент по часам владельца, мс
+ * @return Идентификаторы запросов, срок которых не позже now_ms
+ *
+ * Просматриваются ячейки тактов, прошедших с прошлого вызова (не больше
+ * одного оборота); сроки следующих оборотов остаются на месте.
+ */
+QList<quint32> timer_wheel::expire(qint64 now_ms) {
+    QList<quint32> expired;
+    qint64 now_tick = now_ms / this->tick_ms;
+    qint64 first = qMax(this->current + 1, now_tick - qint64(this->slots.size()) + 1);
+
+    for (qint64 tick_number = first; tick_number <= now_tick and this->count > 0; tick_number++) {
+        std::vector<entry>& cell = this->slot(tick_number);
+        for (std::size_t i = 0; i < cell.size();) {
+            if (cell[i].deadline_ms > now_ms) {
+                i++;
+                continue;
+            }
+            expired.append(cell[i].id);
+            cell[i] = cell.back();
+            cell.pop_back();
+            this->count--;
+        }
+    }
+    this->current = qMax(this->current, now_tick);
+    return expired;
+}
+
+/**
+ * @brief Возвращает количество ожидающих сроков
+ * @return Количество сроков
+ */
+qsizetype timer_wheel::size() const {
+    return this->count;
+}
+
+/**
+ * @brief Возвращает длину такта
+ * @return Длина такта, мс
+ */
+int timer_wheel::tick() const {
+    return this->tick_ms;
+}
@@ -0,0 +1,93 @@
+#ifndef TIMER_WHEEL_H
+#define TIMER_WHEEL_H
+
+#include <QList>
+#include <QtGlobal>
+#include <vector>
+
+/**
+ * @brief Колесо таймеров для сроков ожидания запросов
+ *
+ * Время делится на такты длиной tick_ms; колесо из slot_count ячеек
+ * хранит в ячейке такта сроки, истекающие в этот такт (сроки дальше
+ * одного оборота ждут в той же ячейке следующего оборота). Добавление
+ * и удаление срока не зависят от количества ожидающих запросов, а
+ * всеми сроками управляет один периодический таймер владельца, который
+ * вызывает expire.
+ */
+class timer_wheel
+{
+public:
+    static constexpr int default_tick_ms = 50;     ///< Длина такта по умолчанию, мс
+    static constexpr int default_slot_count = 256; ///< Количество ячеек по умолчанию
+
+    /**
+     * @brief Конструктор пустого колеса
+     * @param tick_ms Длина такта (точность срабатывания), мс
+     * @param slot_count Количество ячеек
+     */
+    explicit timer_wheel(int tick_ms = default_tick_ms, int slot_count = default_slot_count);
+
+    /**
+     * @brief Добавляет срок
+     * @param id Идентификатор запроса
+     * @param deadline_ms Момент истечения по часам владельца, мс
+     */
+    void schedule(quint32 id, qint64 deadline_ms);
+
+    /**
+     * @brief Удаляет срок, если он ещё не истёк
+     * @param id Идентификатор запроса
+     * @param deadline_ms Момент истечения, переданный в schedule
+     */
+    void remove(quint32 id, qint64 deadline_ms);
+
+    /**
+     * @brief Извлекает истёкшие сроки
+     * @param now_ms Текущий момент по часам владельца, мс
+     * @return Идентификаторы запросов, срок которых не позже now_ms
+     */
+    QList<quint32> expire(qint64 now_ms);
+
+    /**
+     * @brief Возвращает количество ожидающих сроков
+     * @return Количество сроков
+     */
+    qsizetype size() const;
+
+    /**
+     * @brief Возвращает длину такта
+     * @return Длина такта, мс
+     */
+    int tick() const;
+
+private:
+    /**
+     * @brief Срок одного запроса
+     */
+    struct entry {
+        quint32 id;         ///< Идентификатор запроса
+        qint64 deadline_ms; ///< Момент истечения
+    };
+
+    /**
+     * @brief Возвращает такт, к концу которого срок истекает
+     * @param deadline_ms Момент истечения, мс
+     * @return Номер такта (округление вверх)
+     */
+    qint64 tick_of(qint64 deadline_ms) const;
+
+    /**
+     * @brief Возвращает ячейку такта
+     * @param tick_number Номер такта
+     * @return Ячейка колеса
+     */
+    std::vector<entry>& slot(qint64 tick_number);
+
+    std::vector<std::vector<entry>> slots; ///< Ячейки колеса
+    int tick_ms;                           ///< Длина такта, мс
+    qint64 current = -1;                   ///< Последний обработанный такт (-1 - ещё не обрабатывались)
+    qsizetype count = 0;                   ///< Количество ожидающих сроков
+};
+
+#endif // TIMER_WHEEL_H
@@ -0,0 +1,61 @@
+#include "token_bucket.h"
+#include <cmath>
+
+/**
+ * @brief Задаёт скорость и размер корзины
+ * @param rate Маркеров в секунду (0 - без ограничения)
+ * @param burst Наибольшее количество накопленных маркеров
+ */
+void token_bucket::configure(double rate, int burst) {
+    this->rate = qMax(0.0, rate);
+    this->burst = qMax(1, burst);
+    this->tokens = this->burst;
+    this->last_ns = -1;
+}
+
+/**
+ * @brief Проверяет, задано ли ограничение
+ * @return true если скорость больше нуля
+ */
+bool token_bucket::is_limited() const {
+    return this->rate > 0;
+}
+
+/**
+ * @brief Добавляет маркеры, накопившиеся с прошлого пополнения
+ * @param now_ns Текущий момент, нс
+ */
+void token_bucket::refill(qint64 now_ns) {
+    if (this->last_ns >= 0 and now_ns > this->last_ns)
+        this->tokens = qMin(this->burst, this->tokens + (now_ns - this->last_ns) * this->rate / 1e9);
+    this->last_ns = qMax(this->last_ns, now_ns);
+}
+
+/**
+ * @brief Забирает маркер, если он есть
+ * @param now_ns Текущий момент по часам владельца, нс
+ * @return true если отправка разрешена
+ */
+bool token_bucket::take(qint64 now_ns) {
+    if (!this->is_limited())
+        return true;
+    this->refill(now_ns);
+    if (this->tokens < 1)
+        return false;
+    this->tokens -= 1;
+    return true;
+}
+
+/**
+ * @brief Возвращает время до появления следующего маркера
+ * @param now_ns Текущий момент по часам владельца, нс
+ * @return Время ожидания, нс (0 - маркер уже есть)
+ */
+qint64 token_bucket::wait_ns(qint64 now_ns) {
+    if (!this->is_limited())
+        return 0;
+    this->refill(now_ns);
+    if (this->tokens >= 1)
+        return 0;
+    return qint64(std::ceil((1 - this->tokens) * 1e9 / this->rate));
+}
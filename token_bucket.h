@@ -0,0 +1,65 @@
+#ifndef TOKEN_BUCKET_H
+#define TOKEN_BUCKET_H
+
+#include <QtGlobal>
+
+/**
+ * @brief Ограничитель частоты «корзина маркеров»
+ *
+ * Маркеры пополняются с постоянной скоростью rate в секунду, но их не
+ * может накопиться больше burst. Каждая отправка забирает один маркер,
+ * поэтому в среднем отправляется не больше rate сообщений в секунду, а
+ * после простоя - пачка не больше burst. Время передаётся владельцем
+ * (часы QElapsedTimer), поэтому корзина не обращается к системным часам.
+ */
+class token_bucket
+{
+public:
+    /**
+     * @brief Конструктор корзины без ограничения
+     */
+    token_bucket() = default;
+
+    /**
+     * @brief Задаёт скорость и размер корзины
+     * @param rate Маркеров в секунду (0 - без ограничения)
+     * @param burst Наибольшее количество накопленных маркеров (не меньше 1)
+     *
+     * Корзина наполняется полностью.
+     */
+    void configure(double rate, int burst);
+
+    /**
+     * @brief Проверяет, задано ли ограничение
+     * @return true если скорость больше нуля
+     */
+    bool is_limited() const;
+
+    /**
+     * @brief Забирает маркер, если он есть
+     * @param now_ns Текущий момент по часам владельца, нс
+     * @return true если отправка разрешена
+     */
+    bool take(qint64 now_ns);
+
+    /**
+     * @brief Возвращает время до появления следующего маркера
+     * @param now_ns Текущий момент по часам владельца, нс
+     * @return Время ожидания, нс (0 - маркер уже есть)
+     */
+    qint64 wait_ns(qint64 now_ns);
+
+private:
+    /**
+     * @brief Добавляет маркеры, накопившиеся с прошлого пополнения
+     * @param now_ns Текущий момент, нс
+     */
+    void refill(qint64 now_ns);
+
+    double rate = 0;       ///< Маркеров в секунду (0 - без ограничения)
+    double burst = 1;      ///< Ёмкость корзины
+    double tokens = 1;     ///< Накопленные маркеры
+    qint64 last_ns = -1;   ///< Момент последнего пополнения (-1 - ещё не пополнялась)
+};
+
+#endif // TOKEN_BUCKET_H
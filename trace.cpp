@@ -0,0 +1,279 @@
+#include "trace.h"
+#include <QCoreApplication>
+#include <QMutex>
+#include <QThread>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+
+/// Размер буфера событий, после которого он дописывается в файл, байт
+#define TRACE_FLUSH_BYTES (64 * 1024)
+
+/**
+ * @brief Состояние трассировки
+ *
+ * Создаётся при первом событии и не удаляется, чтобы события
+ * деструкторов статических объектов не обращались к удалённому буферу.
+ */
+struct trace_state {
+    QMutex lock;                          ///< Защита buffer и file
+    QByteArray buffer;                    ///< События, ещё не записанные в файл
+    std::FILE* file = nullptr;            ///< Файл трассировки (пустой - не открылся)
+    bool first = true;                    ///< Следующее событие - первое в массиве
+    qint64 pid = 0;                       ///< Идентификатор процесса
+    std::atomic<int> next_thread{1};      ///< Номер следующего потока
+};
+
+/**
+ * @brief Возвращает начало отсчёта времени трассировки
+ * @return Момент первого обращения
+ */
+static std::chrono::steady_clock::time_point epoch() {
+    static const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    return start;
+}
+
+/**
+ * @brief Завершает массив событий при завершении программы
+ */
+static void finish();
+
+/**
+ * @brief Возвращает состояние трассировки, открывая файл при первом вызове
+ * @return Состояние
+ */
+static trace_state* state() {
+    static trace_state* instance = []() {
+        trace_state* created = new trace_state;
+        created->file = std::fopen(qgetenv(TRACE_ENVIRONMENT).constData(), "w");
+        created->pid = QCoreApplication::applicationPid();
+        if (created->file != nullptr) {
+            std::fputs("[\n", created->file);
+            std::atexit(finish);
+        }
+        return created;
+    }();
+    return instance;
+}
+
+/**
+ * @brief Добавляет событие в буфер
+ * @param log Состояние трассировки
+ * @param event Объект события в JSON
+ */
+static void append(trace_state* log, const QByteArray& event) {
+    QMutexLocker locker(&log->lock);
+    if (log->file == nullptr)
+        return;
+    if (!log->first)
+        log->buffer.append(",\n");
+    log->first = false;
+    log->buffer.append(event);
+    if (log->buffer.size() >= TRACE_FLUSH_BYTES) {
+        std::fwrite(log->buffer.constData(), 1, std::size_t(log->buffer.size()), log->file);
+        log->buffer.clear();
+    }
+}
+
+/**
+ * @brief Возвращает номер дорожки текущего потока
+ * @return Номер tid
+ *
+ * При первом событии потока записывается его имя: имя QThread
+ * (сетевой поток Client называется "network") или "main".
+ */
+static int thread_track() {
+    thread_local int track = 0;
+    if (track != 0)
+        return track;
+    trace_state* log = state();
+    track = log->next_thread.fetch_add(1);
+    QString name = QThread::currentThread()->objectName();
+    if (name.isEmpty()) {
+        QCoreApplication* application = QCoreApplication::instance();
+        bool is_main = application != nullptr and QThread::currentThread() == application->thread();
+        name = is_main ? QString("main") : QString("thread %1").arg(track);
+    }
+    append(log, "{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":" + QByteArray::number(log->pid) + ",\"tid\":"
+                    + QByteArray::number(track) + ",\"args\":{\"name\":\"" + name.toUtf8() + "\"}}");
+    return track;
+}
+
+/**
+ * @brief Формирует начало объекта события
+ * @param phase Вид события ("X", "i", "b", "e")
+ * @param name Название
+ * @param category Категория
+ * @param ts_ns Время события
+ * @return Поля ph, name, cat, ts, pid и tid без закрывающей скобки
+ */
+static QByteArray event_head(const char* phase, const char* name, const char* category, qint64 ts_ns) {
+    trace_state* log = state();
+    return "{\"ph\":\"" + QByteArray(phase) + "\",\"name\":\"" + name + "\",\"cat\":\"" + category + "\",\"ts\":"
+           + QByteArray::number(ts_ns / 1000.0, 'f', 3) + ",\"pid\":" + QByteArray::number(log->pid)
+           + ",\"tid\":" + QByteArray::number(thread_track());
+}
+
+/**
+ * @brief Завершает массив событий при завершении программы
+ */
+static void finish() {
+    trace_state* log = state();
+    QMutexLocker locker(&log->lock);
+    log->buffer.append("\n]\n");
+    std::fwrite(log->buffer.constData(), 1, std::size_t(log->buffer.size()), log->file);
+    log->buffer.clear();
+    std::fclose(log->file);
+    log->file = nullptr;
+}
+
+/**
+ * @brief Проверяет, включена ли трассировка
+ * @return true если задана переменная окружения SOLVER_TRACE_FILE
+ */
+bool trace::enabled() {
+    static const bool on = !qgetenv(TRACE_ENVIRONMENT).isEmpty();
+    return on;
+}
+
+/**
+ * @brief Возвращает время трассировки
+ * @return Наносекунды от первого обращения к трассировке
+ */
+qint64 trace::now_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - epoch()).count();
+}
+
+/**
+ * @brief Записывает отрезок на дорожке текущего потока
+ * @param name Название (строковый литерал)
+ * @param category Категория (строковый литерал)
+ * @param start_ns Начало по now_ns
+ * @param args Поля объекта args в JSON без скобок (например, "request":5)
+ */
+void trace::complete(const char* name, const char* category, qint64 start_ns, const QByteArray& args) {
+    if (!trace::enabled())
+        return;
+    qint64 end_ns = trace::now_ns();
+    QByteArray event = event_head("X", name, category, start_ns);
+    event += ",\"dur\":" + QByteArray::number((end_ns - start_ns) / 1000.0, 'f', 3);
+    if (!args.isEmpty())
+        event += ",\"args\":{" + args + '}';
+    append(state(), event + '}');
+}
+
+/**
+ * @brief Записывает мгновенное событие на дорожке текущего потока
+ * @param name Название (строковый литерал)
+ * @param category Категория (строковый литерал)
+ * @param args Поля объекта args в JSON без скобок
+ */
+void trace::instant(const char* name, const char* category, const QByteArray& args) {
+    if (!trace::enabled())
+        return;
+    QByteArray event = event_head("i", name, category, trace::now_ns()) + ",\"s\":\"t\"";
+    if (!args.isEmpty())
+        event += ",\"args\":{" + args + '}';
+    append(state(), event + '}');
+}
+
+/**
+ * @brief Начинает асинхронный отрезок запроса
+ * @param name Название (строковый литерал, то же в async_end)
+ * @param id Идентификатор запроса
+ * @param start_ns Начало по now_ns (по умолчанию - сейчас)
+ */
+void trace::async_begin(const char* name, quint32 id, qint64 start_ns) {
+    if (!trace::enabled())
+        return;
+    QByteArray event = event_head("b", name, "request", start_ns >= 0 ? start_ns : trace::now_ns());
+    append(state(), event + ",\"id\":" + QByteArray::number(id) + ",\"args\":{\"request\":" + QByteArray::number(id)
+                        + "}}");
+}
+
+/**
+ * @brief Завершает асинхронный отрезок запроса
+ * @param name Название, переданное в async_begin
+ * @param id Идентификатор запроса
+ */
+void trace::async_end(const char* name, quint32 id) {
+    if (!trace::enabled())
+        return;
+    append(state(), event_head("e", name, "request", trace::now_ns()) + ",\"id\":" + QByteArray::number(id) + '}');
+}
+
+/**
+ * @brief Записывает мгновенное событие на дорожке асинхронного отрезка запроса
+ * @param name Название (строковый литерал)
+ * @param id Идентификатор запроса
+ */
+void trace::async_instant(const char* name, quint32 id) {
+    if (!trace::enabled())
+        return;
+    append(state(), event_head("n", name, "request", trace::now_ns()) + ",\"id\":" + QByteArray::number(id) + '}');
+}
+
+/**
+ * @brief Дописывает накопленные события в файл
+ */
+void trace::flush() {
+    if (!trace::enabled())
+        return;
+    trace_state* log = state();
+    QMutexLocker locker(&log->lock);
+    if (log->file == nullptr)
+        return;
+    std::fwrite(log->buffer.constData(), 1, std::size_t(log->buffer.size()), log->file);
+    std::fflush(log->file);
+    log->buffer.clear();
+}
+
+/**
+ * @brief Начинает отрезок
+ * @param name Название (строковый литерал)
+ * @param category Категория (строковый литерал)
+ */
+trace_span::trace_span(const char* name, const char* category) :
+    name(name),
+    category(category),
+    start_ns(trace::enabled() ? trace::now_ns() : -1)
+{}
+
+/**
+ * @brief Записывает отрезок
+ */
+trace_span::~trace_span() {
+    if (this->start_ns >= 0)
+        trace::complete(this->name, this->category, this->start_ns, this->args);
+}
+
+/**
+ * @brief Привязывает отрезок к запросу
+ * @param id Идентификатор запроса (0 - не привязывать)
+ */
+void trace_span::set_request(quint32 id) {
+    if (id != 0)
+        this->add_arg("request", id);
+}
+
+/**
+ * @brief Добавляет поле в args отрезка
+ * @param key Имя поля (строковый литерал)
+ * @param value Значение
+ */
+void trace_span::add_arg(const char* key, qint64 value) {
+    if (this->start_ns < 0)
+        return;
+    if (!this->args.isEmpty())
+        this->args += ',';
+    this->args += '"' + QByteArray(key) + "\":" + QByteArray::number(value);
+}
+
+/**
+ * @brief Возвращает начало отрезка
+ * @return Начало по trace::now_ns (-1 - трассировка выключена)
+ */
+qint64 trace_span::start() const {
+    return this->start_ns;
+}
@@ -0,0 +1,140 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <QByteArray>
+#include <QtGlobal>
+
+/// Переменная окружения с путём файла трассировки; без неё трассировка выключена
+#define TRACE_ENVIRONMENT "SOLVER_TRACE_FILE"
+
+/**
+ * @brief Трассировка запросов в формате Chrome trace_event
+ *
+ * События пишутся в файл из SOLVER_TRACE_FILE массивом JSON
+ * (открывается в Perfetto и chrome://tracing): отрезки ("ph":"X") на
+ * дорожке потока, мгновенные события ("ph":"i") и асинхронные отрезки
+ * ("ph":"b"/"e") с мгновенными событиями внутри них ("ph":"n"), которые
+ * собирают путь одного запроса на отдельной дорожке по его
+ * идентификатору. Время - микросекунды от запуска
+ * процесса по монотонным часам, поэтому события потока интерфейса и
+ * сетевого потока сопоставимы.
+ *
+ * Без переменной окружения каждая точка трассировки сводится к
+ * проверке enabled. События копятся в буфере под мьютексом и
+ * дописываются в файл порциями и при завершении программы.
+ */
+class trace
+{
+private:
+    trace() = delete;             ///< Запрет создания экземпляров
+    trace(const trace&) = delete; ///< Запрет копирования
+    ~trace() = delete;            ///< Запрет удаления
+
+public:
+    /**
+     * @brief Проверяет, включена ли трассировка
+     * @return true если задана переменная окружения SOLVER_TRACE_FILE
+     */
+    static bool enabled();
+
+    /**
+     * @brief Возвращает время трассировки
+     * @return Наносекунды от первого обращения к трассировке
+     */
+    static qint64 now_ns();
+
+    /**
+     * @brief Записывает отрезок на дорожке текущего потока
+     * @param name Название (строковый литерал)
+     * @param category Категория (строковый литерал)
+     * @param start_ns Начало по now_ns
+     * @param args Поля объекта args в JSON без скобок (например, "request":5)
+     */
+    static void complete(const char* name, const char* category, qint64 start_ns, const QByteArray& args = QByteArray());
+
+    /**
+     * @brief Записывает мгновенное событие на дорожке текущего потока
+     * @param name Название (строковый литерал)
+     * @param category Категория (строковый литерал)
+     * @param args Поля объекта args в JSON без скобок
+     */
+    static void instant(const char* name, const char* category, const QByteArray& args = QByteArray());
+
+    /**
+     * @brief Начинает асинхронный отрезок запроса
+     * @param name Название (строковый литерал, то же в async_end)
+     * @param id Идентификатор запроса
+     * @param start_ns Начало по now_ns (по умолчанию - сейчас)
+     */
+    static void async_begin(const char* name, quint32 id, qint64 start_ns = -1);
+
+    /**
+     * @brief Завершает асинхронный отрезок запроса
+     * @param name Название, переданное в async_begin
+     * @param id Идентификатор запроса
+     */
+    static void async_end(const char* name, quint32 id);
+
+    /**
+     * @brief Записывает мгновенное событие на дорожке асинхронного отрезка запроса
+     * @param name Название (строковый литерал)
+     * @param id Идентификатор запроса
+     */
+    static void async_instant(const char* name, quint32 id);
+
+    /**
+     * @brief Дописывает накопленные события в файл
+     */
+    static void flush();
+};
+
+/**
+ * @brief Отрезок трассировки от создания до удаления объекта
+ *
+ * Если трассировка выключена, объект ничего не делает.
+ */
+class trace_span
+{
+public:
+    /**
+     * @brief Начинает отрезок
+     * @param name Название (строковый литерал)
+     * @param category Категория (строковый литерал)
+     */
+    trace_span(const char* name, const char* category);
+
+    /**
+     * @brief Записывает отрезок
+     */
+    ~trace_span();
+
+    trace_span(const trace_span&) = delete;            ///< Запрет копирования
+    trace_span& operator=(const trace_span&) = delete; ///< Запрет присваивания
+
+    /**
+     * @brief Привязывает отрезок к запросу
+     * @param id Идентификатор запроса (0 - не привязывать)
+     */
+    void set_request(quint32 id);
+
+    /**
+     * @brief Добавляет поле в args отрезка
+     * @param key Имя поля (строковый литерал)
+     * @param value Значение
+     */
+    void add_arg(const char* key, qint64 value);
+
+    /**
+     * @brief Возвращает начало отрезка
+     * @return Начало по trace::now_ns (-1 - трассировка выключена)
+     */
+    qint64 start() const;
+
+private:
+    const char* name;     ///< Название
+    const char* category; ///< Категория
+    qint64 start_ns = -1; ///< Начало (-1 - трассировка выключена)
+    QByteArray args;      ///< Поля args
+};
+
+#endif // TRACE_H
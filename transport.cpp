@@ -0,0 +1,232 @@
+#include "transport.h"
+
+/**
+ * @brief Создаёт соединение нужного вида
+ * @param type Вид соединения
+ * @param parent Родительский объект
+ * @return Новое неподключённое соединение
+ */
+transport* transport::create(endpoint::kind type, QObject* parent) {
+    if (type == endpoint::kind::LOCAL)
+        return new local_transport(parent);
+    return new tcp_transport(parent);
+}
+
+/**
+ * @brief Конструктор соединения
+ * @param parent Родительский объект
+ */
+transport::transport(QObject* parent) :
+    QObject(parent)
+{}
+
+/**
+ * @brief Конструктор TCP-соединения
+ * @param parent Родительский объект
+ */
+tcp_transport::tcp_transport(QObject* parent) :
+    transport(parent),
+    socket(new QTcpSocket(this))
+{
+    connect(this->socket, &QTcpSocket::connected, this, &transport::connected);
+    connect(this->socket, &QTcpSocket::disconnected, this, &transport::disconnected);
+    connect(this->socket, &QTcpSocket::readyRead, this, &transport::ready_read);
+    connect(this->socket, &QTcpSocket::bytesWritten, this, &transport::bytes_written);
+    connect(this->socket, &QTcpSocket::errorOccurred, this, &transport::error_occurred);
+}
+
+/**
+ * @brief Возвращает вид соединения
+ * @return endpoint::kind::TCP
+ */
+endpoint::kind tcp_transport::type() const {
+    return endpoint::kind::TCP;
+}
+
+/**
+ * @brief Начинает подключение по TCP
+ * @param address Адрес сервера
+ */
+void tcp_transport::open(const endpoint& address) {
+    this->socket->connectToHost(address.host, address.port);
+}
+
+/**
+ * @brief Применяет параметры сокета к установленному соединению
+ * @param options Параметры сокета
+ *
+ * Без TCP_NODELAY маленькие запросы задерживаются алгоритмом Нейгла
+ * до подтверждения предыдущих, а подтверждения сервер откладывает
+ * (delayed ACK), что добавляет десятки миллисекунд к ответу.
+ */
+void tcp_transport::configure(const socket_options& options) {
+    this->socket->setSocketOption(QAbstractSocket::LowDelayOption, options.low_delay ? 1 : 0);
+    this->socket->setSocketOption(QAbstractSocket::KeepAliveOption, options.keep_alive ? 1 : 0);
+    if (options.send_buffer > 0)
+        this->socket->setSocketOption(QAbstractSocket::SendBufferSizeSocketOption, options.send_buffer);
+    if (options.receive_buffer > 0)
+        this->socket->setSocketOption(QAbstractSocket::ReceiveBufferSizeSocketOption, options.receive_buffer);
+}
+
+/**
+ * @brief Проверяет, установлено ли соединение
+ * @return true если можно писать
+ */
+bool tcp_transport::is_open() const {
+    return this->socket->state() == QAbstractSocket::ConnectedState;
+}
+
+/**
+ * @brief Записывает данные в буфер отправки
+ * @param data Данные
+ * @return Количество принятых байт или -1 при ошибке
+ */
+qint64 tcp_transport::write(const QByteArray& data) {
+    return this->socket->write(data);
+}
+
+/**
+ * @brief Немедленно передаёт буфер отправки операционной системе
+ */
+void tcp_transport::flush() {
+    this->socket->flush();
+}
+
+/**
+ * @brief Читает все полученные данные
+ * @return Данные
+ */
+QByteArray tcp_transport::read_all() {
+    return this->socket->readAll();
+}
+
+/**
+ * @brief Возвращает количество полученных, но не прочитанных байт
+ * @return Количество байт
+ */
+qint64 tcp_transport::bytes_available() const {
+    return this->socket->bytesAvailable();
+}
+
+/**
+ * @brief Возвращает количество записанных, но ещё не переданных системе байт
+ * @return Размер буфера отправки QTcpSocket, байт
+ */
+qint64 tcp_transport::bytes_to_write() const {
+    return this->socket->bytesToWrite();
+}
+
+/**
+ * @brief Корректно закрывает соединение
+ */
+void tcp_transport::close() {
+    this->socket->close();
+}
+
+/**
+ * @brief Немедленно разрывает соединение
+ */
+void tcp_transport::abort() {
+    this->socket->abort();
+}
+
+/**
+ * @brief Конструктор соединения через локальный сокет
+ * @param parent Родительский объект
+ */
+local_transport::local_transport(QObject* parent) :
+    transport(parent),
+    socket(new QLocalSocket(this))
+{
+    connect(this->socket, &QLocalSocket::connected, this, &transport::connected);
+    connect(this->socket, &QLocalSocket::disconnected, this, &transport::disconnected);
+    connect(this->socket, &QLocalSocket::readyRead, this, &transport::ready_read);
+    connect(this->socket, &QLocalSocket::bytesWritten, this, &transport::bytes_written);
+    connect(this->socket, &QLocalSocket::errorOccurred, this, &transport::error_occurred);
+}
+
+/**
+ * @brief Возвращает вид соединения
+ * @return endpoint::kind::LOCAL
+ */
+endpoint::kind local_transport::type() const {
+    return endpoint::kind::LOCAL;
+}
+
+/**
+ * @brief Начинает подключение к локальному сокету
+ * @param address Адрес сервера
+ */
+void local_transport::open(const endpoint& address) {
+    this->socket->connectToServer(address.name);
+}
+
+/**
+ * @brief Параметры TCP к локальному сокету неприменимы
+ * @param options Параметры сокета
+ */
+void local_transport::configure(const socket_options& options) {
+    Q_UNUSED(options);
+}
+
+/**
+ * @brief Проверяет, установлено ли соединение
+ * @return true если можно писать
+ */
+bool local_transport::is_open() const {
+    return this->socket->state() == QLocalSocket::ConnectedState;
+}
+
+/**
+ * @brief Записывает данные в буфер отправки
+ * @param data Данные
+ * @return Количество принятых байт или -1 при ошибке
+ */
+qint64 local_transport::write(const QByteArray& data) {
+    return this->socket->write(data);
+}
+
+/**
+ * @brief Немедленно передаёт буфер отправки операционной системе
+ */
+void local_transport::flush() {
+    this->socket->flush();
+}
+
+/**
+ * @brief Читает все полученные данные
+ * @return Данные
+ */
+QByteArray local_transport::read_all() {
+    return this->socket->readAll();
+}
+
+/**
+ * @brief Возвращает количество полученных, но не прочитанных байт
+ * @return Количество байт
+ */
+qint64 local_transport::bytes_available() const {
+    return this->socket->bytesAvailable();
+}
+
+/**
+ * @brief Возвращает количество записанных, но ещё не переданных системе байт
+ * @return Размер буфера отправки QLocalSocket, байт
+ */
+qint64 local_transport::bytes_to_write() const {
+    return this->socket->bytesToWrite();
+}
+
+/**
+ * @brief Корректно закрывает соединение
+ */
+void local_transport::close() {
+    this->socket->close();
+}
+
+/**
+ * @brief Немедленно разрывает соединение
+ */
+void local_transport::abort() {
+    this->socket->abort();
+}
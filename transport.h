@@ -0,0 +1,204 @@
+#ifndef TRANSPORT_H
+#define TRANSPORT_H
+
+#include <QObject>
+#include <QByteArray>
+#include <QTcpSocket>
+#include <QLocalSocket>
+#include "endpoint.h"
+
+/**
+ * @brief Параметры сокета
+ *
+ * Нулевой размер буфера оставляет значение операционной системы.
+ */
+struct socket_options {
+    bool low_delay = true;   ///< Отключить алгоритм Нейгла (TCP_NODELAY)
+    bool keep_alive = true;  ///< Проверять живость простаивающего соединения (SO_KEEPALIVE)
+    int send_buffer = 0;     ///< Размер буфера отправки ядра (SO_SNDBUF), байт
+    int receive_buffer = 0;  ///< Размер буфера приёма ядра (SO_RCVBUF), байт
+};
+
+/**
+ * @brief Потоковое соединение с сервером
+ *
+ * Сетевая часть клиента работает только через этот интерфейс и не
+ * зависит от вида сокета. Реализации: tcp_transport (QTcpSocket) и
+ * local_transport (QLocalSocket) - для сервера на той же машине, без
+ * стека TCP на петлевом интерфейсе.
+ */
+class transport : public QObject
+{
+    Q_OBJECT
+
+public:
+    /**
+     * @brief Создаёт соединение нужного вида
+     * @param type Вид соединения
+     * @param parent Родительский объект
+     * @return Новое неподключённое соединение
+     */
+    static transport* create(endpoint::kind type, QObject* parent = nullptr);
+
+    /**
+     * @brief Возвращает вид соединения
+     * @return Вид соединения
+     */
+    virtual endpoint::kind type() const = 0;
+
+    /**
+     * @brief Начинает подключение; по его завершении испускается connected()
+     * @param address Адрес сервера
+     */
+    virtual void open(const endpoint& address) = 0;
+
+    /**
+     * @brief Применяет параметры сокета к установленному соединению
+     * @param options Параметры сокета
+     */
+    virtual void configure(const socket_options& options) = 0;
+
+    /**
+     * @brief Проверяет, установлено ли соединение
+     * @return true если можно писать
+     */
+    virtual bool is_open() const = 0;
+
+    /**
+     * @brief Записывает данные в буфер отправки
+     * @param data Данные
+     * @return Количество принятых байт или -1 при ошибке
+     */
+    virtual qint64 write(const QByteArray& data) = 0;
+
+    /**
+     * @brief Немедленно передаёт буфер отправки операционной системе
+     *
+     * Без вызова данные уходят, когда цикл событий сообщит о готовности
+     * сокета к записи, то есть на следующей итерации.
+     */
+    virtual void flush() = 0;
+
+    /**
+     * @brief Читает все полученные данные
+     * @return Данные
+     */
+    virtual QByteArray read_all() = 0;
+
+    /**
+     * @brief Возвращает количество полученных, но не прочитанных байт
+     * @return Количество байт
+     */
+    virtual qint64 bytes_available() const = 0;
+
+    /**
+     * @brief Возвращает количество записанных, но ещё не переданных системе байт
+     * @return Размер буфера отправки сокета, байт
+     */
+    virtual qint64 bytes_to_write() const = 0;
+
+    /**
+     * @brief Корректно закрывает соединение
+     */
+    virtual void close() = 0;
+
+    /**
+     * @brief Немедленно разрывает соединение
+     */
+    virtual void abort() = 0;
+
+protected:
+    /**
+     * @brief Конструктор соединения
+     * @param parent Родительский объект
+     */
+    explicit transport(QObject* parent = nullptr);
+
+signals:
+    /**
+     * @brief Соединение установлено
+     */
+    void connected();
+
+    /**
+     * @brief Соединение разорвано
+     */
+    void disconnected();
+
+    /**
+     * @brief Получены данные
+     */
+    void ready_read();
+
+    /**
+     * @brief Часть буфера отправки передана операционной системе
+     */
+    void bytes_written();
+
+    /**
+     * @brief Ошибка сокета (в том числе неудачная попытка подключения)
+     */
+    void error_occurred();
+};
+
+/**
+ * @brief Соединение по TCP
+ */
+class tcp_transport : public transport
+{
+    Q_OBJECT
+
+public:
+    /**
+     * @brief Конструктор соединения
+     * @param parent Родительский объект
+     */
+    explicit tcp_transport(QObject* parent = nullptr);
+
+    endpoint::kind type() const override;
+    void open(const endpoint& address) override;
+    void configure(const socket_options& options) override;
+    bool is_open() const override;
+    qint64 write(const QByteArray& data) override;
+    void flush() override;
+    QByteArray read_all() override;
+    qint64 bytes_available() const override;
+    qint64 bytes_to_write() const override;
+    void close() override;
+    void abort() override;
+
+private:
+    QTcpSocket* socket; ///< Сокет
+};
+
+/**
+ * @brief Соединение через локальный сокет
+ */
+class local_transport : public transport
+{
+    Q_OBJECT
+
+public:
+    /**
+     * @brief Конструктор соединения
+     * @param parent Родительский объект
+     */
+    explicit local_transport(QObject* parent = nullptr);
+
+    endpoint::kind type() const override;
+    void open(const endpoint& address) override;
+    void configure(const socket_options& options) override;
+    bool is_open() const override;
+    qint64 write(const QByteArray& data) override;
+    void flush() override;
+    QByteArray read_all() override;
+    qint64 bytes_available() const override;
+    qint64 bytes_to_write() const override;
+    void close() override;
+    void abort() override;
+
+private:
+    QLocalSocket* socket; ///< Сокет
+};
+
+#endif // TRANSPORT_H